@@ -0,0 +1,29 @@
+// Interface details for GNC to the thruster valves.
+
+#ifndef __INC_ACTINTERFACE_H_
+#define __INC_ACTINTERFACE_H_
+
+#include "msgHeader.h"
+
+/* Thrusters per command. Same as maxNumActuators in config.h. */
+#define actMaxThrusters 12U
+
+typedef struct
+{
+    msgHeader_t hdr;                                //< Header of the sensor message that triggered it, seq is the command number.
+    uint32_t    srcSeq;                             //< Sample index of that sensor message.
+    uint32_t    sensor;                             //< Its sensorIn_e.
+    uint64_t    gncRx_ns;                           //< CLOCK_MONOTONIC when GNC received the sensor message.
+    uint64_t    sent_ns;                            //< CLOCK_MONOTONIC when the command was handed to the transport.
+    uint32_t    numActuators;
+    uint32_t    reserved;
+    double      duty[actMaxThrusters];              //< Fraction of the control period each thruster fires.
+} actCmd_t;
+
+typedef union
+{
+    actCmd_t data;
+    uint8_t  dataBuf[sizeof(actCmd_t)];
+} actCmd_u;
+
+#endif  // __INC_ACTINTERFACE_H_
@@ -0,0 +1,49 @@
+// Implements the thruster valve end of the GNC actuator commands.
+
+#ifndef __INC_ACTUATORSINK_H_
+#define __INC_ACTUATORSINK_H_
+
+#include "config.h"
+#include "actInterface.h"
+#include "interfaceLib.h"
+#include "latencyLib.h"
+
+/* Default time from a command to the valves having moved. */
+#define sinkValveLatencyDefault_us 5000U
+
+/* Commands on their way through the valves. More than this in flight are applied early and counted. */
+#define sinkMaxInFlight 4096U
+
+/* Command waiting for its valve latency to pass. */
+typedef struct
+{
+    uint64_t due_ns;                                //< CLOCK_MONOTONIC the valves follow it at.
+    uint64_t rx_ns;
+    actCmd_t cmd;
+} sinkPending_t;
+
+/* Sink side latency per triggering sensor, in the order a command passes them. */
+typedef enum
+{
+    sinkLatGnc   = 0,                               //< GNC receive to command sent.
+    sinkLatLink  = 1,                               //< Command sent to received here.
+    sinkLatValve = 2,                               //< Received to valves moved, the simulated latency plus timer lateness.
+    sinkLatTotal = 3,                               //< Sensor read to valves moved, the closed loop.
+    numSinkLat   = 4
+} sinkLatSpan_e;
+
+/* Command stream continuity. */
+typedef struct
+{
+    uint64_t   numRx;
+    uint64_t   numGaps;                             //< Sequence jumps.
+    uint64_t   numMissing;                          //< Commands skipped by those jumps.
+    uint64_t   numStale;                            //< Duplicated or reordered, older than the newest seen.
+    uint64_t   numOverflow;                         //< Applied before their latency passed, pending queue full.
+    uint32_t   nextSeq;
+    uint64_t   firstRx_ns;
+    uint64_t   lastRx_ns;
+    timeHist_t interArrival;                        //< Wall time between consecutive commands.
+} sinkStream_t;
+
+#endif  // __INC_ACTUATORSINK_H_
@@ -4,24 +4,127 @@
 #ifndef __INC_GNC_H_
 #define __INC_GNC_H_
 #include <stdint.h>
+#include "interfaceLib.h"
 #include "config.h"
+#include "actInterface.h"
+#include "arenaLib.h"
+#include "eventLoopLib.h"
+#include "latencyLib.h"
+#include "latestLib.h"
+#include "lockstepLib.h"
+#include "navFilterLib.h"
+#include "telemLib.h"
+#include "threadLib.h"
 
 /* Actuator State. */
 typedef struct
 {
-    int actuatorState[6];
+    unsigned int numActuators;
+    int          actuatorState[maxNumActuators];    //< 1 when the thruster fires in this control period.
+    double       duty[maxNumActuators];             //< Fraction of the control period it fires.
 } actuatorData_t;
 
-/* Init Function Prototype */
-int gncInit();
+/* One GNC sensor input. Its channel and the last message received on it. */
+typedef struct
+{
+    ipcConfig_t  cfg;
+    sensorMsg_u  msg;
+    struct gncStage* owner;         //< Event context handed back by the loop.
+    sensorIn_e   sensor;
+    uint32_t     lastGen;           //< Publications of the latest table already acted on.
+    uint32_t     numSkipped;        //< Publications overwritten before a step read them.
+    uint64_t     numRx;             //< Messages acted on.
+    uint8_t      ready;             //< Signalled and not yet drained.
+} gncInput_t;
+
+typedef struct
+{
+    uint8_t           useLatest;                    //< Each step reads the latest voted samples from the FDIR table.
+    uint8_t           lockstep;                     //< Inputs drained and steps run per lockstep tick.
+    uint8_t           backpressure;                 //< Actuator commands wait for ring space, as with TEC_IPC_BACKPRESSURE.
+    uint8_t           stepped;                      //< No timer or console output, see stepGncStage.
+    enum ipcTransport transport;                    //< Sensor inputs. IPC_DEFAULT follows TEC_IPC_TRANSPORT.
+    enum ipcTransport actTransport;                 //< Actuator commands, likewise.
+    const rigConfig_t* rig;                         //< Copied. NULL loads the rig of TEC_RIG_CONFIG.
+    const thrAlloc_t* thr;                          //< Copied. NULL solves and prints the thruster allocation.
+} gncCfg_t;
+
+/* The GNC stage. Everything runs on the thread that calls gncRun. */
+typedef struct gncStage
+{
+    gncCfg_t         cfg;
+    eventLoop_t      loop;
+    arena_t          arena;                         //< Inputs and navigation history, sized once the rig is known.
+    gncInput_t*      inputs;
+    latestTable_t*   latest;                        //< useLatest only.
+    lockstepMember_t stepMember;                    //< Lockstep only.
+    latencyTable_t   latency;                       //< Transport from the previous hop, receive to actuate, total.
+
+    /* 
+     * Navigation, see navFilterLib.h. Started from the GNSS position and velocity and the star tracker attitude
+     * once both arrived.
+     */
+    navFilter_t      nav;
+    timeHist_t       navCycle;                      //< Wall time per IMU step, filter included.
+    timeHist_t       navUpdate;                     //< Wall time per measurement update.
+    timeHist_t       navRewind;                     //< Wall time per rewind, replay included.
+
+    /* Thrusters and the last commanded states. The IMU rate is damped with gncRateGain. */
+    thrAlloc_t       thr;
+    actuatorData_t   act;
+    vec3_t           rate_rad_s;
+    timeHist_t       allocCycle;                    //< Wall time per allocation.
+
+    /* Commands to the thruster valves. Never blocks GNC, a full channel drops the command. */
+    ipcConfig_t      actOut;
+    actCmd_u         cmd;
+    uint32_t         actSeq;
+    uint64_t         actDropped;
+
+    /* Sensor messages handled since the last GNC step, and the input the next drain round starts at. */
+    unsigned int     rxSinceStep;
+    unsigned int     nextInput;
+    uint64_t         nextStep_ns;                   //< Scenario time of the next step, lockstep or stepped.
+    unsigned int     idleSteps;
+    unsigned int     timeOutCtr;
+
+    /* Telemetry events of the control loop. */
+    int              actOnEvent;
+    int              actOffEvent;
+    int              timeoutEvent;
+} gncStage_t;
+
+/* Streaming inputs, free running. */
+void initGncCfg(gncCfg_t* cfg);
+
+/* Init Function Prototype. Opens the channels and sets up the loop, or joins the lockstep run. */
+int gncInit(gncStage_t* gnc, const gncCfg_t* cfg);
 
 /* Step Function Prototype */
-void gncStep();
+void gncStep(gncStage_t* gnc);
+
+/*
+ * Lockstep or stepped: take every queued input in sensor order, then run the GNC steps due before tickEnd_ns,
+ * in scenario time. Runs on the calling thread.
+ */
+void stepGncStage(gncStage_t* gnc, uint64_t tickEnd_ns);
+
+/* Run the loop on the calling thread until gncStop, or in lockstep until the run ends. */
+int gncRun(gncStage_t* gnc);
+
+/* Safe from any thread. The loop ends at its next wakeup, at most one GNC step away. */
+void gncStop(gncStage_t* gnc);
+
+/* Latency table. */
+void printGncStats(gncStage_t* gnc);
+
+/* Termintae Function Prototype. Prints the report and frees the stage. */
+int gncTerminate(gncStage_t* gnc);
 
-/* Termintae Function Prototype */
-int gncTerminate();
+/* Close the channels and free the stage, without a report. */
+void closeGncStage(gncStage_t* gnc);
 
-/* GNC Compute Output. */
-void gncActuate(sensorIn_e sensor, actuatorData_t* actDat);
+/* GNC Compute Output. Returns received message size, -1 when no input is pending. */
+int gncActuate(gncStage_t* gnc, sensorIn_e sensor, actuatorData_t* actDat);
 
 #endif  // __INC_GNC_H_
\ No newline at end of file
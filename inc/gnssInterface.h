@@ -1,7 +1,10 @@
 // Interface details for GNSS Sensor to GNC.
 
+#include "msgHeader.h"
+
 typedef struct
 {
+    msgHeader_t hdr;
     double positionGd_m[3];
     double velocityEnu_m_s[3];
     double DOP;
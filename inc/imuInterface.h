@@ -1,7 +1,10 @@
 // Interface Details for IMU Sensor to GNC.
 
+#include "msgHeader.h"
+
 typedef struct
 {
+    msgHeader_t hdr;
     double velInc[3];
     double angInc[3];
     double tInc;
@@ -0,0 +1,126 @@
+// In-process Monte Carlo campaign over the scenario. Each run drives the sensor, FDIR and GNC stages of
+// SensorsOut, FdirHandler and GncMain on its worker thread, stepped in scenario time over in-process channels
+// on ports of the worker. No sockets, no sleeps. Runs are independent and spread over a work stealing pool,
+// every worker keeps its own stages and summary so runs share nothing but the read only data.
+
+#ifndef __INC_MONTECARLO_H_
+#define __INC_MONTECARLO_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "config.h"
+#include "interfaceLib.h"
+#include "faultLib.h"
+#include "actInterface.h"
+#include "sensors.h"
+#include "sensorFdir.h"
+#include "gnc.h"
+#include "poolLib.h"
+#include "threadLib.h"
+
+#define mcDefaultRuns     1000U
+#define mcMaxUnits        8U
+/* IMU and GNSS channels, or the star tracker quaternion. */
+#define mcMaxChannels     6U
+
+/* In-process ports of worker w start at mcPortBase + w * mcPortsPerWorker: units, then GNC, then actuators. */
+#define mcPortBase        20000U
+#define mcPortsPerWorker  (numGncSensorIf * (mcMaxUnits + 1U) + 1U)
+
+/* Measurement noise of every unit as a fraction of the residual detector sigma, star tracker per component. */
+#define mcNoiseFrac       0.5
+#define mcStrNoise        1e-3
+
+/* An injected fault starts between these fractions of the scenario and lasts to the end. */
+#define mcOnsetMin        0.1
+#define mcOnsetMax        0.6
+
+/* Per run figures summarised over the campaign. */
+typedef enum
+{
+    mcNavErrMax   = 0,                              //< Largest GNSS innovation, m.
+    mcNavErrLast  = 1,                              //< GNSS innovation at the end, m.
+    mcNavGated    = 2,                              //< Updates rejected by the innovation gate.
+    mcNavRewinds  = 3,
+    mcImpulse     = 4,                              //< Thruster impulse, N s.
+    mcFalseIso    = 5,                              //< Units isolated without a fault.
+    mcMissed      = 6,                              //< Frames closed without a unit, over all units.
+    mcRunTime     = 7,                              //< Wall time of the run, ms.
+    numMcMetrics  = 8
+} mcMetric_e;
+
+/* Streaming mean and variance (Welford), merged across workers. */
+typedef struct
+{
+    uint64_t n;
+    double   mean;
+    double   m2;
+    double   min;
+    double   max;
+} mcStat_t;
+
+typedef struct
+{
+    uint64_t numRuns;
+    uint64_t numFalseRuns;                          //< Runs with at least one false isolation.
+    mcStat_t metric[numMcMetrics];
+    uint64_t numInjected[numFaultKinds];
+    uint64_t numDetected[numFaultKinds];            //< Faulted unit isolated after the onset.
+    mcStat_t detectLat[numFaultKinds];              //< Onset to isolation, s.
+} mcSummary_t;
+
+/* State of one worker, reused run after run. */
+typedef struct
+{
+    rigConfig_t    rig;                             //< Campaign rig on the ports of the worker.
+    faultScript_t  script;
+    sensStage_t    sens;
+    fdirStage_t    fdir;
+    gncStage_t     gnc;
+    ipcConfig_t    actIn;                           //< Commands of the run's GNC.
+    actCmd_u       cmd;
+    uint64_t       now_ns;                          //< Scenario time delivered up to.
+    uint64_t       end_ns;
+    double         force_N;                         //< Summed thrust of the current command.
+    uint64_t       control_ns;                      //< Scenario time of the current command.
+    double         impulse_Ns;
+    mcSummary_t    sum;
+} mcWorker_t;
+
+/* Dispersions of one run, all drawn from its seed. */
+typedef struct
+{
+    uint64_t       seed;
+    unsigned int   numUnits[numGncSensorIf];
+    int            haveFault;
+    sensorIn_e     faultSensor;
+    fault_t        fault;
+} mcDispersion_t;
+
+typedef struct
+{
+    rigConfig_t    rig;
+    thrAlloc_t     thr;
+    double         noise[numGncSensorIf][mcMaxChannels];    //< Noise of every unit, 1 sigma per channel.
+    pool_t         pool;
+    mcWorker_t*    worker;                          //< One per pool worker.
+    uint64_t       numRuns;
+    uint64_t       seed;
+    double         faultProb;
+    unsigned int   minUnits;
+    unsigned int   maxUnits;
+    uint64_t       end_ns;                          //< Scenario time a run stops at.
+    FILE*          csv;                             //< Per run results, NULL for none.
+    _Atomic uint64_t numDone;
+    uint64_t       start_ns;
+} mcCampaign_t;
+
+/* Draw the dispersions of run index. The same seed and index give the same run on any worker. */
+void mcDisperse(const mcCampaign_t* mc, uint64_t index, mcDispersion_t* disp);
+
+/* Pool task, one complete run. */
+void mcRun(void* ctx, unsigned int worker, uint64_t index);
+
+void printMcSummary(mcCampaign_t* mc);
+
+#endif  // __INC_MONTECARLO_H_
@@ -0,0 +1,26 @@
+// Header carried at the start of every sensor message.
+
+#ifndef __INC_MSGHEADER_H_
+#define __INC_MSGHEADER_H_
+
+#include <stdint.h>
+
+/* Hops stamped on the way from the sensor file to GNC, in order. */
+typedef enum
+{
+    stampRead    = 0,                               //< Sensor row read.
+    stampSent    = 1,                               //< Handed to the sensor transport.
+    stampFdirIn  = 2,                               //< Received by FDIR.
+    stampFdirOut = 3,                               //< Forwarded by FDIR.
+    numMsgStamps = 4
+} msgStamp_e;
+
+typedef struct
+{
+    uint64_t simTime_ns;                            //< Scenario time the sample belongs to.
+    uint32_t seq;                                   //< Sample index within the sensor stream.
+    uint32_t reserved;
+    uint64_t stamp_ns[numMsgStamps];                //< CLOCK_MONOTONIC at each hop, 0 for hops not taken.
+} msgHeader_t;
+
+#endif  // __INC_MSGHEADER_H_
@@ -1,38 +1,162 @@
 // Implements Sensor FDIR Handling.
 
 #include "config.h"
+#include "arenaLib.h"
 #include "interfaceLib.h"
+#include "latencyLib.h"
+#include "latestLib.h"
+#include "lockstepLib.h"
+#include "threadLib.h"
+#include "voteLib.h"
+#include "residualLib.h"
+#include "telemLib.h"
 
-/* Static Memory Allocations. */
-ipcConfig_t imuMsgConf[maxNumImu];
-ipcConfig_t gnssMsgConf[maxNumGnss];
-ipcConfig_t strMsgConf[maxNumStrTrk];
+/* Deepest burst of queued samples taken from one unit in a single receive. */
+#define fdirMaxBurst 8U
 
-ipcConfig_t gncSendIpc[numGncSensorIf];
+/* Default time a frame waits for the other units after its first sample. */
+#define fdirDeadlineDefault_us 2000U
 
-/* Allocate buffer and Sensor data structures. */
-imuData_u    imuMsg[maxNumImu];
-gnssData_u   gnssMsg[maxNumGnss];
-strTrkData_u strMsg[maxNumStrTrk];
+/* Consecutive missed frames after which frames stop waiting for a unit, until it delivers again. */
+#define fdirSilentFrames 3U
 
-/* Receive counters */
-unsigned int rxImu  = 0;
-unsigned int rxGnss = 0;
-unsigned int rxStr  = 0;
+/* Samples received from one unit but not yet voted on. */
+typedef struct
+{
+    unsigned int count;
+    unsigned int next;
+    ssize_t      len[fdirMaxBurst];
+    sensorMsg_u  msg[fdirMaxBurst];
+} fdirBurst_t;
 
+/* Receive side of one redundant unit. The units of a sensor type sit next to each other in the arena. */
 typedef struct
 {
-    ipcConfig_t* inputCfg;
-    sensorIn_e   sensor;
-    unsigned int numSensors;
-    ipcConfig_t* outputCfg;
+    ipcConfig_t      inputCfg;
+    unsigned int     missRun;                       //< Consecutive frames closed without the unit.
+    _Atomic uint64_t numMissed;                     //< Frames closed without this unit.
+    _Atomic uint64_t numLate;                       //< Samples dropped because their frame had closed.
+    _Atomic uint64_t numMiscompare;                 //< Frames this unit failed the vote.
+    _Atomic uint32_t faults;                        //< Copy of resid.faults for the reporting thread.
+    uint64_t         isolated_ns;                   //< Sample time of the first fault, valid once faults is set.
+    residualUnit_t   resid;                         //< A unit with faults is isolated.
+    fdirBurst_t      burst;
+} fdirUnit_t;
+
+/* FDIR side latency, transport from the sensor and receive to forward. */
+typedef enum
+{
+    fdirLatLink = 0,
+    fdirLatVote = 1,
+    numFdirLat  = 2
+} fdirLatSpan_e;
+
+/* Latest voted sample per sensor type, one publishing thread each. */
+_Static_assert(sizeof(sensorMsg_u) <= latestSlotBytes, "Sensor message does not fit a latest table slot.");
+
+typedef struct
+{
+    double            deadline_us;                  //< Frame deadline after the first sample.
+    uint8_t           streamOut;                    //< Cleared when GNC reads the latest table instead.
+    uint8_t           lockstep;                     //< Each sensor thread is a member of the lockstep fdir stage.
+    uint8_t           backpressure;                 //< GNC outputs wait for ring space, as with TEC_IPC_BACKPRESSURE.
+    uint8_t           stepped;                      //< No threads, table or console output, see stepFdirStage.
+    enum ipcTransport transport;                    //< Unit inputs and GNC outputs. IPC_DEFAULT follows the env.
+    const rigConfig_t* rig;                         //< Copied. NULL loads and prints the rig of TEC_RIG_CONFIG.
+} fdirCfg_t;
+
+/* FDIR state of one sensor type, allocated with its units from the stage arena. */
+typedef struct
+{
+    struct fdirStage* owner;
+    sensorIn_e       sensor;
+    unsigned int     numSensors;
+    fdirUnit_t*      unit;                          //< numSensors units.
+    sensorMsg_u*     slot;                          //< Receive slots of the current frame, numSensors of them.
+    unsigned int*    rxUnit;                        //< Unit each receive slot came from.
+    voteFrame_t*     vote;                          //< NULL for sensors forwarded without voting.
+    ipcConfig_t*     outputCfg;
+    uint64_t         deadline_ns;                   //< A frame closes this long after its first sample.
+    uint32_t         lastSeq;                       //< Sample index of the last closed frame.
+    int              haveLast;
+    _Atomic uint64_t numFrames;
+    int              selectEvent;                   //< Telemetry of each forwarded frame.
+    lockstepMember_t step;                          //< Lockstep only.
 } taskArg_t;
 
+/* The FDIR stage. One thread per sensor type votes its units and forwards the result to GNC. */
+typedef struct fdirStage
+{
+    fdirCfg_t        cfg;
+    rigConfig_t      rig;
+    arena_t          arena;
+    taskArg_t*       arg[numGncSensorIf];
+    pthread_t        threads[numGncSensorIf];
+    latencyTable_t   latency;
+    latestTable_t*   latest;                        //< NULL when stepped.
+    _Atomic unsigned threadsDone;                   //< Lockstep threads that saw the run end.
+} fdirStage_t;
+
+/* 2 ms deadline, streaming to GNC, free running. */
+void initFdirCfg(fdirCfg_t* cfg);
+
+/* Rig, per sensor state and channels, latest table and lockstep membership. Starts no threads. */
+int initFdirStage(fdirStage_t* st, const fdirCfg_t* cfg);
+
+/*
+ * One thread per sensor type. They block on their inputs for good, except in lockstep where each raises
+ * SIGUSR2 in the process once the run ended. Block that signal in every thread before starting any stage.
+ */
+int startFdirStage(fdirStage_t* st);
+
+/*
+ * Stepped only: vote every frame queued on the unit inputs and forward it, on the calling thread. Like a
+ * lockstep tick, frames close on what is queued, so the caller runs it once the sensors sent up to a time.
+ */
+void stepFdirStage(fdirStage_t* st);
+
+/* Lockstep only: every thread saw the end of the run. */
+int fdirStageDone(fdirStage_t* st);
+
+/* Frame statistics of every sensor type and the FDIR latency. */
+void printFdirStage(fdirStage_t* st);
+
+/* Unlink the shared memory unit inputs at exit. The threads may still block on them, nothing is unmapped. */
+void releaseFdirStage(fdirStage_t* st);
+
+/* Stepped only: close the channels and free the stage. */
+void closeFdirStage(fdirStage_t* st);
+
+/* Arena bytes for one sensor type with numUnits units. */
+size_t fdirArenaSize(unsigned int numUnits);
+
+/* Carve one sensor type out of the stage arena and open its channels. NULL on failure. */
+taskArg_t* initFdirSensor(fdirStage_t* st, sensorIn_e sensor, uint64_t deadline_ns);
+
+/* Header of the oldest sample queued from a unit, NULL if none. Never blocks. */
+msgHeader_t* fdirPeekSample(taskArg_t* args, unsigned int unit);
+
+/* Take the oldest queued sample of a unit. Returns its length, -1 if none. Never blocks. */
+ssize_t fdirNextSample(taskArg_t* args, unsigned int unit, uint8_t* dataBuf, size_t dataBufSize);
+
+/* 
+ * Collect one frame, the samples of all units with the same sample index. Waits on every unit at once,
+ * and closes the frame when each unit delivered or moved past it, or deadline_ns after its first sample.
+ * Units silent for fdirSilentFrames frames are still taken but no longer waited for.
+ * Returns the number of samples, in receive slots 0..n-1. In lockstep the frame closes on what is queued,
+ * and 0 means nothing is.
+ */
+unsigned int fdirCollect(taskArg_t* args);
 
-void initFdirReadIpc(ipcConfig_t* cfg, uint16_t numSensors, uint16_t basePort);
+void printFdirStats(taskArg_t* args);
 
-void initGncSendIpc(ipcConfig_t* cfg, unsigned int numIf);
+/* Stamp the forward hop of the selected sample and record its time in FDIR. */
+void fdirStampOut(taskArg_t* args, msgHeader_t* hdr);
 
 void* fdirThread(void* args);
 
+/* 
+ * Vote over the received units that are not isolated, update the residual detectors of all of them,
+ * write the voted channels into the selected message and return its receive slot.
+ */
 unsigned int fdirSelect(taskArg_t* args, unsigned int numRx);
@@ -0,0 +1,88 @@
+// Sensor replay stage. Reads the scenario rows and sends each sample to the redundant units of FDIR, or straight
+// to GNC, on the multi-rate scheduler. SensorsOut runs the stage as a process, Pipeline as threads of one process.
+
+#ifndef __INC_SENSORS_H_
+#define __INC_SENSORS_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include "config.h"
+#include "interfaceLib.h"
+#include "schedLib.h"
+#include "latencyLib.h"
+#include "arenaLib.h"
+#include "faultLib.h"
+#include "lockstepLib.h"
+#include "telemLib.h"
+
+typedef struct
+{
+    double            replayScale;                  //< 1 is real time, 0 runs as fast as the consumers take it.
+    unsigned int      numWorkers;                   //< Scheduler threads. More than one are pinned, one per CPU.
+    const char*       faultPath;                    //< Fault script, see faultLib.h. NULL for none.
+    uint8_t           fdir;                         //< Every unit sends to FDIR, else one unit feeds GNC directly.
+    uint8_t           lockstep;                     //< Releases gated by the lockstep coordinator, not the clock.
+    enum ipcTransport transport;                    //< Outputs. IPC_DEFAULT follows TEC_IPC_TRANSPORT.
+    const rigConfig_t*   rig;                       //< Copied. NULL loads and prints the rig of TEC_RIG_CONFIG.
+    const faultScript_t* script;                    //< Copied, in place of faultPath. NULL for none.
+    const double*     noise[numGncSensorIf];        //< 1 sigma per channel on every unit, NULL for none.
+    uint64_t          seed;                         //< Noise and faults of sensor type i draw from seed + i + 1.
+} sensCfg_t;
+
+/* Replay state of one sensor type. */
+typedef struct sensStream sensStream_t;
+
+typedef struct
+{
+    sensCfg_t        cfg;
+    rigConfig_t      rig;
+    faultScript_t    script;
+    arena_t          arena;
+    sensStream_t*    stream;                        //< numGncSensorIf streams, from the arena.
+    sched_t          sch;
+    latencyTable_t   latency;                       //< Read to hand off and the hand off itself.
+    lockstepMember_t step;                          //< Lockstep only.
+    pthread_t        replay;
+    atomic_int       done;                          //< Set by the replay thread once every stream retired.
+    uint64_t         numSent;
+    uint64_t         start_ns;
+    uint64_t         end_ns;
+} sensStage_t;
+
+/* Real time, one scheduler thread, no faults or noise, straight to GNC. */
+void initSensCfg(sensCfg_t* cfg);
+
+/* Rig, fault script, data files and output channels. Starts no threads. Returns -1 on failure. */
+int initSensStage(sensStage_t* st, const sensCfg_t* cfg);
+
+/*
+ * Replay on a thread of its own. It raises SIGUSR2 in the process once out of data, so callers should block
+ * that signal in every thread before starting any stage.
+ */
+int startSensStage(sensStage_t* st);
+
+/*
+ * Replay on the calling thread, every release gated by gate instead of the clock, see schedGate_t. Outputs
+ * never wait for ring space, the gate is where the caller drains them. Returns samples sent.
+ */
+uint64_t runSensStage(sensStage_t* st, schedGate_t gate, void* ctx);
+
+/* End the replay early. Releases already due still go out. */
+void stopSensStage(sensStage_t* st);
+
+int sensStageDone(sensStage_t* st);
+
+/* Wait for the replay thread. Returns samples sent. */
+uint64_t joinSensStage(sensStage_t* st);
+
+/* Scheduler and latency statistics. */
+void printSensStats(sensStage_t* st);
+
+/* Final report after joinSensStage. */
+void printSensReport(sensStage_t* st);
+
+/* Close the channels and the data files. */
+void closeSensStage(sensStage_t* st);
+
+#endif  // __INC_SENSORS_H_
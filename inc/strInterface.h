@@ -1,7 +1,10 @@
 // Interface Details for Star Tracker to GNC.
 
+#include "msgHeader.h"
+
 typedef struct
 {
+    msgHeader_t hdr;
     double timeTag;
     double quaternion[4];
 } strTrkData_t;
@@ -0,0 +1,29 @@
+// Bump allocator. All per sensor state of a process comes from one block, laid out in the order it is
+// allocated, and is released in one go.
+#ifndef __LIBINC_ARENALIB_H_
+#define __LIBINC_ARENALIB_H_
+
+#include <stddef.h>
+
+/* Every allocation starts on its own cache line. */
+#define arenaAlign 64U
+
+typedef struct
+{
+    char*  base;
+    size_t size;
+    size_t used;
+} arena_t;
+
+/* Reserve size bytes. Returns -1 on failure. */
+int initArena(arena_t* arena, size_t size);
+
+/* Zeroed, arenaAlign aligned. NULL when the arena is exhausted. */
+void* arenaAlloc(arena_t* arena, size_t size);
+
+/* Bytes an allocation of size takes, for sizing the arena up front. */
+size_t arenaSizeOf(size_t size);
+
+void closeArena(arena_t* arena);
+
+#endif  // __LIBINC_ARENALIB_H_
@@ -0,0 +1,103 @@
+// Capture of IPC traffic. With capture open, every message sendMsgIPC or recvMsgIPC moves is appended to a file
+// mapped into memory, with its time, channel and direction. Writers reserve space with one atomic add and copy,
+// so a message costs no syscall. The file is a fixed size and prefaulted, a full file drops and counts. The
+// reader side maps a capture for the Replay tool.
+#ifndef __LIBINC_CAPTURELIB_H_
+#define __LIBINC_CAPTURELIB_H_
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* File size when TEC_CAPTURE_MB is not set. */
+#define captureDefault_MB 64U
+
+#define captureMagic      "TECCAPT1"
+#define captureVersion    1U
+
+/* Records start here, after the header. */
+#define captureDataOffset 128U
+
+typedef enum
+{
+    captureSend = 1,
+    captureRecv = 2
+} captureDir_e;
+
+/* File header. dataBytes and numDropped are set when the capture is closed, 0 bytes means it never was. */
+typedef struct
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t recHdrSize;
+    uint64_t start_ns;                              //< CLOCK_MONOTONIC when the capture was opened.
+    uint64_t dataBytes;                             //< Record bytes after captureDataOffset.
+    uint64_t numDropped;                            //< Messages that did not fit.
+    char     app[32];
+} captureHdr_t;
+
+_Static_assert(sizeof(captureHdr_t) <= captureDataOffset, "Capture header must fit before the records.");
+
+/* One message, its payload follows. Records are 8 byte aligned and in the order they were reserved. */
+typedef struct
+{
+    _Atomic uint32_t size;                          //< Record bytes, payload and padding included. Stored last.
+    uint16_t         port;                          //< Channel, the port both ends name it by.
+    uint8_t          dir;                           //< captureDir_e.
+    uint8_t          transport;                     //< enum ipcTransport of the channel.
+    uint64_t         time_ns;                       //< CLOCK_MONOTONIC when the message was sent or received.
+    uint32_t         len;                           //< Payload bytes.
+    uint32_t         reserved;
+} captureRec_t;
+
+_Static_assert(sizeof(captureRec_t) == 24, "Capture record header must stay 24 bytes.");
+
+/* Set while a capture is open. Read on every message, so kept apart from the rest of the state. */
+extern atomic_int captureActive;
+
+/*
+ * With TEC_CAPTURE_DIR set, create <dir>/<app>.cap of TEC_CAPTURE_MB megabytes and start capturing. Without
+ * it nothing is captured. Returns -1 if the file cannot be created.
+ */
+int openCapture(const char* app);
+
+/* Append one message. Use captureMsg, which skips the call while no capture is open. */
+void captureWrite(uint16_t port, captureDir_e dir, uint8_t transport, const void* data, size_t len);
+
+static inline void captureMsg(uint16_t port, captureDir_e dir, uint8_t transport, const void* data, ssize_t len)
+{
+    if ((len >= 0) && (atomic_load_explicit(&captureActive, memory_order_relaxed) != 0))
+    {
+        captureWrite(port, dir, transport, data, (size_t) len);
+    }
+}
+
+/* Stop capturing, waits for messages being copied, and trim the file to what was written. */
+void closeCapture(void);
+
+/* Messages and bytes captured and dropped. */
+void printCaptureStats(void);
+
+/* Capture mapped read only. */
+typedef struct
+{
+    void*               base;
+    size_t              size;
+    const captureHdr_t* hdr;
+    size_t              dataBytes;                  //< Up to the end of the file for a capture never closed.
+} captureMap_t;
+
+int mapCapture(const char* path, captureMap_t* map);
+
+/* Record after prev, the first for NULL. NULL at the end or at a record whose writer never finished it. */
+const captureRec_t* nextCaptureRec(const captureMap_t* map, const captureRec_t* prev);
+
+static inline const uint8_t* captureRecData(const captureRec_t* rec)
+{
+    return (const uint8_t *) (rec + 1);
+}
+
+int unmapCapture(captureMap_t* map);
+
+#endif  // __LIBINC_CAPTURELIB_H_
@@ -1,27 +1,35 @@
 // File contains all the IPC Address, Ports and Sensor Config.
+// Declarations only, the values live in libSrc/config.c so any number of stages can link into one binary.
 
 // () #
 #ifndef __LIBINC_CONFIG_H_
 #define __LIBINC_CONFIG_H_
 
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "imuInterface.h"
 #include "gnssInterface.h"
 #include "strInterface.h"
+#include "rigConfigLib.h"
+#include "thrusterLib.h"
+#include "residualLib.h"
+#include "navFilterLib.h"
 
 /* Constants for static allocation.  */
 // const unsigned int maxNumActuators = 12;
-// const unsigned int maxNumImu       =  4;
-// const unsigned int maxNumGnss      =  4;
-// const unsigned int maxNumStrTrk    =  4;
 
 /* Why can't gcc treat const as a compile time const ? Why do i have to resort to pre-processor directives. Sigh. */
 #define maxNumActuators 12U
-#define maxNumImu        4U
-#define maxNumGnss       4U
-#define maxNumStrTrk     4U 
 #define numGncSensorIf   3U
 
+/* Redundant units per sensor type a rig may describe. FDIR keeps unit sets in 32 bit masks. */
+#define maxUnitsPerSensor 32U
+
+/* Units per sensor type when the rig file does not say. Classic TMR. */
+#define defaultUnitsPerSensor 3U
+
 /* Number of inputs to GNC. */
 // const unsigned int numGncSensorIf  =  3;
 
@@ -32,6 +40,14 @@ typedef enum
     STK  = 2
 } sensorIn_e;
 
+/* Large enough for any sensor message. */
+typedef union
+{
+    imuData_u    imu;
+    gnssData_u   gnss;
+    strTrkData_u str;
+} sensorMsg_u;
+
 /* Sensor Configuration. */
 typedef struct
 {
@@ -41,63 +57,98 @@ typedef struct
 } sensorConfig_t;
 
 /* Constants for file Names. */
-char imuFileName[]  = "../inputData/imuSens.npy";
-char gnssFileName[] = "../inputData/gnssSens.npy";
-char strFileName[]  = "../inputData/strSens.npy";
+extern char imuFileName[];
+extern char gnssFileName[];
+extern char strFileName[];
+
+extern const char inFp[3][30];
+
+/* Sensor names indexed by sensorIn_e, for reports, and their rig file sections. */
+extern const char* const sensorNames[numGncSensorIf];
+extern const char* const sensorSections[numGncSensorIf];
+
+/* Sample rates the scenario data was generated at, see inputData/scenarioAerocapture.py. */
+extern const double    imuRate_Hz;
+extern const double    gnssRate_Hz;
+extern const double    strRate_Hz;
 
-const char inFp[3][30] = {
-                        "../inputData/imuSens.npy",
-                        "../inputData/gnssSens.npy",
-                        "../inputData/strSens.npy"
-                    };
+/* Delivery latency behind the sample time. GNSS and star tracker solutions take a while to compute. */
+extern const double    imuLatency_ms;
+extern const double    gnssLatency_ms;
+extern const double    strLatency_ms;
 
 /* IPC Address and Port Definitions. */
-const char      IPCAddr[]      = "127.0.0.1";
-const uint16_t  ImuIpcPort     = 60010;
-const uint16_t  GnssIpcPort    = 60020;
-const uint16_t  StrIpcPort     = 60030;
-const uint16_t  ActIpcPort     = 60000;
+extern const char      IPCAddr[];
+extern const uint16_t  ImuIpcPort;
+extern const uint16_t  GnssIpcPort;
+extern const uint16_t  StrIpcPort;
+extern const uint16_t  ActIpcPort;
 
-const uint16_t  imuFdirPort    = 50010;
-const uint16_t  gnssFdirPort   = 50020;
-const uint16_t  strFdirPort    = 50030;
+extern const uint16_t  imuFdirPort;
+extern const uint16_t  gnssFdirPort;
+extern const uint16_t  strFdirPort;
 
-/* Utility Functions. */
-void setNumSensors(sensorConfig_t* sCfg, unsigned int numImu, unsigned int numGnss, unsigned int numStrTrk)
-{
-    if (numImu <= maxNumImu)
-    {
-        sCfg->imuConf.numImuSensors = numImu;
-    }
-    else
-    {
-        sCfg->imuConf.numImuSensors = 0;
-    }
-    
-    if (numGnss <= maxNumGnss)
-    {
-        sCfg->gnssConf.numGnssSensors = numGnss;
-    }
-    else
-    {
-        sCfg->gnssConf.numGnssSensors = 0;
-    }
-    
-    if (numStrTrk <= maxNumStrTrk)
-    {
-        sCfg->strConf.numStrTrk = numStrTrk;
-    }
-    else
-    {
-        sCfg->strConf.numStrTrk = 0;
-    }
-}
-
-void setSensorLatency(sensorConfig_t* sCfg, double imuMs, double gnssMs, double strMs)
+/* Shared memory table of the latest voted sample per sensor, published by FDIR. */
+extern const char      latestTableName[];
+
+/* Lockstep co-simulation, see lockstepLib.h. Stages run in this order every tick. */
+extern const char      lockstepName[];
+
+typedef enum
 {
-    sCfg->imuConf.latency_ms  = imuMs;
-    sCfg->gnssConf.latency_ms = gnssMs;
-    sCfg->strConf.latency_ms  = strMs;
-}
+    stepSensors   = 0,
+    stepFdir      = 1,
+    stepGnc       = 2,
+    numStepStages = 3
+} stepStage_e;
+
+extern const char* const stepStageNames[numStepStages];
+
+/* How long a member waits for the coordinator to come up. */
+extern const int       lockstepJoinTimeout_ms;
+
+/* Utility Functions. */
+
+/* 
+ * Rig description of this run. Starts from the constants above, then the file named by TEC_RIG_CONFIG,
+ * if set, overrides them. Every process of a run must see the same file. Returns -1 on a bad file.
+ */
+int initRigConfig(rigConfig_t* rig);
+
+/* Default thrusters: for each axis four, two pushing each way, offset along the next axis by this arm. */
+extern const double    thrusterArm_m;
+extern const double    thrusterForce_N;
+/* Shortest pulse, as a fraction of the GNC control period. */
+extern const double    thrusterMinDuty;
+
+/* 
+ * Thruster geometry and allocation of this run. Default set above unless TEC_THRUSTER_CONFIG names a
+ * geometry file. Returns -1 on a bad file or a set that cannot act on every axis.
+ */
+int initThrusterConfig(thrAlloc_t* alloc);
+
+/* FDIR voting. Lanes 0-2 hold velInc or position, 3-5 angInc or velocity. */
+#define fdirVoteChannels 6U
+
+extern const double imuVoteTol[fdirVoteChannels];                                   //< m/s^2, rad/s
+extern const double gnssVoteTol[fdirVoteChannels];                                  //< m, m/s
+
+/* Residual detectors. Noise at a fifth of the vote tolerance, bias of 1 sigma found in about 16 samples. */
+extern const residualCfg_t imuResidualCfg;
+extern const residualCfg_t gnssResidualCfg;
+
+/* 
+ * GNC navigation noise as seen on the scenario data. The IMU saturates in the aerocapture, hence the large
+ * force noise.
+ */
+extern const eskfCfg_t      gncKfCfg;
+extern const navFilterCfg_t gncNavCfg;
+
+/* GNC rate damping gain, N m s. */
+extern const double         gncRateGain;
+
+void setSensorLatency(sensorConfig_t* sCfg, double imuMs, double gnssMs, double strMs);
+
+void setSensorRates(sensorConfig_t* sCfg, double imuHz, double gnssHz, double strHz);
 
 #endif  // 
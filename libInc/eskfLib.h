@@ -0,0 +1,66 @@
+// Error state Kalman filter around the strapdown solution of navLib. The error state is position, velocity,
+// attitude (inertial frame rotation vector), accelerometer bias and gyro bias, 15 states in 3 blocks each.
+// The transition matrix is block sparse and the measurements observe contiguous blocks, so covariance
+// propagation and updates work on blocks and skip the zero parts. Fixed size, no allocation.
+#ifndef __LIBINC_ESKFLIB_H_
+#define __LIBINC_ESKFLIB_H_
+
+#include <stdint.h>
+
+#include "navLib.h"
+
+#define eskfNumStates 15U
+#define eskfMaxMeas   6U
+
+/* First state of each block. */
+typedef enum
+{
+    eskfPos   = 0,
+    eskfVel   = 3,
+    eskfAtt   = 6,
+    eskfAccB  = 9,
+    eskfGyroB = 12
+} eskfBlock_e;
+
+typedef struct
+{
+    double accNoise;                                //< m/s^2/sqrt(Hz), velocity random walk.
+    double gyroNoise;                               //< rad/s/sqrt(Hz), angle random walk.
+    double accBiasWalk;                             //< m/s^2/sqrt(s).
+    double gyroBiasWalk;                            //< rad/s/sqrt(s).
+    double initSigma[5];                            //< Per block, 1 sigma.
+    double gateSigma;                               //< Innovations beyond this many sigma are rejected.
+} eskfCfg_t;
+
+typedef struct
+{
+    const eskfCfg_t* cfg;
+    double           P[eskfNumStates][eskfNumStates];
+    vec3_t           accBias;                       //< Body, subtracted from the IMU.
+    vec3_t           gyroBias;
+    uint64_t         numUpdates;
+    uint64_t         numRejected;
+} eskf_t;
+
+void initEskf(eskf_t* kf, const eskfCfg_t* cfg);
+
+/* Increments corrected by the bias estimates, to feed navPropagate. */
+void eskfCorrectImu(const eskf_t* kf, vec3_t* dTheta, vec3_t* dVel, double dt);
+
+/* Covariance over a step of dt seconds that navPropagate just took with the corrected dVel. */
+void eskfPropagate(eskf_t* kf, const navState_t* nav, vec3_t dVel, double dt);
+
+/* 
+ * Measurement of the m states from first on, y the innovation, r the noise variances. The error estimate
+ * is folded into nav and the biases. Returns -1 when the innovation failed the gate and was not applied.
+ */
+int eskfUpdateBlock(eskf_t* kf, navState_t* nav, unsigned int first, unsigned int m, const double* y,
+                    const double* r);
+
+/* GNSS position and velocity in the inertial frame. */
+int eskfUpdateGnss(eskf_t* kf, navState_t* nav, vec3_t pos_m, vec3_t vel_m_s, double posVar, double velVar);
+
+/* Star tracker body to inertial attitude. */
+int eskfUpdateAttitude(eskf_t* kf, navState_t* nav, quat_t q_ib, double attVar);
+
+#endif  // __LIBINC_ESKFLIB_H_
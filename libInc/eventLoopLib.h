@@ -0,0 +1,60 @@
+// Event loop built on epoll. Used by applications that react to several IPC channels and timers on one thread.
+#ifndef __LIBINC_EVENTLOOPLIB_H_
+#define __LIBINC_EVENTLOOPLIB_H_
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "interfaceLib.h"
+
+/* Max events dispatched per epoll_wait. */
+#define eventLoopMaxEvents 32U
+
+/* 
+ * Callback for a ready source.
+ * Sources are edge triggered, so an fd handler must read until EAGAIN before returning.
+ */
+typedef void (*eventHandler_t)(void* ctx);
+
+typedef struct eventSource
+{
+    struct eventSource* next;                       //< Sources owned by the loop.
+    int            fd;
+    int            isTimer;                         //< Timer sources are drained by the loop itself.
+    eventHandler_t handler;
+    void*          ctx;
+    uint64_t       numExpired;                      //< Timer: expirations seen, including missed ones.
+    uint64_t       numMissed;                       //< Timer: expirations that fell together with another.
+} eventSource_t;
+
+typedef struct
+{
+    int            epollFd;
+    atomic_int     running;                         //< Cleared by stopEventLoop, from any thread.
+    unsigned int   numSources;
+    eventSource_t* sources;
+} eventLoop_t;
+
+int initEventLoop(eventLoop_t* loop);
+
+/* Register any readable fd. The fd should be non-blocking. */
+eventSource_t* addEventFd(eventLoop_t* loop, int fd, eventHandler_t handler, void* ctx);
+
+/* Register an IPC channel. The channel is switched to non-blocking receive. */
+eventSource_t* addEventIPC(eventLoop_t* loop, ipcConfig_t* cfg, eventHandler_t handler, void* ctx);
+
+/* Register a periodic timer, first expiry one period from now. */
+eventSource_t* addEventTimer(eventLoop_t* loop, double freq, eventHandler_t handler, void* ctx);
+
+/* Wait up to timeoutMs (-1 forever) and dispatch ready sources. Returns number dispatched, -1 on error. */
+int stepEventLoop(eventLoop_t* loop, int timeoutMs);
+
+/* Dispatch until stopEventLoop is called. From another thread it takes effect at the next wakeup. */
+int runEventLoop(eventLoop_t* loop);
+
+void stopEventLoop(eventLoop_t* loop);
+
+/* Frees all sources and closes timer fds. Registered IPC fds stay with their owner. */
+int closeEventLoop(eventLoop_t* loop);
+
+#endif  // __LIBINC_EVENTLOOPLIB_H_
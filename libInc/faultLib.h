@@ -0,0 +1,142 @@
+// Scripted sensor fault injection for FDIR stress runs. One fault per line, times in scenario seconds:
+//
+//     # type  unit  kind       start_s  duration_s  [magnitude]  [channel]
+//     imu     1     bias       10.0     20.0        0.5          0
+//     gnss    2     stuck      5.0      0
+//     imu     0     delay      30.0     2.0         0.05
+//
+// A duration of 0 lasts to the end of the run. Channel -1 or none applies to every channel.
+//  - bias, drift, noise and stuck change channel values: offset, offset growing per second, gaussian noise
+//    of the given sigma, values frozen at the first sample of the window.
+//  - dropout, duplicate, reorder and delay act on the packet: not sent, sent twice, swapped with the next
+//    sample, held back for magnitude seconds.
+// Held samples go out with the first sample of their unit at or after the release time, so a delay is rounded
+// up to a whole sample period of the sensor. Samples still held when the stream ends go out then.
+// Sensors without faults never enter this code, injection costs one pointer test per sample when disabled.
+#ifndef __LIBINC_FAULTLIB_H_
+#define __LIBINC_FAULTLIB_H_
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define faultMaxTypes     8U
+#define faultMaxPerSensor 32U
+#define faultMaxChannels  8U
+#define faultMaxHeld      8U
+#define faultMsgBytes     256U
+
+typedef enum
+{
+    faultBias      = 0,
+    faultDrift     = 1,
+    faultNoise     = 2,
+    faultStuck     = 3,
+    faultDropout   = 4,
+    faultDuplicate = 5,
+    faultReorder   = 6,
+    faultDelay     = 7,
+    numFaultKinds  = 8
+} faultKind_e;
+
+/* Packet actions for the sender, returned by applyFaults. */
+typedef enum
+{
+    faultActDrop      = 1,
+    faultActDuplicate = 2,
+    faultActHold      = 4                           //< Hand the sample to holdFaultSample instead of sending it.
+} faultAct_e;
+
+typedef struct
+{
+    faultKind_e  kind;
+    unsigned int unit;
+    int          channel;                           //< Value faults only, -1 for every channel.
+    uint64_t     start_ns;
+    uint64_t     end_ns;                            //< UINT64_MAX for the rest of the run.
+    double       magnitude;                         //< Channel units, per second for drift, seconds for delay.
+} fault_t;
+
+typedef struct
+{
+    const char*  name;                              //< Sensor type as written in the script.
+    unsigned int numFaults;
+    fault_t      fault[faultMaxPerSensor];
+} faultList_t;
+
+typedef struct
+{
+    unsigned int numTypes;
+    faultList_t  type[faultMaxTypes];
+} faultScript_t;
+
+/* Sample held back by a reorder or delay fault. */
+typedef struct
+{
+    uint64_t release_ns;
+    size_t   size;
+    uint8_t  data[faultMsgBytes];
+} faultHeld_t;
+
+/* Injection state of one unit. */
+typedef struct
+{
+    double       stuck[faultMaxChannels];
+    int          haveStuck;
+    unsigned int numHeld;
+    faultHeld_t  held[faultMaxHeld];
+    faultHeld_t  out;                               //< Last released sample.
+} faultUnit_t;
+
+/* Injection state of one sensor type. Used by the single thread replaying it. */
+typedef struct
+{
+    const faultList_t* list;
+    faultUnit_t*       unit;
+    unsigned int       numUnits;
+    uint64_t           rng;
+    const double*      noise;                       //< Per channel sigma of every unit, NULL for none.
+    _Atomic uint64_t   numHit[numFaultKinds];       //< Samples affected, per kind.
+} faultSensor_t;
+
+/* Script with the given sensor types and no faults. Names are referenced, not copied. */
+void initFaultScript(faultScript_t* script, const char* const* names, unsigned int numTypes);
+
+/* Append a fault to a sensor type. Returns -1 when its list is full. */
+int addFault(faultScript_t* script, unsigned int type, const fault_t* fault);
+
+/* Append the faults of a script file. Returns -1 with a message naming the line on any error. */
+int loadFaultScript(faultScript_t* script, const char* path);
+
+/*
+ * Bind the faults of one sensor type to its numUnits units, units is caller memory for numUnits faultUnit_t.
+ * Returns -1 with a message when a fault names a unit that does not exist.
+ */
+int initFaultSensor(faultSensor_t* fs, const faultList_t* list, faultUnit_t* units, unsigned int numUnits,
+                     uint64_t seed);
+
+/* Gaussian noise of sigma[c] on channel c of every unit and sample, ahead of the faults. sigma is referenced. */
+void setFaultNoise(faultSensor_t* fs, const double* sigma);
+
+/* 
+ * Apply the faults of unit active at simTime_ns. Value faults change the numCh channels in place.
+ * Returns faultAct_e bits, with faultActHold the release time is stored in release_ns.
+ */
+unsigned int applyFaults(faultSensor_t* fs, unsigned int unit, uint64_t simTime_ns, double* ch, unsigned int numCh,
+                         uint64_t* release_ns);
+
+/* Keep a copy of a sample until release_ns. Returns -1 when the unit holds too many already. */
+int holdFaultSample(faultSensor_t* fs, unsigned int unit, uint64_t release_ns, const void* msg, size_t size);
+
+/* 
+ * Oldest held sample of unit due at simTime_ns, NULL if none. Valid until the next call. UINT64_MAX takes
+ * every held sample, to flush them at the end of a stream.
+ */
+const faultHeld_t* releaseFaultSample(faultSensor_t* fs, unsigned int unit, uint64_t simTime_ns);
+
+void printFaultStats(const char* name, faultSensor_t* fs);
+
+/* Kind as written in the script, "?" if out of range. */
+const char* faultKindName(faultKind_e kind);
+
+#endif  // __LIBINC_FAULTLIB_H_
@@ -22,6 +22,29 @@ enum interfaceType
     OUTPUT = 100
 };
 
+/* Transport used to move messages for an IPC channel. */
+enum ipcTransport
+{
+    IPC_DEFAULT = 0,                                //< Resolved at init from TEC_IPC_TRANSPORT ("udp", "shm", "inproc").
+    IPC_UDP     = 1,                                //< One datagram per message.
+    IPC_SHM     = 2,                                //< Shared memory ring, UDP socket only used as doorbell.
+    IPC_INPROC  = 3,                                //< Heap ring between threads of one process, eventfd doorbell.
+    IPC_DIRECT  = 4                                 //< IPC_INPROC without the doorbell, for ends one thread polls.
+};
+
+/* Shared memory ring dimensions. Slot payload must hold the largest sensor message. */
+#define ipcShmNumSlots  256U
+#define ipcShmSlotSize  248U
+
+/* Upper bound on messages moved by one batched send or receive call. */
+#define ipcMaxBatch     16U
+
+/* 
+ * Single producer / single consumer ring, lives in shared memory. An in-process channel uses the same ring
+ * from the heap, found by port in a registry of the process, so both ends may open it in any order.
+ */
+typedef struct ipcShmRing ipcShmRing_t;
+
 typedef struct
 {
     char*              filePath;                    //< Store Interface Path.
@@ -32,6 +55,32 @@ typedef struct
     char*              fmtSpec;                     //< Specify format for fscanf to parse csv. Device specifc driver to provide this.
 }interfaceCfg_t;
 
+/* Dimensions supported by the npy header parser. */
+#define npyMaxDims 4U
+
+/* Parsed npy header. Describes the data block that follows it in the file. */
+typedef struct
+{
+    size_t             dataOffset;                  //< Byte offset of the first element in the file.
+    size_t             shape[npyMaxDims];
+    unsigned int       ndim;
+    char               typeChar;                    //< numpy kind: 'f', 'i', 'u', 'b'.
+    char               endianness;                  //< '<', '>' or '|'.
+    size_t             elemSize;                    //< Bytes per element.
+    int                fortranOrder;
+    size_t             numRows;                     //< shape[0], 1 for a scalar.
+    size_t             rowSize;                     //< Bytes per row (product of the trailing dims).
+} npyHeader_t;
+
+/* Read-only npy file mapped into memory. Rows are served straight from the mapping, nothing is copied. */
+typedef struct
+{
+    npyHeader_t        hdr;
+    void*              mapBase;
+    size_t             mapSize;
+    const char*        data;                        //< First element, inside the mapping.
+} npyMap_t;
+
 typedef struct
 {
     char*              ipAddress;                   //< Store the IP Address.
@@ -40,12 +89,27 @@ typedef struct
     struct sockaddr_in si;
     enum interfaceType direction;
     struct pollfd      sockPoll;
+    enum ipcTransport  transport;                   //< Transport backend, see enum ipcTransport.
+    ipcShmRing_t*      shmRing;                     //< Ring of every transport but IPC_UDP.
+    int                nonBlocking;                 //< Receive returns -1 / EAGAIN instead of waiting.
+    int                blockOnFull;                 //< Shared memory send waits for space while the ring has a reader.
 } ipcConfig_t;
 
 int initInterface(interfaceCfg_t* cfg);
 
 npy_array_t* npyLoadData(interfaceCfg_t* cfg);
 
+/* Parse an npy header in place. buf must hold at least the first size bytes of the file. Returns -1 if invalid or truncated. */
+int npyParseHeader(const char* buf, size_t size, npyHeader_t* hdr);
+
+/* Map the npy file at cfg->filePath. Only C-ordered, little endian data is accepted. */
+int npyMapData(interfaceCfg_t* cfg, npyMap_t* map);
+
+/* Pointer to a row inside the mapping, NULL past the end. */
+const char* npyMapRow(const npyMap_t* map, size_t row);
+
+int npyUnmapData(npyMap_t* map);
+
 int closeInterface(interfaceCfg_t* cfg);
 
 void setInterface(interfaceCfg_t* cfg,enum interfaceType type, char* fileName);
@@ -56,8 +120,37 @@ ssize_t sendMsgIPC(ipcConfig_t* cfg, uint8_t* dataBuf, size_t dataBufSize);
 
 ssize_t recvMsgIPC(ipcConfig_t* cfg, uint8_t* dataBuf, size_t dataBufSize);
 
+/* Send one message to each of numCfg channels. Returns number of messages sent. */
+int sendMsgBatchIPC(ipcConfig_t* cfg, unsigned int numCfg, uint8_t* dataBuf, size_t dataBufSize);
+
+/* 
+ * Receive up to maxMsgs queued messages from one channel into dataBuf, msgStride bytes apart.
+ * Blocks for the first message only. Lengths are written to msgLen. Returns number of messages received.
+ */
+int recvMsgBatchIPC(ipcConfig_t* cfg, uint8_t* dataBuf, size_t msgStride, size_t dataBufSize, ssize_t* msgLen, unsigned int maxMsgs);
+
+/* Switch receive on an initialised channel to non-blocking. */
+int setIpcNonBlocking(ipcConfig_t* cfg);
+
+/* Messages queued on a shared memory or in-process channel and not yet received. -1 for UDP, which cannot tell. */
+ssize_t pendingMsgIPC(const ipcConfig_t* cfg);
+
 void initPollFd(struct pollfd* fds, unsigned int numFd, int event);
 
 void setIpcAddrPort(ipcConfig_t* cfg, char* addr, uint16_t port, enum interfaceType type);
 
+void setIpcAddrPortTransport(ipcConfig_t* cfg, char* addr, uint16_t port, enum interfaceType type, enum ipcTransport transport);
+
+/*
+ * Remove the shared memory segment of a channel this end consumes, so the next run starts from a fresh ring.
+ * The mapping stays valid for threads still using it. Nothing to do for other transports or producers.
+ */
+void unlinkIPC(const ipcConfig_t* cfg);
+
+/* Unlink as above, unmap the ring and close the socket. In-process channels are only detached. */
+int closeIPC(ipcConfig_t* cfg);
+
+/* Transport named "udp", "shm" or "inproc". Returns IPC_DEFAULT for anything else. */
+enum ipcTransport parseIpcTransport(const char* name);
+
 #endif  // __LIBINC_INTERFACELIB_H_
\ No newline at end of file
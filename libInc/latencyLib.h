@@ -0,0 +1,32 @@
+// Latency tables. One log bucketed histogram per (sensor, stage) pair, constant time per sample
+// and safe to update from several threads while another prints.
+#ifndef __LIBINC_LATENCYLIB_H_
+#define __LIBINC_LATENCYLIB_H_
+
+#include <stdint.h>
+
+#include "threadLib.h"
+
+#define latMaxSensors 4U
+#define latMaxStages  4U
+
+typedef struct
+{
+    const char* const* sensorNames;
+    const char* const* stageNames;
+    unsigned int       numSensors;
+    unsigned int       numStages;
+    timeHist_t         hist[latMaxSensors][latMaxStages];
+} latencyTable_t;
+
+/* Names are referenced, not copied. Returns -1 if the table is too small. */
+int initLatencyTable(latencyTable_t* tab, const char* const* sensorNames, unsigned int numSensors,
+                     const char* const* stageNames, unsigned int numStages);
+
+/* Record to_ns - from_ns. Skipped when from_ns is 0, i.e. the hop was not stamped. */
+void addLatency(latencyTable_t* tab, unsigned int sensor, unsigned int stage, uint64_t from_ns, uint64_t to_ns);
+
+/* One line per (sensor, stage) with samples. Percentiles are bucket upper bounds. */
+void printLatencyTable(const char* title, latencyTable_t* tab);
+
+#endif  // __LIBINC_LATENCYLIB_H_
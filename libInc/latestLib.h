@@ -0,0 +1,55 @@
+// Latest sample table. One seqlock protected slot per sensor type, a single writer each. Readers never
+// block the writer and retry the copy if it overlapped a publication. Lives in process memory or in a
+// shared memory segment so another process reads it without a copy through the IPC.
+#ifndef __LIBINC_LATESTLIB_H_
+#define __LIBINC_LATESTLIB_H_
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define latestMaxSlots  4U
+#define latestSlotBytes 256U
+#define latestSlotWords (latestSlotBytes / sizeof(uint64_t))
+
+/* Payload copied word by word with relaxed atomics, so a torn read is detected rather than undefined. */
+typedef struct
+{
+    _Atomic uint32_t seq;                           //< Odd while a publication is in progress.
+    _Atomic uint32_t size;
+    _Atomic uint64_t word[latestSlotWords];
+} __attribute__((aligned(64))) latestSlot_t;
+
+typedef struct
+{
+    latestSlot_t slot[latestMaxSlots];
+} latestTable_t;
+
+/* 
+ * Open the table. NULL name gives a private zeroed table for threads of one process, otherwise the
+ * shared memory segment of that name is created if needed and mapped. Either side may open it first.
+ * Returns NULL on failure.
+ */
+latestTable_t* openLatestTable(const char* name);
+
+void closeLatestTable(latestTable_t* tab, const char* name);
+
+/*
+ * Mark every slot unpublished, for the writer at start. A segment left by an earlier run would otherwise hand
+ * its last samples and generations to the readers of this one, which see the generations start again at 0.
+ */
+void resetLatestTable(latestTable_t* tab);
+
+/* Remove the shared memory segment, for the writer at the end. Mappings stay valid for readers still using it. */
+void unlinkLatestTable(const char* name);
+
+/* Publish a sample into slot. Only one thread may publish to a slot. Returns -1 if it does not fit. */
+int publishLatest(latestTable_t* tab, unsigned int slot, const void* data, size_t size);
+
+/* 
+ * Copy the latest sample of slot, at most size bytes. Returns the number of publications so far,
+ * 0 if there was none yet and data is untouched.
+ */
+uint32_t readLatest(latestTable_t* tab, unsigned int slot, void* data, size_t size);
+
+#endif  // __LIBINC_LATESTLIB_H_
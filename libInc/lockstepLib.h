@@ -0,0 +1,66 @@
+// Lockstep co-simulation. A coordinator advances a virtual clock in fixed ticks. Every tick it releases the
+// pipeline stages one after the other: all members of a stage do the work of the tick and acknowledge, then
+// the next stage is released. A stage only ever sees the complete output of the stages before it for that
+// tick, so a run is reproducible and goes as fast as the stages allow, not at wall clock speed.
+// State lives in a shared memory segment. Members and coordinator sleep on futexes, nobody spins.
+#ifndef __LIBINC_LOCKSTEPLIB_H_
+#define __LIBINC_LOCKSTEPLIB_H_
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define lockstepMaxStages 8U
+
+typedef struct
+{
+    _Atomic uint32_t phase;                         //< Futex word, bumped for every stage released.
+    _Atomic uint32_t pending;                       //< Futex word, members of the released stage still working.
+    _Atomic uint32_t stop;
+    _Atomic uint32_t numJoined;
+    _Atomic uint32_t numMembers[lockstepMaxStages];
+    _Atomic uint32_t stage;                         //< Released stage and tick, written before phase.
+    _Atomic uint64_t tick;
+    uint64_t         tick_ns;                       //< Virtual time per tick.
+    int32_t          coordPid;
+} lockstepShared_t;
+
+/* One member, a thread of a pipeline stage. */
+typedef struct
+{
+    lockstepShared_t* shm;
+    unsigned int      stage;
+    uint32_t          seenPhase;
+    int               active;                       //< Inside a tick, owes an acknowledge.
+    uint64_t          tickStart_ns;                 //< Virtual time span of the current tick, end exclusive.
+    uint64_t          tickEnd_ns;
+    uint64_t          numTicks;
+} lockstepMember_t;
+
+/* Coordinator. Replaces any segment left by an earlier run. NULL on failure. */
+lockstepShared_t* createLockstep(const char* name, uint64_t tick_ns);
+
+/* Release a stage for a tick. Returns its number of members, 0 means there is nothing to wait for. */
+unsigned int releaseLockstepStage(lockstepShared_t* shm, uint64_t tick, unsigned int stage);
+
+/* Wait up to timeoutMs for the released stage to acknowledge. Returns 0 when it did, -1 otherwise. */
+int waitLockstepStage(lockstepShared_t* shm, int timeoutMs);
+
+/* Wake every member with the stop flag set. */
+void stopLockstep(lockstepShared_t* shm);
+
+/* Unmaps the segment. The coordinator passes the name to remove it. */
+void closeLockstep(lockstepShared_t* shm, const char* name);
+
+/* Join stage of the coordinator's segment, waiting up to timeoutMs for it to appear. Returns -1 on failure. */
+int joinLockstep(lockstepMember_t* m, const char* name, unsigned int stage, int timeoutMs);
+
+/*
+ * Acknowledge the current tick, if any, and sleep until the stage is released again. Returns 0 with the
+ * tick span set, -1 once the run is stopped or the coordinator is gone.
+ */
+int awaitLockstep(lockstepMember_t* m);
+
+/* Leave the run from inside a tick. The tick is acknowledged and the stage no longer waited for. */
+void leaveLockstep(lockstepMember_t* m);
+
+#endif  // __LIBINC_LOCKSTEPLIB_H_
@@ -0,0 +1,51 @@
+// Time ordered measurement queue. Fixed size records kept sorted by their sensor timestamp in a ring, so
+// measurements can be taken in time order whatever order they arrived in. Storage comes from the caller,
+// nothing is allocated. In order arrivals append in constant time, a late one moves only the newer entries.
+#ifndef __LIBINC_MEASQUEUELIB_H_
+#define __LIBINC_MEASQUEUELIB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint64_t*    time_ns;                           //< Timestamp per ring slot.
+    uint8_t*     items;                             //< itemSize bytes per ring slot.
+    size_t       itemSize;
+    unsigned int capacity;
+    unsigned int head;                              //< Ring slot of the oldest entry.
+    unsigned int count;
+    uint64_t     numEvicted;                        //< Oldest entries given up to a full queue.
+    uint64_t     numRefused;                        //< New entries a full queue had no entry to give up for.
+} measQueue_t;
+
+/* Storage needed for capacity records of itemSize bytes. */
+size_t measQueueBytes(unsigned int capacity, size_t itemSize);
+
+/* mem holds measQueueBytes(capacity, itemSize), 8 byte aligned. Returns -1 if capacity is 0. */
+int initMeasQueue(measQueue_t* q, void* mem, unsigned int capacity, size_t itemSize);
+
+/*
+ * Insert in time order, after entries with the same time. A full queue gives up its oldest entry if that is
+ * at or before evict_ns, otherwise the new entry is refused. Returns -1 when refused.
+ */
+int pushMeas(measQueue_t* q, uint64_t time_ns, const void* item, uint64_t evict_ns);
+
+/* Index of the first entry later than time_ns, count if there is none. Binary search. */
+unsigned int findMeasAfter(const measQueue_t* q, uint64_t time_ns);
+
+/* Drop the entries up to and including time_ns. */
+void trimMeas(measQueue_t* q, uint64_t time_ns);
+
+/* Entry i in time order, 0 the oldest. */
+static inline uint64_t measTime(const measQueue_t* q, unsigned int i)
+{
+    return q->time_ns[(q->head + i) % q->capacity];
+}
+
+static inline const void* measItem(const measQueue_t* q, unsigned int i)
+{
+    return q->items + (size_t) ((q->head + i) % q->capacity) * q->itemSize;
+}
+
+#endif  // __LIBINC_MEASQUEUELIB_H_
@@ -0,0 +1,98 @@
+// Navigation filter. Strapdown on the IMU path, corrected by the error state Kalman filter with GNSS fixes and
+// attitudes fused at their sensor time. Measurements wait in a time ordered queue until the IMU steps reach
+// them. One that arrives after the state passed it rewinds to the history entry before it and replays the
+// IMU steps since. All state is in the filter object and caller memory, so any number of filters can run
+// side by side, one per thread.
+#ifndef __LIBINC_NAVFILTERLIB_H_
+#define __LIBINC_NAVFILTERLIB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "navLib.h"
+#include "eskfLib.h"
+#include "measQueueLib.h"
+#include "threadLib.h"
+
+typedef enum
+{
+    navMeasGnss     = 0,
+    navMeasAttitude = 1
+} navMeasKind_e;
+
+/* GNSS fix or attitude waiting in the queue. */
+typedef struct
+{
+    navMeasKind_e kind;
+    union
+    {
+        struct
+        {
+            vec3_t pos_m;
+            vec3_t vel_m_s;
+        } gnss;
+        quat_t q_ib;
+    };
+} navMeas_t;
+
+/* Navigation after an IMU step, and the sample that step used, for replays from an earlier time. */
+typedef struct
+{
+    navState_t nav;
+    eskf_t     kf;
+    vec3_t     angRate_rad_s;
+    vec3_t     accel_m_s2;
+} navHist_t;
+
+typedef struct
+{
+    const eskfCfg_t* kf;
+    double           gnssPosVar_m2;
+    double           gnssVelVar_m2_s2;
+    double           attVar_rad2;
+} navFilterCfg_t;
+
+typedef struct
+{
+    const navFilterCfg_t* cfg;
+    navState_t   nav;
+    eskf_t       kf;
+    int          valid;                             //< Set by startNavFilter.
+    measQueue_t  meas;                              //< Measurements in sensor time order.
+    navHist_t*   hist;                              //< State after each of the last histDepth IMU steps.
+    unsigned int histDepth;
+    uint64_t     histHead;                          //< IMU steps saved, the next entry is this modulo the depth.
+    double       errLast_m;                         //< Position innovation of the last GNSS fix.
+    double       errMax_m;
+    uint64_t     numRejected;                       //< IMU samples with non finite values.
+    uint64_t     numLate;                           //< Measurements older than the history.
+    uint64_t     numRewinds;
+    uint64_t     numReplayed;                       //< IMU steps run again by rewinds.
+    timeHist_t*  cycle;                             //< Wall time per IMU step, per update and per rewind.
+    timeHist_t*  update;                            //< NULL skips the clock reads.
+    timeHist_t*  rewind;
+} navFilter_t;
+
+/* Caller memory for a history of histDepth IMU steps and a queue of measLen measurements. */
+size_t navFilterBytes(unsigned int histDepth, unsigned int measLen);
+
+/* mem holds navFilterBytes, 8 byte aligned. cfg is referenced, not copied. Returns -1 on bad arguments. */
+int initNavFilter(navFilter_t* f, void* mem, unsigned int histDepth, unsigned int measLen,
+                  const navFilterCfg_t* cfg);
+
+/* Start the state at time_ns, e.g. from the first GNSS fix and star tracker attitude. */
+void startNavFilter(navFilter_t* f, vec3_t pos_m, vec3_t vel_m_s, quat_t q_ib, uint64_t time_ns);
+
+/*
+ * Propagate to the time of an IMU sample, through the measurements due in between. Samples at or before
+ * the state time are ignored, non finite ones rejected and the interval bridged by the next good one.
+ */
+void navFilterImu(navFilter_t* f, vec3_t angRate_rad_s, vec3_t accel_m_s2, uint64_t t_ns);
+
+/*
+ * Queue a measurement taken at t_ns, rewinding if the state is past it. Returns -1 before the start, too late,
+ * or when the queue is full of measurements the state has not reached (counted in meas.numRefused).
+ */
+int navFilterMeasure(navFilter_t* f, uint64_t t_ns, const navMeas_t* meas);
+
+#endif  // __LIBINC_NAVFILTERLIB_H_
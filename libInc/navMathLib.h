@@ -0,0 +1,137 @@
+// Fixed size vector, quaternion and matrix types for navigation. Plain structs passed by value, no heap,
+// and inline so the compiler sees whole expressions and keeps them in registers.
+// Quaternions are Hamilton, scalar first. quatToMat(q_ab) rotates vectors from frame b to frame a.
+#ifndef __LIBINC_NAVMATHLIB_H_
+#define __LIBINC_NAVMATHLIB_H_
+
+#include <math.h>
+
+typedef struct
+{
+    double v[3];
+} vec3_t;
+
+typedef struct
+{
+    double q[4];
+} quat_t;
+
+typedef struct
+{
+    double m[3][3];
+} mat3_t;
+
+static inline vec3_t vec3Add(vec3_t a, vec3_t b)
+{
+    vec3_t r;
+    for (int i = 0; i < 3; i++)
+    {
+        r.v[i] = a.v[i] + b.v[i];
+    }
+    return r;
+}
+
+static inline vec3_t vec3Sub(vec3_t a, vec3_t b)
+{
+    vec3_t r;
+    for (int i = 0; i < 3; i++)
+    {
+        r.v[i] = a.v[i] - b.v[i];
+    }
+    return r;
+}
+
+static inline vec3_t vec3Scale(vec3_t a, double s)
+{
+    vec3_t r;
+    for (int i = 0; i < 3; i++)
+    {
+        r.v[i] = a.v[i] * s;
+    }
+    return r;
+}
+
+static inline double vec3Dot(vec3_t a, vec3_t b)
+{
+    return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2];
+}
+
+static inline double vec3Norm(vec3_t a)
+{
+    return sqrt(vec3Dot(a, a));
+}
+
+static inline vec3_t vec3Cross(vec3_t a, vec3_t b)
+{
+    vec3_t r = {{a.v[1] * b.v[2] - a.v[2] * b.v[1],
+                 a.v[2] * b.v[0] - a.v[0] * b.v[2],
+                 a.v[0] * b.v[1] - a.v[1] * b.v[0]}};
+    return r;
+}
+
+static inline quat_t quatMul(quat_t a, quat_t b)
+{
+    quat_t r = {{a.q[0] * b.q[0] - a.q[1] * b.q[1] - a.q[2] * b.q[2] - a.q[3] * b.q[3],
+                 a.q[0] * b.q[1] + a.q[1] * b.q[0] + a.q[2] * b.q[3] - a.q[3] * b.q[2],
+                 a.q[0] * b.q[2] - a.q[1] * b.q[3] + a.q[2] * b.q[0] + a.q[3] * b.q[1],
+                 a.q[0] * b.q[3] + a.q[1] * b.q[2] - a.q[2] * b.q[1] + a.q[3] * b.q[0]}};
+    return r;
+}
+
+static inline quat_t quatNormalize(quat_t a)
+{
+    double n = 1.0 / sqrt(a.q[0] * a.q[0] + a.q[1] * a.q[1] + a.q[2] * a.q[2] + a.q[3] * a.q[3]);
+    quat_t r;
+    for (int i = 0; i < 4; i++)
+    {
+        r.q[i] = a.q[i] * n;
+    }
+    return r;
+}
+
+/* Rotation by the rotation vector phi. Series below 1e-4 rad, exact to double precision there. */
+static inline quat_t quatFromRotVec(vec3_t phi)
+{
+    double a2 = vec3Dot(phi, phi);
+    double c;
+    double s;
+    quat_t r;
+
+    if (a2 < 1e-8)
+    {
+        c = 1.0 - a2 / 8.0;
+        s = 0.5 - a2 / 48.0;
+    }
+    else
+    {
+        double a = sqrt(a2);
+        c = cos(0.5 * a);
+        s = sin(0.5 * a) / a;
+    }
+    r.q[0] = c;
+    r.q[1] = s * phi.v[0];
+    r.q[2] = s * phi.v[1];
+    r.q[3] = s * phi.v[2];
+    return r;
+}
+
+static inline mat3_t quatToMat(quat_t a)
+{
+    double w = a.q[0], x = a.q[1], y = a.q[2], z = a.q[3];
+    mat3_t r = {{{1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - w * z), 2.0 * (x * z + w * y)},
+                 {2.0 * (x * y + w * z), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z - w * x)},
+                 {2.0 * (x * z - w * y), 2.0 * (y * z + w * x), 1.0 - 2.0 * (x * x + y * y)}}};
+    return r;
+}
+
+static inline vec3_t mat3MulVec(const mat3_t* m, vec3_t a)
+{
+    vec3_t r;
+    for (int i = 0; i < 3; i++)
+    {
+        r.v[i] = m->m[i][0] * a.v[0] + m->m[i][1] * a.v[1] + m->m[i][2] * a.v[2];
+    }
+    return r;
+}
+
+#endif  // __LIBINC_NAVMATHLIB_H_
@@ -0,0 +1,46 @@
+// Streaming npy reader. A background thread prefetches fixed size row chunks into two buffers,
+// so memory use does not depend on the file length and the reader never waits on a read in steady state.
+#ifndef __LIBINC_NPYSTREAMLIB_H_
+#define __LIBINC_NPYSTREAMLIB_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "interfaceLib.h"
+
+/* Default rows per chunk. */
+#define npyStreamChunkRows 4096U
+
+typedef struct
+{
+    npyHeader_t     hdr;
+    int             fd;
+    size_t          chunkRows;
+    char*           buf[2];                         //< Double buffer, chunkRows rows each.
+    size_t          bufRows[2];                     //< Valid rows in each buffer, 0 marks end of file.
+    int             bufReady[2];                    //< Filled by the prefetcher, not yet released by the reader.
+    unsigned int    cur;                            //< Buffer the reader is consuming.
+    int             curHeld;                        //< Reader owns cur. Only touched by the reader.
+    size_t          curIdx;                         //< Next row within cur.
+    size_t          fillRow;                        //< Next file row the prefetcher reads.
+    int             stop;
+    int             ioError;
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint64_t        numStalls;                      //< Times the reader had to wait for a chunk.
+} npyStream_t;
+
+/* Open cfg->filePath and start prefetching. chunkRows of 0 selects npyStreamChunkRows. */
+int npyStreamOpen(interfaceCfg_t* cfg, npyStream_t* st, size_t chunkRows);
+
+/* 
+ * Next row, NULL at end of file or on a read error.
+ * The pointer stays valid until the following call, copy the row out before calling again.
+ */
+const char* npyStreamNextRow(npyStream_t* st);
+
+/* Stop the prefetcher and release the buffers. */
+int npyStreamClose(npyStream_t* st);
+
+#endif  // __LIBINC_NPYSTREAMLIB_H_
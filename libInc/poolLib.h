@@ -0,0 +1,52 @@
+// Work stealing thread pool over an index space. Tasks 0..numTasks-1 are dealt out as one contiguous range per
+// worker. A worker takes indices from the front of its own range, and once that is empty it steals the upper
+// half of the fullest range left. A range is one 64 bit word, so owner and thieves agree on it with a compare
+// and swap, without locks. Suited to many independent tasks of uneven length, e.g. simulation runs.
+#ifndef __LIBINC_POOLLIB_H_
+#define __LIBINC_POOLLIB_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* Largest task count, a range holds two 32 bit indices. */
+#define poolMaxTasks 0xFFFFFFFFULL
+
+/* Runs task index on worker. Workers call it concurrently, each with its own index. */
+typedef void (*poolTask_t)(void* ctx, unsigned int worker, uint64_t index);
+
+typedef struct
+{
+    _Alignas(64) _Atomic uint64_t range;            //< Next index in the low half, end in the high half.
+    struct pool*     owner;
+    pthread_t        thread;
+    unsigned int     id;
+    int              cpu;                           //< CPU the worker is pinned to, -1 for none.
+    uint64_t         numRun;                        //< Tasks run by this worker.
+    uint64_t         numSteals;                     //< Ranges taken from other workers.
+} poolWorker_t;
+
+typedef struct pool
+{
+    poolWorker_t*    workers;
+    unsigned int     numWorkers;
+    poolTask_t       task;
+    void*            ctx;
+    atomic_int       stop;
+} pool_t;
+
+/* numWorkers threads, pinned to CPUs 0..numWorkers-1 when pin is set. Returns -1 on failure. */
+int initPool(pool_t* pool, unsigned int numWorkers, int pin);
+
+/* Run every task once and return when all finished or stopPool. Blocks the caller. Returns tasks run. */
+uint64_t runPool(pool_t* pool, uint64_t numTasks, poolTask_t task, void* ctx);
+
+/* Tasks already started finish, no new ones start. */
+void stopPool(pool_t* pool);
+
+/* Tasks and steals per worker. */
+void printPoolStats(pool_t* pool);
+
+void closePool(pool_t* pool);
+
+#endif  // __LIBINC_POOLLIB_H_
@@ -0,0 +1,71 @@
+// Streaming residual statistics for fault detection. Each unit keeps constant state per channel and is
+// updated in constant time per sample, no history is buffered.
+//  - Welford running mean and variance of the residual, for reporting.
+//  - Two sided CUSUM on the residual in sigmas, for bias.
+//  - EWMA of the residual and its first difference, a moving window of about 1 / alpha samples, for drift.
+//  - Run length of unchanged output while the reference moves, for stuck at.
+#ifndef __LIBINC_RESIDUALLIB_H_
+#define __LIBINC_RESIDUALLIB_H_
+
+#include <stdint.h>
+
+#define residualMaxChannels 8U
+
+typedef enum
+{
+    residualBias  = 1,
+    residualDrift = 2,
+    residualStuck = 4
+} residualFault_e;
+
+typedef struct
+{
+    double       sigma[residualMaxChannels];        //< Expected residual noise per channel, 1 sigma, > 0.
+    double       cusumSlack;                        //< CUSUM allowance k, in sigma.
+    double       cusumLimit;                        //< CUSUM alarm h, in sigma.
+    double       alpha;                             //< EWMA weight. The window is 1 / alpha samples.
+    double       driftLimit;                        //< Residual change over one window, in sigma.
+    unsigned int stuckSamples;                      //< Unchanged samples in a row for stuck at.
+} residualCfg_t;
+
+typedef struct
+{
+    uint64_t     n;
+    double       mean;                              //< Welford.
+    double       m2;
+    double       cusumPos;
+    double       cusumNeg;
+    double       ewma;
+    double       slope;                             //< EWMA of the first difference.
+    double       prevResid;
+    double       prevValue;
+    double       prevRef;
+    unsigned int driftRun;
+    unsigned int stuckRun;
+} residualChannel_t;
+
+typedef struct
+{
+    const residualCfg_t* cfg;
+    unsigned int         numChannels;
+    residualChannel_t    ch[residualMaxChannels];
+    uint32_t             faults;                    //< residualFault_e bits seen on any channel, latched.
+    unsigned int         faultChannel;              //< First channel that raised a fault.
+} residualUnit_t;
+
+/* cfg is referenced, not copied. Returns -1 on bad arguments. */
+int initResidualUnit(residualUnit_t* unit, const residualCfg_t* cfg, unsigned int numChannels);
+
+/* 
+ * Feed one sample of the unit and the reference it is judged against, e.g. the voted value.
+ * Non finite inputs are skipped. Returns the fault bits raised by this sample, 0 if none new.
+ */
+uint32_t updateResidualUnit(residualUnit_t* unit, const double* value, const double* ref);
+
+/* Running standard deviation of a channel residual. */
+double getResidualStd(const residualChannel_t* ch);
+
+/* "B", "D" and "S" for bias, drift and stuck, "-" for none. buf holds at least 4 chars. */
+const char* residualFaultStr(uint32_t faults, char* buf);
+
+#endif  // __LIBINC_RESIDUALLIB_H_
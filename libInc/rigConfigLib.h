@@ -0,0 +1,53 @@
+// Rig description loaded at startup. Sensor types, unit counts, ports and input files.
+//
+//     # comment
+//     ipcAddr = 127.0.0.1
+//     actPort = 60000          # GNC actuator commands
+//     [imu]
+//     file     = ../inputData/imuSens.npy
+//     rate_Hz  = 100
+//     latency_ms = 0         # sample time to delivery
+//     units    = 3            # redundant units behind FDIR
+//     fdirPort = 50010        # unit i listens on fdirPort + i
+//     gncPort  = 60010
+//
+// Sections name sensor types the caller set up, keys left out keep the caller's defaults.
+#ifndef __LIBINC_RIGCONFIGLIB_H_
+#define __LIBINC_RIGCONFIGLIB_H_
+
+#include <stdint.h>
+
+#define rigMaxTypes 8U
+#define rigMaxPath  256U
+
+typedef struct
+{
+    const char*  name;                              //< Section name.
+    char         file[rigMaxPath];
+    double       rate_Hz;
+    double       latency_ms;                        //< Delivery lags the sample time by this much.
+    unsigned int numUnits;
+    uint16_t     fdirPort;
+    uint16_t     gncPort;
+} rigSensor_t;
+
+typedef struct
+{
+    char         ipcAddr[64];
+    uint16_t     actPort;                           //< GNC actuator command channel.
+    unsigned int numTypes;
+    rigSensor_t  sensor[rigMaxTypes];
+} rigConfig_t;
+
+/* Override the defaults in rig from the file. Returns -1 with a message naming the line on any error. */
+int loadRigConfig(rigConfig_t* rig, const char* path);
+
+/*
+ * Every FDIR port range [fdirPort, fdirPort + numUnits) must fit below 65536, stay clear of the ranges of the
+ * other sensor types and hold no GNC or actuator port. Returns -1 with a message naming the sensors otherwise.
+ */
+int checkRigPorts(const rigConfig_t* rig);
+
+void printRigConfig(const rigConfig_t* rig);
+
+#endif  // __LIBINC_RIGCONFIGLIB_H_
@@ -0,0 +1,85 @@
+// Multi-rate scheduler. Drives any number of periodic streams from one thread or a small pool of pinned threads.
+// Each worker keeps its streams in a min-heap ordered by next release, so cost per release is O(log n).
+#ifndef __LIBINC_SCHEDLIB_H_
+#define __LIBINC_SCHEDLIB_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "threadLib.h"
+
+/* 
+ * Stream callback. release_ns is the scenario time of this release.
+ * Return -1 to retire the stream, 0 to keep it.
+ */
+typedef int (*schedCallback_t)(void* ctx, uint64_t release_ns);
+
+/* 
+ * Optional gate, called before each release in place of the wall clock wait. It may block until the
+ * release is allowed. Return -1 to stop the worker.
+ */
+typedef int (*schedGate_t)(void* ctx, uint64_t release_ns);
+
+typedef struct schedStream
+{
+    struct schedStream* next;                       //< All streams, live or retired, owned by the scheduler.
+    const char*      name;
+    schedCallback_t  callback;
+    void*            ctx;
+    double           period_s;
+    uint64_t         phase_ns;                      //< Scenario time of the first release.
+    uint64_t         nextRelease_ns;
+    _Atomic uint64_t numRuns;
+    _Atomic uint64_t numOverruns;                   //< Releases still running when the next was due, paced only.
+    unsigned int     id;                            //< Tie break between equal releases, lower first.
+    unsigned int     worker;
+    double           load;                          //< Releases per second, used to balance workers.
+    timeHist_t       lateness;                      //< Wall clock lateness of each release, paced runs only.
+    timeHist_t       execTime;                      //< Wall time of each callback.
+} schedStream_t;
+
+typedef struct
+{
+    struct sched*    owner;
+    pthread_t        thread;
+    int              cpu;                           //< CPU the worker is pinned to, -1 for none.
+    schedStream_t**  heap;                          //< Live streams only.
+    unsigned int     heapSize;
+    unsigned int     heapCap;
+    double           load;
+} schedWorker_t;
+
+typedef struct sched
+{
+    schedWorker_t*   workers;
+    unsigned int     numWorkers;
+    unsigned int     numStreams;
+    schedStream_t*   streams;
+    vClock_t         clock;                         //< Scenario time to wall time. Scale 0 runs unpaced.
+    double           scale;
+    atomic_int       stop;
+    schedGate_t      gate;                          //< NULL paces by the clock.
+    void*            gateCtx;
+} sched_t;
+
+/* numWorkers threads, pinned to CPUs 0..numWorkers-1 when pin is set. scale as for vClock_t. */
+int initSched(sched_t* sch, unsigned int numWorkers, int pin, double scale);
+
+/* Add a stream before runSched. It goes to the least loaded worker. */
+schedStream_t* addSchedStream(sched_t* sch, const char* name, double rate_Hz, double phase_s,
+                              schedCallback_t callback, void* ctx);
+
+/* Gate every release through gate instead of the clock, e.g. to run in lockstep with other processes. */
+void setSchedGate(sched_t* sch, schedGate_t gate, void* ctx);
+
+/* Run until every stream retired or stopSched. Returns total releases. Blocks the caller. */
+uint64_t runSched(sched_t* sch);
+
+void stopSched(sched_t* sch);
+
+/* Per stream releases, lateness, execution time and overruns. Safe to call while running. */
+void printSchedStats(sched_t* sch);
+
+void closeSched(sched_t* sch);
+
+#endif  // __LIBINC_SCHEDLIB_H_
@@ -0,0 +1,108 @@
+// Asynchronous binary telemetry. Hot path threads log fixed size records into a ring of their own, without
+// locks, syscalls or formatting. A background thread drains all rings every few milliseconds, merges them by
+// time and either writes them to a compact file for TelemDecode or, without a file, prints them as text.
+// Events are registered once with a printf style format, which only the drain thread or the decoder expands.
+#ifndef __LIBINC_TELEMLIB_H_
+#define __LIBINC_TELEMLIB_H_
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Records per thread ring, a power of two. A full ring drops and counts rather than waits. */
+#define telemRingRecords 4096U
+#define telemMaxRings    32U
+#define telemMaxEvents   64U
+#define telemMaxArgs     2U
+#define telemNameLen     32U
+#define telemFmtLen      96U
+
+/* How often the drain thread empties the rings. */
+#define telemDrainPeriod_ms 10
+
+/* One logged event. */
+typedef struct
+{
+    uint64_t time_ns;                               //< CLOCK_MONOTONIC at the log call.
+    uint16_t event;
+    uint16_t ring;                                  //< Ring, and so thread, it was logged from.
+    uint32_t seq;                                   //< Per ring, a gap is a record dropped on a full ring.
+    uint64_t arg[telemMaxArgs];                     //< Integers, or doubles through telemF64.
+} telemRec_t;
+
+_Static_assert(sizeof(telemRec_t) == 32, "Telemetry record must stay 32 bytes.");
+
+/*
+ * Event format. Up to telemMaxArgs conversions of d i u x X o for integers or f e E g G for doubles, flags,
+ * width and precision allowed, length modifiers ignored. Arguments are taken in order.
+ */
+typedef struct
+{
+    uint32_t id;
+    char     name[telemNameLen];
+    char     fmt[telemFmtLen];
+} telemEventDef_t;
+
+/*
+ * File layout: telemFileHdr_t, then chunks, each a telemChunk_t followed by size bytes. Event chunks hold one
+ * telemEventDef_t and come before the first record of that event. Record chunks hold telemRec_t, in time
+ * order within a chunk.
+ */
+#define telemMagic   "TECTELEM"
+#define telemVersion 1U
+
+typedef struct
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t recSize;
+    uint64_t start_ns;                              //< CLOCK_MONOTONIC when the log was opened.
+} telemFileHdr_t;
+
+typedef enum
+{
+    telemChunkEvent   = 1,
+    telemChunkRecords = 2
+} telemChunkKind_e;
+
+typedef struct
+{
+    uint32_t kind;
+    uint32_t size;
+} telemChunk_t;
+
+/*
+ * Start the drain thread. With TEC_TELEM_DIR set, records go to <dir>/<app>.tlm, otherwise they are printed
+ * as text to stdout. Returns -1 if the file cannot be created. Until then, and after closeTelem, logging is a
+ * no-op.
+ */
+int openTelem(const char* app);
+
+/* Register an event, or look up one of the same name. Returns its id, -1 on a bad format or a full table. */
+int telemEvent(const char* name, const char* fmt);
+
+/* Log one record. The first call of a thread claims its ring. Safe from any thread, never blocks. */
+void telemLog(int event, uint64_t arg0, uint64_t arg1);
+
+/* Carry a double in a record argument. */
+static inline uint64_t telemF64(double v)
+{
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    return u;
+}
+
+/* Final drain, then stop the thread and close the file. */
+void closeTelem(void);
+
+/* Records logged, dropped and written. */
+void printTelemStats(void);
+
+/* Expand a record with the format of its event. Returns the length, as snprintf. */
+int formatTelemRec(const telemEventDef_t* def, const telemRec_t* rec, char* buf, size_t size);
+
+/* Check a format against the rules above. Returns its number of conversions, -1 if not usable. */
+int checkTelemFmt(const char* fmt);
+
+#endif  // __LIBINC_TELEMLIB_H_
@@ -3,18 +3,46 @@
 #define __LIBINC_THREADLIB_H_
 
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <time.h>           // nanosleep Function
 
+/* Log2 histogram of durations. Bucket k counts [2^(k-1), 2^k) ns, bucket 0 counts 0 ns. */
+#define timeHistNumBuckets 40U
+
 typedef struct
 {
-    pthread_t        taskThread;
-    struct timespec  taskPeriod;
-}task_t;
+    _Atomic uint64_t count[timeHistNumBuckets];
+    _Atomic uint64_t numSamples;
+    _Atomic uint64_t sum_ns;
+    _Atomic uint64_t max_ns;
+} timeHist_t;
+
+/* Virtual clock. Maps scenario time onto wall time at a fixed speed factor. */
+typedef struct
+{
+    struct timespec  start;                         //< Wall time of scenario time 0.
+    double           scale;                         //< Scenario seconds per wall second. 0 runs unpaced.
+} vClock_t;
+
+/* Histogram helpers. */
+void initTimeHist(timeHist_t *hist);
+
+void addTimeHist(timeHist_t *hist, uint64_t ns);
+
+/* Upper bound of the bucket holding the given fraction (0..1) of samples. */
+uint64_t getTimeHistPercentile(const timeHist_t *hist, double fraction);
+
+/* Monotonic time in ns. */
+uint64_t getTimeNs(void);
+
+/* Start a virtual clock at scenario time 0, now. */
+void initVClock(vClock_t *clk, double scale);
 
-/* Utility Function to set task period. */
-void setTaskPeriod(task_t *taskInfo, double freq);
+/* Monotonic wall time in ns that corresponds to simTime_ns. */
+uint64_t vClockToWallNs(vClock_t *clk, uint64_t simTime_ns);
 
-/* Utility Function to sleep. */
-int threadSleep(task_t *taskInfo);
+/* Sleep until the wall time that corresponds to simTime_ns. Returns at once when unpaced or already late. */
+int vClockWaitUntil(vClock_t *clk, uint64_t simTime_ns);
 
-#endif  // __LIBINC_THREADLIB_H_
\ No newline at end of file
+#endif  // __LIBINC_THREADLIB_H_
@@ -0,0 +1,54 @@
+// Thruster allocation. Maps a commanded body force and torque to PWM duty cycles of unidirectional
+// thrusters. Everything that depends only on the geometry is solved once at init: for each of the twelve
+// signed unit axes of force and torque the non negative thruster forces producing it (non negative least
+// squares). At run time allocation walks that table, the command is the sum of its axes, scaled into the
+// thruster limits. Fixed cost of 6 x thrusters multiply adds.
+//
+// Geometry file, one thruster per line, body frame:
+//
+//     # x_m  y_m  z_m  dirX  dirY  dirZ  maxForce_N
+//     0.0    1.0  0.0  1.0   0.0   0.0   10.0
+#ifndef __LIBINC_THRUSTERLIB_H_
+#define __LIBINC_THRUSTERLIB_H_
+
+#include "navMathLib.h"
+
+#define thrMaxThrusters 16U
+
+/* Force x y z then torque x y z. */
+#define thrWrenchDim 6U
+
+typedef struct
+{
+    vec3_t pos_m;
+    vec3_t dir;                                     //< Unit thrust direction.
+    double maxForce_N;
+} thruster_t;
+
+typedef struct
+{
+    unsigned int numThr;
+    thruster_t   thr[thrMaxThrusters];
+    double       minDuty;                           //< Shorter pulses than this are not fired.
+    double       unit[2 * thrWrenchDim][thrMaxThrusters];   //< Forces per +axis, then per -axis.
+    int          complete;                          //< 1 when any wrench is reachable with pushing thrusters.
+} thrAlloc_t;
+
+/* Append the thrusters of a geometry file. Returns -1 with a message naming the line on any error. */
+int loadThrusterGeometry(thrAlloc_t* alloc, const char* path);
+
+/* 
+ * Solve the allocation table for the thrusters set so far. Returns -1 if they cannot act on every axis,
+ * complete is cleared if some axis is only reachable in one direction.
+ */
+int initThrusterAlloc(thrAlloc_t* alloc);
+
+/* 
+ * Duty cycles, 0 to 1, for the wrench. Unreachable wrenches are scaled down until the busiest thruster
+ * is at full duty, so the direction is kept. Fixed cost for a given number of thrusters.
+ */
+void allocateThrusters(const thrAlloc_t* alloc, const double* wrench, double* duty);
+
+void printThrusterAlloc(const thrAlloc_t* alloc);
+
+#endif  // __LIBINC_THRUSTERLIB_H_
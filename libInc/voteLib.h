@@ -0,0 +1,41 @@
+// Mid value select voting over redundant sensor units.
+// Frames are structure of arrays, one row of lanes per unit, so every step of the kernel is a
+// straight loop over voteLanes doubles that the compiler turns into packed min/max/sub.
+#ifndef __LIBINC_VOTELIB_H_
+#define __LIBINC_VOTELIB_H_
+
+#include <stdint.h>
+
+/* Unit sets are returned as 32 bit masks. */
+#define voteMaxUnits 32U
+/* Channels padded to one 64 byte line, e.g. 6 IMU or GNSS channels in 8 lanes. */
+#define voteLanes    8U
+
+typedef struct
+{
+    _Alignas(64) double in[voteMaxUnits][voteLanes];       //< Channel values, one row per unit.
+    _Alignas(64) double mid[voteLanes];                    //< Voted value per channel.
+    _Alignas(64) double absDev[voteMaxUnits][voteLanes];   //< |in - mid| per unit and channel.
+    _Alignas(64) double invTol[voteLanes];                 //< 1 / miscompare tolerance, 0 in padding lanes.
+    double              maxDev[voteMaxUnits];              //< Largest deviation of each unit, in tolerances.
+    unsigned int        numChannels;
+    unsigned int        numUnits;
+} voteFrame_t;
+
+/* tol holds numChannels tolerances, all > 0. Returns -1 on bad arguments. */
+int initVoteFrame(voteFrame_t* frame, unsigned int numChannels, const double* tol);
+
+/* Copy n channel values of one unit into lanes lane..lane+n-1. */
+void setVoteInput(voteFrame_t* frame, unsigned int unit, unsigned int lane, const double* val, unsigned int n);
+
+/* 
+ * Vote over units 0..numUnits-1. Per channel this is the median for an odd number of units and the mean
+ * of the middle two for an even number. Returns a bit mask of units deviating by more than their tolerance
+ * in any channel. Two units cannot tell which one is wrong, so both are flagged.
+ */
+uint32_t voteMidValue(voteFrame_t* frame, unsigned int numUnits);
+
+/* Unit closest to the voted value. */
+unsigned int voteBestUnit(const voteFrame_t* frame);
+
+#endif  // __LIBINC_VOTELIB_H_
@@ -0,0 +1,49 @@
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arenaLib.h"
+
+size_t arenaSizeOf(size_t size)
+{
+    return (size + arenaAlign - 1) & ~((size_t) arenaAlign - 1);
+}
+
+int initArena(arena_t* arena, size_t size)
+{
+    size        = arenaSizeOf(size);
+    arena->base = aligned_alloc(arenaAlign, size);
+    arena->size = size;
+    arena->used = 0;
+    if (arena->base == NULL)
+    {
+        perror("Arena Allocation Failed.");
+        return -1;
+    }
+    memset(arena->base, 0, size);
+    return 0;
+}
+
+void* arenaAlloc(arena_t* arena, size_t size)
+{
+    void* ptr;
+
+    size = arenaSizeOf(size);
+    if (size > (arena->size - arena->used))
+    {
+        fprintf(stderr, "Arena exhausted, %zu of %zu bytes used \n", arena->used, arena->size);
+        return NULL;
+    }
+    ptr          = arena->base + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+void closeArena(arena_t* arena)
+{
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
@@ -0,0 +1,278 @@
+//
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "captureLib.h"
+#include "threadLib.h"
+
+atomic_int captureActive = 0;
+
+/* Added to the reserved bytes on close, so every later reservation fails without a separate check. */
+#define captureClosed (1ULL << 62)
+
+/* Size of the record that did not fit. Ends the file for readers, its header was all there was room for. */
+#define captureEnd    UINT32_MAX
+
+typedef struct
+{
+    int              fd;
+    uint8_t*         base;                          //< Mapping of the whole file.
+    size_t           capacity;                      //< Record bytes the file holds.
+    char             path[256];
+    _Alignas(64) _Atomic uint64_t used;             //< Record bytes reserved, may pass capacity.
+    _Alignas(64) _Atomic uint64_t numDropped;
+    uint64_t         dataBytes;                     //< Set when closed.
+    uint64_t         numRecs;
+} capture_t;
+
+static capture_t capture = {.fd = -1};
+
+/* Records keep their headers 8 byte aligned. */
+static inline size_t captureRecSize(size_t len)
+{
+    return (sizeof(captureRec_t) + len + 7U) & ~(size_t) 7U;
+}
+
+int openCapture(const char* app)
+{
+    const char*   dir = getenv("TEC_CAPTURE_DIR");
+    const char*   mb  = getenv("TEC_CAPTURE_MB");
+    captureHdr_t* hdr;
+    size_t        fileSize;
+
+    if ((dir == NULL) || (atomic_load(&captureActive) == 1))
+    {
+        return 0;
+    }
+    capture.capacity = (size_t) ((mb != NULL) ? atoi(mb) : (int) captureDefault_MB) << 20;
+    if (capture.capacity == 0)
+    {
+        fprintf(stderr, "Capture size %s MB is not usable \n", mb);
+        return -1;
+    }
+    fileSize = captureDataOffset + capture.capacity;
+
+    snprintf(capture.path, sizeof(capture.path), "%s/%s.cap", dir, app);
+    capture.fd = open(capture.path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (capture.fd == -1)
+    {
+        perror("Capture File Open Failed.");
+        return -1;
+    }
+    if (ftruncate(capture.fd, (off_t) fileSize) == -1)
+    {
+        perror("Capture File Size Failed.");
+        close(capture.fd);
+        capture.fd = -1;
+        return -1;
+    }
+    capture.base = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, capture.fd, 0);
+    if (capture.base == MAP_FAILED)
+    {
+        perror("Capture Map Failed.");
+        close(capture.fd);
+        capture.fd   = -1;
+        capture.base = NULL;
+        return -1;
+    }
+    /* Written once now, so the first write to a page does not fault in a hot loop. */
+    for (size_t pg = 0; pg < fileSize; pg += (size_t) sysconf(_SC_PAGESIZE))
+    {
+        ((volatile uint8_t *) capture.base)[pg] = 0;
+    }
+
+    hdr = (captureHdr_t *) capture.base;
+    memcpy(hdr->magic, captureMagic, sizeof(hdr->magic));
+    hdr->version    = captureVersion;
+    hdr->recHdrSize = sizeof(captureRec_t);
+    hdr->start_ns   = getTimeNs();
+    hdr->dataBytes  = 0;
+    hdr->numDropped = 0;
+    snprintf(hdr->app, sizeof(hdr->app), "%s", app);
+
+    atomic_store(&capture.used, 0);
+    atomic_store(&capture.numDropped, 0);
+    capture.dataBytes = 0;
+    capture.numRecs   = 0;
+    atomic_store(&captureActive, 1);
+    return 0;
+}
+
+void captureWrite(uint16_t port, captureDir_e dir, uint8_t transport, const void* data, size_t len)
+{
+    size_t        size    = captureRecSize(len);
+    uint64_t      time_ns = getTimeNs();
+    uint64_t      off;
+    captureRec_t* rec;
+
+    off = atomic_fetch_add_explicit(&capture.used, size, memory_order_relaxed);
+    if ((off + size) > capture.capacity)
+    {
+        if (off < captureClosed)
+        {
+            atomic_fetch_add_explicit(&capture.numDropped, 1, memory_order_relaxed);
+        }
+        if ((off + sizeof(captureRec_t)) <= capture.capacity)
+        {
+            rec = (captureRec_t *) (capture.base + captureDataOffset + off);
+            atomic_store_explicit(&rec->size, captureEnd, memory_order_release);
+        }
+        return;
+    }
+    rec            = (captureRec_t *) (capture.base + captureDataOffset + off);
+    rec->port      = port;
+    rec->dir       = (uint8_t) dir;
+    rec->transport = transport;
+    rec->time_ns   = time_ns;
+    rec->len       = (uint32_t) len;
+    rec->reserved  = 0;
+    memcpy(rec + 1, data, len);
+    /* Complete once the size is seen. */
+    atomic_store_explicit(&rec->size, (uint32_t) size, memory_order_release);
+}
+
+void closeCapture(void)
+{
+    captureHdr_t* hdr = (captureHdr_t *) capture.base;
+    uint64_t      used;
+
+    if (atomic_exchange(&captureActive, 0) == 0)
+    {
+        return;
+    }
+    used = atomic_fetch_add(&capture.used, captureClosed);
+    if (used > capture.capacity)
+    {
+        /* The reservation that overflowed was never written, nor anything after it. */
+        used = capture.capacity;
+    }
+
+    /* Reservations below used were all granted. Wait for writers still copying, then count. */
+    for (uint64_t off = 0; (off + sizeof(captureRec_t)) <= used;)
+    {
+        const captureRec_t* rec = (const captureRec_t *) (capture.base + captureDataOffset + off);
+        uint32_t            size;
+
+        while ((size = atomic_load_explicit(&rec->size, memory_order_acquire)) == 0)
+        {
+            sched_yield();
+        }
+        if (size == captureEnd)
+        {
+            break;
+        }
+        capture.numRecs++;
+        off += size;
+    }
+    capture.dataBytes = used;
+    hdr->dataBytes    = used;
+    hdr->numDropped   = atomic_load(&capture.numDropped);
+
+    munmap(capture.base, captureDataOffset + capture.capacity);
+    capture.base = NULL;
+    if (ftruncate(capture.fd, (off_t) (captureDataOffset + used)) == -1)
+    {
+        perror("Capture File Trim Failed.");
+    }
+    close(capture.fd);
+    capture.fd = -1;
+}
+
+void printCaptureStats(void)
+{
+    if (capture.path[0] == '\0')
+    {
+        return;
+    }
+    printf("Capture: %lu messages, %lu bytes to %s, %lu dropped \n", (unsigned long) capture.numRecs,
+           (unsigned long) capture.dataBytes, capture.path, (unsigned long) atomic_load(&capture.numDropped));
+}
+
+int mapCapture(const char* path, captureMap_t* map)
+{
+    struct stat st;
+    int         fd;
+
+    map->base = NULL;
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        perror("Capture Open Failed.");
+        return -1;
+    }
+    if ((fstat(fd, &st) == -1) || ((size_t) st.st_size < captureDataOffset))
+    {
+        fprintf(stderr, "%s is too short for a capture \n", path);
+        close(fd);
+        return -1;
+    }
+    map->size = (size_t) st.st_size;
+    map->base = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+    /* The mapping keeps the file referenced. */
+    close(fd);
+    if (map->base == MAP_FAILED)
+    {
+        perror("Capture Map Failed.");
+        map->base = NULL;
+        return -1;
+    }
+    madvise(map->base, map->size, MADV_SEQUENTIAL);
+
+    map->hdr = (const captureHdr_t *) map->base;
+    if ((memcmp(map->hdr->magic, captureMagic, sizeof(map->hdr->magic)) != 0) ||
+        (map->hdr->version != captureVersion) || (map->hdr->recHdrSize != sizeof(captureRec_t)))
+    {
+        fprintf(stderr, "%s is not a version %u capture \n", path, captureVersion);
+        unmapCapture(map);
+        return -1;
+    }
+    /* A capture never closed runs up to its first unfinished record. */
+    map->dataBytes = map->size - captureDataOffset;
+    if ((map->hdr->dataBytes > 0) && (map->hdr->dataBytes < map->dataBytes))
+    {
+        map->dataBytes = map->hdr->dataBytes;
+    }
+    return 0;
+}
+
+const captureRec_t* nextCaptureRec(const captureMap_t* map, const captureRec_t* prev)
+{
+    const uint8_t*      data = (const uint8_t *) map->base + captureDataOffset;
+    size_t              off  = 0;
+    const captureRec_t* rec;
+    uint32_t            size;
+
+    if (prev != NULL)
+    {
+        off = (size_t) ((const uint8_t *) prev - data) + atomic_load_explicit(&prev->size, memory_order_relaxed);
+    }
+    if ((off + sizeof(captureRec_t)) > map->dataBytes)
+    {
+        return NULL;
+    }
+    rec  = (const captureRec_t *) (data + off);
+    size = atomic_load_explicit(&rec->size, memory_order_acquire);
+    if ((size < captureRecSize(rec->len)) || ((off + size) > map->dataBytes))
+    {
+        return NULL;
+    }
+    return rec;
+}
+
+int unmapCapture(captureMap_t* map)
+{
+    int ret = 0;
+
+    if (map->base != NULL)
+    {
+        ret = munmap(map->base, map->size);
+        map->base = NULL;
+    }
+    return ret;
+}
@@ -0,0 +1,173 @@
+// Values of the constants declared in config.h.
+#include "config.h"
+
+/* Constants for file Names. */
+char imuFileName[]  = "../inputData/imuSens.npy";
+char gnssFileName[] = "../inputData/gnssSens.npy";
+char strFileName[]  = "../inputData/strSens.npy";
+
+const char inFp[3][30] = {
+                        "../inputData/imuSens.npy",
+                        "../inputData/gnssSens.npy",
+                        "../inputData/strSens.npy"
+                    };
+
+/* Sensor names indexed by sensorIn_e, for reports, and their rig file sections. */
+const char* const sensorNames[numGncSensorIf]   = {"IMU", "GNSS", "STR"};
+const char* const sensorSections[numGncSensorIf] = {"imu", "gnss", "str"};
+
+/* Sample rates the scenario data was generated at, see inputData/scenarioAerocapture.py. */
+const double    imuRate_Hz     = 100.0;
+const double    gnssRate_Hz    = 40.0;
+const double    strRate_Hz     = 1.0;
+
+/* Delivery latency behind the sample time. GNSS and star tracker solutions take a while to compute. */
+const double    imuLatency_ms  = 0.0;
+const double    gnssLatency_ms = 50.0;
+const double    strLatency_ms  = 150.0;
+
+/* IPC Address and Port Definitions. */
+const char      IPCAddr[]      = "127.0.0.1";
+const uint16_t  ImuIpcPort     = 60010;
+const uint16_t  GnssIpcPort    = 60020;
+const uint16_t  StrIpcPort     = 60030;
+const uint16_t  ActIpcPort     = 60000;
+
+const uint16_t  imuFdirPort    = 50010;
+const uint16_t  gnssFdirPort   = 50020;
+const uint16_t  strFdirPort    = 50030;
+
+/* Shared memory table of the latest voted sample per sensor, published by FDIR. */
+const char      latestTableName[] = "/tecLatest";
+
+/* Lockstep co-simulation, see lockstepLib.h. Stages run in this order every tick. */
+const char      lockstepName[]    = "/tecLockstep";
+
+const char* const stepStageNames[numStepStages] = {"sensors", "fdir", "gnc"};
+
+/* How long a member waits for the coordinator to come up. */
+const int       lockstepJoinTimeout_ms = 10000;
+
+/* Utility Functions. */
+
+/* 
+ * Rig description of this run. Starts from the constants above, then the file named by TEC_RIG_CONFIG,
+ * if set, overrides them. Every process of a run must see the same file. Returns -1 on a bad file or ports
+ * that collide.
+ */
+int initRigConfig(rigConfig_t* rig)
+{
+    const char*    path       = getenv("TEC_RIG_CONFIG");
+    const double   rate[]     = {imuRate_Hz, gnssRate_Hz, strRate_Hz};
+    const double   latency[]  = {imuLatency_ms, gnssLatency_ms, strLatency_ms};
+    const uint16_t fdirPort[] = {imuFdirPort, gnssFdirPort, strFdirPort};
+    const uint16_t gncPort[]  = {ImuIpcPort, GnssIpcPort, StrIpcPort};
+
+    memset(rig, 0, sizeof(*rig));
+    snprintf(rig->ipcAddr, sizeof(rig->ipcAddr), "%s", IPCAddr);
+    rig->actPort  = ActIpcPort;
+    rig->numTypes = numGncSensorIf;
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        rig->sensor[i].name       = sensorSections[i];
+        rig->sensor[i].rate_Hz    = rate[i];
+        rig->sensor[i].latency_ms = latency[i];
+        rig->sensor[i].numUnits   = defaultUnitsPerSensor;
+        rig->sensor[i].fdirPort   = fdirPort[i];
+        rig->sensor[i].gncPort    = gncPort[i];
+        snprintf(rig->sensor[i].file, sizeof(rig->sensor[i].file), "%s", inFp[i]);
+    }
+
+    if ((path != NULL) && (loadRigConfig(rig, path) == -1))
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        if (rig->sensor[i].numUnits > maxUnitsPerSensor)
+        {
+            fprintf(stderr, "%s: %u units, at most %u supported \n", sensorNames[i], rig->sensor[i].numUnits,
+                    maxUnitsPerSensor);
+            return -1;
+        }
+    }
+    return checkRigPorts(rig);
+}
+
+/* Default thrusters: for each axis four, two pushing each way, offset along the next axis by this arm. */
+const double    thrusterArm_m      = 1.0;
+const double    thrusterForce_N    = 10.0;
+/* Shortest pulse, as a fraction of the GNC control period. */
+const double    thrusterMinDuty    = 0.02;
+
+/* 
+ * Thruster geometry and allocation of this run. Default set above unless TEC_THRUSTER_CONFIG names a
+ * geometry file. Returns -1 on a bad file or a set that cannot act on every axis.
+ */
+int initThrusterConfig(thrAlloc_t* alloc)
+{
+    const char* path = getenv("TEC_THRUSTER_CONFIG");
+
+    memset(alloc, 0, sizeof(*alloc));
+    alloc->minDuty = thrusterMinDuty;
+    if (path != NULL)
+    {
+        if (loadThrusterGeometry(alloc, path) == -1)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        for (unsigned int a = 0; a < 3; a++)
+        {
+            for (unsigned int k = 0; k < 4; k++)
+            {
+                thruster_t* t = &alloc->thr[alloc->numThr++];
+
+                memset(t, 0, sizeof(*t));
+                t->pos_m.v[(a + 1) % 3] = ((k & 1U) == 0) ? thrusterArm_m : -thrusterArm_m;
+                t->dir.v[a]             = ((k & 2U) == 0) ? 1.0 : -1.0;
+                t->maxForce_N           = thrusterForce_N;
+            }
+        }
+    }
+    if (alloc->numThr > maxNumActuators)
+    {
+        fprintf(stderr, "%u thrusters, at most %u supported \n", alloc->numThr, maxNumActuators);
+        return -1;
+    }
+    return initThrusterAlloc(alloc);
+}
+
+/* FDIR voting. Lanes 0-2 hold velInc or position, 3-5 angInc or velocity. */
+const double imuVoteTol[fdirVoteChannels]  = {0.5, 0.5, 0.5, 0.02, 0.02, 0.02};     //< m/s^2, rad/s
+const double gnssVoteTol[fdirVoteChannels] = {25.0, 25.0, 25.0, 0.5, 0.5, 0.5};     //< m, m/s
+
+/* Residual detectors. Noise at a fifth of the vote tolerance, bias of 1 sigma found in about 16 samples. */
+const residualCfg_t imuResidualCfg  = {{0.1, 0.1, 0.1, 0.004, 0.004, 0.004}, 0.5, 8.0, 1.0 / 64.0, 3.0, 10U};
+const residualCfg_t gnssResidualCfg = {{5.0, 5.0, 5.0, 0.1, 0.1, 0.1}, 0.5, 8.0, 1.0 / 32.0, 3.0, 10U};
+
+/* 
+ * GNC navigation noise as seen on the scenario data. The IMU saturates in the aerocapture, hence the large
+ * force noise.
+ */
+const eskfCfg_t      gncKfCfg  = {2.0, 1e-3, 1e-3, 1e-5, {10.0, 1.0, 0.01, 0.1, 1e-3}, 6.0};
+const navFilterCfg_t gncNavCfg = {&gncKfCfg, 25.0, 0.25, 1e-4};
+
+/* GNC rate damping gain, N m s. */
+const double         gncRateGain = 20.0;
+
+void setSensorLatency(sensorConfig_t* sCfg, double imuMs, double gnssMs, double strMs)
+{
+    sCfg->imuConf.latency_ms  = imuMs;
+    sCfg->gnssConf.latency_ms = gnssMs;
+    sCfg->strConf.latency_ms  = strMs;
+}
+
+void setSensorRates(sensorConfig_t* sCfg, double imuHz, double gnssHz, double strHz)
+{
+    sCfg->imuConf.samplingRate  = imuHz;
+    sCfg->gnssConf.samplingFreq = gnssHz;
+    sCfg->strConf.samplingFreq  = strHz;
+}
@@ -0,0 +1,282 @@
+//
+#include <math.h>
+#include <string.h>
+
+#include "eskfLib.h"
+
+#define N eskfNumStates
+
+void initEskf(eskf_t* kf, const eskfCfg_t* cfg)
+{
+    memset(kf, 0, sizeof(*kf));
+    kf->cfg = cfg;
+    for (unsigned int i = 0; i < N; i++)
+    {
+        double s = cfg->initSigma[i / 3];
+        kf->P[i][i] = s * s;
+    }
+}
+
+void eskfCorrectImu(const eskf_t* kf, vec3_t* dTheta, vec3_t* dVel, double dt)
+{
+    *dTheta = vec3Sub(*dTheta, vec3Scale(kf->gyroBias, dt));
+    *dVel   = vec3Sub(*dVel, vec3Scale(kf->accBias, dt));
+}
+
+/* out rows [rowOut, rowOut + 3) += B * M rows [rowIn, rowIn + 3). */
+static void eskfBlockMulAdd(double out[N][N], unsigned int rowOut, const mat3_t* b, double m[N][N], unsigned int rowIn)
+{
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            double bik = b->m[i][k];
+            for (unsigned int j = 0; j < N; j++)
+            {
+                out[rowOut + i][j] += bik * m[rowIn + k][j];
+            }
+        }
+    }
+}
+
+/* 
+ * out = Phi * m for the transition over one step. Phi is the identity apart from
+ *     pos <- vel dt,   vel <- G dt pos, -[a]x dt att, -C dt accB,   att <- -C dt gyroB.
+ */
+static void eskfPhiRows(double out[N][N], double m[N][N], const mat3_t* gdt, const mat3_t* adt, const mat3_t* cdt,
+                        double dt)
+{
+    memcpy(out, m, sizeof(double) * N * N);
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        for (unsigned int j = 0; j < N; j++)
+        {
+            out[eskfPos + i][j] += dt * m[eskfVel + i][j];
+        }
+    }
+    eskfBlockMulAdd(out, eskfVel, gdt, m, eskfPos);
+    eskfBlockMulAdd(out, eskfVel, adt, m, eskfAtt);
+    eskfBlockMulAdd(out, eskfVel, cdt, m, eskfAccB);
+    eskfBlockMulAdd(out, eskfAtt, cdt, m, eskfGyroB);
+}
+
+static void eskfSymmetrize(double p[N][N])
+{
+    for (unsigned int i = 0; i < N; i++)
+    {
+        for (unsigned int j = i + 1; j < N; j++)
+        {
+            double s = 0.5 * (p[i][j] + p[j][i]);
+            p[i][j]  = s;
+            p[j][i]  = s;
+        }
+    }
+}
+
+void eskfPropagate(eskf_t* kf, const navState_t* nav, vec3_t dVel, double dt)
+{
+    const eskfCfg_t* cfg = kf->cfg;
+    double           m[N][N];
+    double           mt[N][N];
+    mat3_t           c   = quatToMat(nav->q_ib);
+    vec3_t           a   = mat3MulVec(&c, dVel);
+    double           r2  = vec3Dot(nav->pos_m, nav->pos_m);
+    double           k   = nav->mu_m3_s2 / (r2 * sqrt(r2)) * dt;
+    mat3_t           gdt;
+    mat3_t           adt = {{{0.0, a.v[2], -a.v[1]}, {-a.v[2], 0.0, a.v[0]}, {a.v[1], -a.v[0], 0.0}}};
+    mat3_t           cdt;
+
+    /* Specific force coupling -[f]x dt with f the inertial specific force, i.e. -[C dVel]x. */
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        for (unsigned int j = 0; j < 3; j++)
+        {
+            /* Gravity gradient mu / r^3 (3 r r' / r^2 - I). */
+            gdt.m[i][j] = k * (3.0 * nav->pos_m.v[i] * nav->pos_m.v[j] / r2 - ((i == j) ? 1.0 : 0.0));
+            cdt.m[i][j] = -c.m[i][j] * dt;
+        }
+    }
+
+    /* P = Phi P Phi' as Phi (Phi P)', P is symmetric. */
+    eskfPhiRows(m, kf->P, &gdt, &adt, &cdt, dt);
+    for (unsigned int i = 0; i < N; i++)
+    {
+        for (unsigned int j = 0; j < N; j++)
+        {
+            mt[i][j] = m[j][i];
+        }
+    }
+    eskfPhiRows(kf->P, mt, &gdt, &adt, &cdt, dt);
+
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        kf->P[eskfVel + i][eskfVel + i]     += cfg->accNoise * cfg->accNoise * dt;
+        kf->P[eskfAtt + i][eskfAtt + i]     += cfg->gyroNoise * cfg->gyroNoise * dt;
+        kf->P[eskfAccB + i][eskfAccB + i]   += cfg->accBiasWalk * cfg->accBiasWalk * dt;
+        kf->P[eskfGyroB + i][eskfGyroB + i] += cfg->gyroBiasWalk * cfg->gyroBiasWalk * dt;
+    }
+    eskfSymmetrize(kf->P);
+}
+
+/* Cholesky factor of the m x m matrix s in place, lower triangle. Returns -1 if not positive definite. */
+static int eskfCholesky(double s[eskfMaxMeas][eskfMaxMeas], unsigned int m)
+{
+    for (unsigned int j = 0; j < m; j++)
+    {
+        double d = s[j][j];
+        for (unsigned int k = 0; k < j; k++)
+        {
+            d -= s[j][k] * s[j][k];
+        }
+        if (!(d > 0.0))
+        {
+            return -1;
+        }
+        s[j][j] = sqrt(d);
+        for (unsigned int i = j + 1; i < m; i++)
+        {
+            double v = s[i][j];
+            for (unsigned int k = 0; k < j; k++)
+            {
+                v -= s[i][k] * s[j][k];
+            }
+            s[i][j] = v / s[j][j];
+        }
+    }
+    return 0;
+}
+
+/* Solve L L' x = b in place with the factor of eskfCholesky. */
+static void eskfCholSolve(double l[eskfMaxMeas][eskfMaxMeas], unsigned int m, double* b)
+{
+    for (unsigned int i = 0; i < m; i++)
+    {
+        for (unsigned int k = 0; k < i; k++)
+        {
+            b[i] -= l[i][k] * b[k];
+        }
+        b[i] /= l[i][i];
+    }
+    for (unsigned int i = m; i-- > 0;)
+    {
+        for (unsigned int k = i + 1; k < m; k++)
+        {
+            b[i] -= l[k][i] * b[k];
+        }
+        b[i] /= l[i][i];
+    }
+}
+
+int eskfUpdateBlock(eskf_t* kf, navState_t* nav, unsigned int first, unsigned int m, const double* y,
+                    const double* r)
+{
+    double s[eskfMaxMeas][eskfMaxMeas];
+    double hp[eskfMaxMeas][N];                      //< H P, rows first..first + m of P.
+    double k[N][eskfMaxMeas];
+    double sy[eskfMaxMeas];
+    double dx[N];
+    double nis = 0.0;
+
+    if ((m > eskfMaxMeas) || (first + m > N))
+    {
+        return -1;
+    }
+    /* H selects states, so H P H' + R is a diagonal block of P plus R. */
+    for (unsigned int i = 0; i < m; i++)
+    {
+        for (unsigned int j = 0; j < m; j++)
+        {
+            s[i][j] = kf->P[first + i][first + j];
+        }
+        s[i][i] += r[i];
+        memcpy(hp[i], kf->P[first + i], sizeof(hp[i]));
+        sy[i] = y[i];
+    }
+    if (eskfCholesky(s, m) == -1)
+    {
+        kf->numRejected++;
+        return -1;
+    }
+
+    /* Gate on the normalised innovation squared. */
+    eskfCholSolve(s, m, sy);
+    for (unsigned int i = 0; i < m; i++)
+    {
+        nis += y[i] * sy[i];
+    }
+    if (nis > kf->cfg->gateSigma * kf->cfg->gateSigma * (double) m)
+    {
+        kf->numRejected++;
+        return -1;
+    }
+
+    /* K = P H' S^-1, row i solves S k = (H P)' column i. dx = K y = P H' S^-1 y. */
+    for (unsigned int i = 0; i < N; i++)
+    {
+        dx[i] = 0.0;
+        for (unsigned int j = 0; j < m; j++)
+        {
+            k[i][j] = hp[j][i];
+            dx[i]  += hp[j][i] * sy[j];
+        }
+        eskfCholSolve(s, m, k[i]);
+    }
+
+    /* P -= K H P. */
+    for (unsigned int i = 0; i < N; i++)
+    {
+        for (unsigned int c = 0; c < m; c++)
+        {
+            double kic = k[i][c];
+            for (unsigned int j = 0; j < N; j++)
+            {
+                kf->P[i][j] -= kic * hp[c][j];
+            }
+        }
+    }
+    eskfSymmetrize(kf->P);
+
+    /* Fold the error into the nominal state, the error estimate is zero again. */
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        nav->pos_m.v[i]    += dx[eskfPos + i];
+        nav->vel_m_s.v[i]  += dx[eskfVel + i];
+        kf->accBias.v[i]   += dx[eskfAccB + i];
+        kf->gyroBias.v[i]  += dx[eskfGyroB + i];
+    }
+    nav->q_ib = quatNormalize(quatMul(quatFromRotVec((vec3_t) {{dx[eskfAtt], dx[eskfAtt + 1], dx[eskfAtt + 2]}}),
+                                      nav->q_ib));
+    kf->numUpdates++;
+    return 0;
+}
+
+int eskfUpdateGnss(eskf_t* kf, navState_t* nav, vec3_t pos_m, vec3_t vel_m_s, double posVar, double velVar)
+{
+    double y[6];
+    double r[6];
+
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        y[i]     = pos_m.v[i] - nav->pos_m.v[i];
+        y[3 + i] = vel_m_s.v[i] - nav->vel_m_s.v[i];
+        r[i]     = posVar;
+        r[3 + i] = velVar;
+    }
+    return eskfUpdateBlock(kf, nav, eskfPos, 6, y, r);
+}
+
+int eskfUpdateAttitude(eskf_t* kf, navState_t* nav, quat_t q_ib, double attVar)
+{
+    quat_t inv = {{nav->q_ib.q[0], -nav->q_ib.q[1], -nav->q_ib.q[2], -nav->q_ib.q[3]}};
+    quat_t dq  = quatMul(q_ib, inv);
+    double sgn = (dq.q[0] < 0.0) ? -2.0 : 2.0;      //< q and -q are the same attitude.
+    double y[3];
+    double r[3];
+
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        y[i] = sgn * dq.q[1 + i];
+        r[i] = attVar;
+    }
+    return eskfUpdateBlock(kf, nav, eskfAtt, 3, y, r);
+}
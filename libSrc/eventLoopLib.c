@@ -0,0 +1,163 @@
+//
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "eventLoopLib.h"
+
+int initEventLoop(eventLoop_t* loop)
+{
+    loop->epollFd    = epoll_create1(EPOLL_CLOEXEC);
+    loop->running    = 0;
+    loop->numSources = 0;
+    loop->sources    = NULL;
+    if (loop->epollFd == -1)
+    {
+        perror("Epoll Creation Failed.");
+        return -1;
+    }
+    return 0;
+}
+
+static eventSource_t* addSource(eventLoop_t* loop, int fd, int isTimer, eventHandler_t handler, void* ctx)
+{
+    struct epoll_event ev;
+    eventSource_t*     src;
+
+    /* Sources live as long as the loop, the epoll entry points straight at them. */
+    src = (eventSource_t *) calloc(1, sizeof(eventSource_t));
+    if (src == NULL)
+    {
+        return NULL;
+    }
+    src->fd      = fd;
+    src->isTimer = isTimer;
+    src->handler = handler;
+    src->ctx     = ctx;
+
+    ev.events   = EPOLLIN | EPOLLET;
+    ev.data.ptr = src;
+    if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &ev) == -1)
+    {
+        perror("Epoll Add Failed.");
+        free(src);
+        return NULL;
+    }
+    src->next     = loop->sources;
+    loop->sources = src;
+    loop->numSources++;
+    return src;
+}
+
+eventSource_t* addEventFd(eventLoop_t* loop, int fd, eventHandler_t handler, void* ctx)
+{
+    return addSource(loop, fd, 0, handler, ctx);
+}
+
+eventSource_t* addEventIPC(eventLoop_t* loop, ipcConfig_t* cfg, eventHandler_t handler, void* ctx)
+{
+    if (setIpcNonBlocking(cfg) == -1)
+    {
+        return NULL;
+    }
+    return addSource(loop, cfg->ipcSock, 0, handler, ctx);
+}
+
+eventSource_t* addEventTimer(eventLoop_t* loop, double freq, eventHandler_t handler, void* ctx)
+{
+    struct itimerspec spec;
+    eventSource_t*    src;
+    double            period = 1 / freq;
+    int               fd;
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1)
+    {
+        perror("Timer Creation Failed.");
+        return NULL;
+    }
+    spec.it_interval.tv_sec  = (time_t) period;
+    spec.it_interval.tv_nsec = (long) ((period - (double) spec.it_interval.tv_sec) * 1000000000);
+    spec.it_value            = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, NULL) == -1)
+    {
+        perror("Timer Setup Failed.");
+        close(fd);
+        return NULL;
+    }
+
+    src = addSource(loop, fd, 1, handler, ctx);
+    if (src == NULL)
+    {
+        close(fd);
+    }
+    return src;
+}
+
+int stepEventLoop(eventLoop_t* loop, int timeoutMs)
+{
+    struct epoll_event ev[eventLoopMaxEvents];
+    int                numEv;
+
+    numEv = epoll_wait(loop->epollFd, ev, eventLoopMaxEvents, timeoutMs);
+    if (numEv == -1)
+    {
+        return (errno == EINTR) ? 0 : -1;
+    }
+
+    for (int i = 0; i < numEv; i++)
+    {
+        eventSource_t* src = (eventSource_t *) ev[i].data.ptr;
+
+        if (src->isTimer == 1)
+        {
+            uint64_t expired;
+            /* One call per wakeup. Expirations lost to a late wakeup are only counted. */
+            if (read(src->fd, &expired, sizeof(expired)) != (ssize_t) sizeof(expired))
+            {
+                continue;
+            }
+            src->numExpired += expired;
+            src->numMissed  += expired - 1;
+        }
+        src->handler(src->ctx);
+    }
+    return numEv;
+}
+
+int runEventLoop(eventLoop_t* loop)
+{
+    loop->running = 1;
+    while (loop->running == 1)
+    {
+        if (stepEventLoop(loop, -1) == -1)
+        {
+            perror("Epoll Wait Failed.");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void stopEventLoop(eventLoop_t* loop)
+{
+    loop->running = 0;
+}
+
+int closeEventLoop(eventLoop_t* loop)
+{
+    while (loop->sources != NULL)
+    {
+        eventSource_t* src = loop->sources;
+        loop->sources = src->next;
+        if (src->isTimer == 1)
+        {
+            close(src->fd);
+        }
+        free(src);
+    }
+    loop->numSources = 0;
+    return close(loop->epollFd);
+}
@@ -0,0 +1,340 @@
+//
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "faultLib.h"
+
+static const char* const faultKindNames[numFaultKinds] = {"bias", "drift", "noise", "stuck",
+                                                          "dropout", "duplicate", "reorder", "delay"};
+
+void initFaultScript(faultScript_t* script, const char* const* names, unsigned int numTypes)
+{
+    memset(script, 0, sizeof(*script));
+    script->numTypes = (numTypes > faultMaxTypes) ? faultMaxTypes : numTypes;
+    for (unsigned int t = 0; t < script->numTypes; t++)
+    {
+        script->type[t].name = names[t];
+    }
+}
+
+int addFault(faultScript_t* script, unsigned int type, const fault_t* fault)
+{
+    faultList_t* list;
+
+    if (type >= script->numTypes)
+    {
+        return -1;
+    }
+    list = &script->type[type];
+    if (list->numFaults == faultMaxPerSensor)
+    {
+        return -1;
+    }
+    list->fault[list->numFaults++] = *fault;
+    return 0;
+}
+
+/* One script line into a fault. Returns the sensor type, -1 on error. */
+static int parseFault(const faultScript_t* script, const char* line, fault_t* fault)
+{
+    char   type[16];
+    char   kind[16];
+    double start_s;
+    double duration_s;
+    int    numTok;
+    int    t;
+
+    memset(fault, 0, sizeof(*fault));
+    fault->channel = -1;
+    numTok = sscanf(line, "%15s %u %15s %lf %lf %lf %d", type, &fault->unit, kind, &start_s, &duration_s,
+                    &fault->magnitude, &fault->channel);
+    if ((numTok < 5) || (start_s < 0.0) || (duration_s < 0.0) || (fault->channel >= (int) faultMaxChannels))
+    {
+        return -1;
+    }
+    fault->start_ns = (uint64_t) (start_s * 1e9);
+    fault->end_ns   = (duration_s > 0.0) ? (uint64_t) ((start_s + duration_s) * 1e9) : UINT64_MAX;
+
+    fault->kind = numFaultKinds;
+    for (unsigned int k = 0; k < numFaultKinds; k++)
+    {
+        if (strcmp(kind, faultKindNames[k]) == 0)
+        {
+            fault->kind = (faultKind_e) k;
+        }
+    }
+    if (fault->kind == numFaultKinds)
+    {
+        return -1;
+    }
+    for (t = 0; t < (int) script->numTypes; t++)
+    {
+        if (strcmp(type, script->type[t].name) == 0)
+        {
+            return t;
+        }
+    }
+    return -1;
+}
+
+int loadFaultScript(faultScript_t* script, const char* path)
+{
+    FILE*        fp;
+    char         line[256];
+    unsigned int lineNum = 0;
+    int          ret     = 0;
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        perror("Fault Script Open Failed.");
+        return -1;
+    }
+
+    while ((ret == 0) && (fgets(line, sizeof(line), fp) != NULL))
+    {
+        char*   str = line;
+        char*   hash;
+        fault_t fault;
+        int     type;
+
+        lineNum++;
+        hash = strchr(str, '#');
+        if (hash != NULL)
+        {
+            *hash = '\0';
+        }
+        while (isspace((unsigned char) *str))
+        {
+            str++;
+        }
+        if (*str == '\0')
+        {
+            continue;
+        }
+
+        type = parseFault(script, str, &fault);
+        if (type == -1)
+        {
+            fprintf(stderr, "%s:%u: expected type unit kind start_s duration_s [magnitude] [channel] \n", path,
+                    lineNum);
+            ret = -1;
+        }
+        else if (addFault(script, (unsigned int) type, &fault) == -1)
+        {
+            fprintf(stderr, "%s:%u: more than %u faults for %s \n", path, lineNum, faultMaxPerSensor,
+                    script->type[type].name);
+            ret = -1;
+        }
+    }
+    fclose(fp);
+    return ret;
+}
+
+int initFaultSensor(faultSensor_t* fs, const faultList_t* list, faultUnit_t* units, unsigned int numUnits,
+                    uint64_t seed)
+{
+    for (unsigned int f = 0; f < list->numFaults; f++)
+    {
+        if (list->fault[f].unit >= numUnits)
+        {
+            fprintf(stderr, "%s %s fault on unit %u, there are %u units \n", list->name,
+                    faultKindNames[list->fault[f].kind], list->fault[f].unit, numUnits);
+            return -1;
+        }
+    }
+    fs->list     = list;
+    fs->unit     = units;
+    fs->numUnits = numUnits;
+    fs->rng      = (seed != 0) ? seed : 0x9E3779B97F4A7C15ULL;
+    fs->noise    = NULL;
+    for (unsigned int k = 0; k < numFaultKinds; k++)
+    {
+        atomic_init(&fs->numHit[k], 0);
+    }
+    memset(units, 0, numUnits * sizeof(faultUnit_t));
+    return 0;
+}
+
+/* Standard normal sample, xorshift64* and Box Muller. */
+static double faultGauss(faultSensor_t* fs)
+{
+    double u[2];
+
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        fs->rng ^= fs->rng >> 12;
+        fs->rng ^= fs->rng << 25;
+        fs->rng ^= fs->rng >> 27;
+        u[i] = ((double) ((fs->rng * 0x2545F4914F6CDD1DULL) >> 11) + 0.5) * 0x1.0p-53;
+    }
+    return sqrt(-2.0 * log(u[0])) * cos(2.0 * M_PI * u[1]);
+}
+
+void setFaultNoise(faultSensor_t* fs, const double* sigma)
+{
+    fs->noise = sigma;
+}
+
+unsigned int applyFaults(faultSensor_t* fs, unsigned int unit, uint64_t simTime_ns, double* ch, unsigned int numCh,
+                         uint64_t* release_ns)
+{
+    faultUnit_t* fu      = &fs->unit[unit];
+    unsigned int act     = 0;
+    int          inStuck = 0;
+
+    if (numCh > faultMaxChannels)
+    {
+        numCh = faultMaxChannels;
+    }
+    for (unsigned int c = 0; (fs->noise != NULL) && (c < numCh); c++)
+    {
+        ch[c] += fs->noise[c] * faultGauss(fs);
+    }
+    for (unsigned int f = 0; f < fs->list->numFaults; f++)
+    {
+        const fault_t* fault = &fs->list->fault[f];
+        unsigned int   c0    = 0;
+        unsigned int   c1    = numCh;
+
+        if ((fault->unit != unit) || (simTime_ns < fault->start_ns) || (simTime_ns >= fault->end_ns))
+        {
+            continue;
+        }
+        if (fault->channel >= 0)
+        {
+            if ((unsigned int) fault->channel >= numCh)
+            {
+                continue;
+            }
+            c0 = (unsigned int) fault->channel;
+            c1 = c0 + 1;
+        }
+        atomic_fetch_add_explicit(&fs->numHit[fault->kind], 1, memory_order_relaxed);
+
+        switch (fault->kind)
+        {
+            case faultBias:
+                for (unsigned int c = c0; c < c1; c++)
+                {
+                    ch[c] += fault->magnitude;
+                }
+                break;
+
+            case faultDrift:
+                for (unsigned int c = c0; c < c1; c++)
+                {
+                    ch[c] += fault->magnitude * (double) (simTime_ns - fault->start_ns) * 1e-9;
+                }
+                break;
+
+            case faultNoise:
+                for (unsigned int c = c0; c < c1; c++)
+                {
+                    ch[c] += fault->magnitude * faultGauss(fs);
+                }
+                break;
+
+            case faultStuck:
+                if (fu->haveStuck == 0)
+                {
+                    memcpy(fu->stuck, ch, numCh * sizeof(double));
+                    fu->haveStuck = 1;
+                }
+                for (unsigned int c = c0; c < c1; c++)
+                {
+                    ch[c] = fu->stuck[c];
+                }
+                inStuck = 1;
+                break;
+
+            case faultDropout:
+                act |= faultActDrop;
+                break;
+
+            case faultDuplicate:
+                act |= faultActDuplicate;
+                break;
+
+            case faultReorder:
+                /* Due at the next sample, so it goes out right after it. */
+                act        |= faultActHold;
+                *release_ns = simTime_ns + 1;
+                break;
+
+            case faultDelay:
+                act        |= faultActHold;
+                *release_ns = simTime_ns + (uint64_t) (fault->magnitude * 1e9);
+                break;
+
+            default:
+                break;
+        }
+    }
+    if (inStuck == 0)
+    {
+        fu->haveStuck = 0;
+    }
+    return act;
+}
+
+int holdFaultSample(faultSensor_t* fs, unsigned int unit, uint64_t release_ns, const void* msg, size_t size)
+{
+    faultUnit_t* fu = &fs->unit[unit];
+    faultHeld_t* h;
+
+    if ((fu->numHeld == faultMaxHeld) || (size > faultMsgBytes))
+    {
+        return -1;
+    }
+    h             = &fu->held[fu->numHeld++];
+    h->release_ns = release_ns;
+    h->size       = size;
+    memcpy(h->data, msg, size);
+    return 0;
+}
+
+const faultHeld_t* releaseFaultSample(faultSensor_t* fs, unsigned int unit, uint64_t simTime_ns)
+{
+    faultUnit_t* fu   = &fs->unit[unit];
+    unsigned int best = fu->numHeld;
+
+    for (unsigned int i = 0; i < fu->numHeld; i++)
+    {
+        if ((fu->held[i].release_ns <= simTime_ns) &&
+            ((best == fu->numHeld) || (fu->held[i].release_ns < fu->held[best].release_ns)))
+        {
+            best = i;
+        }
+    }
+    if (best == fu->numHeld)
+    {
+        return NULL;
+    }
+    fu->out        = fu->held[best];
+    fu->held[best] = fu->held[--fu->numHeld];
+    return &fu->out;
+}
+
+void printFaultStats(const char* name, faultSensor_t* fs)
+{
+    printf("%s faults injected:", name);
+    for (unsigned int k = 0; k < numFaultKinds; k++)
+    {
+        uint64_t n = atomic_load_explicit(&fs->numHit[k], memory_order_relaxed);
+
+        if (n > 0)
+        {
+            printf(" %s %lu,", faultKindNames[k], (unsigned long) n);
+        }
+    }
+    printf(" over %u faults \n", fs->list->numFaults);
+}
+
+const char* faultKindName(faultKind_e kind)
+{
+    return ((unsigned int) kind < numFaultKinds) ? faultKindNames[kind] : "?";
+}
@@ -1,5 +1,335 @@
 // 
+#define _GNU_SOURCE                 // sendmmsg / recvmmsg
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "interfaceLib.h"
+#include "captureLib.h"
+
+typedef struct
+{
+    uint32_t len;
+    uint32_t reserved;
+    uint8_t  data[ipcShmSlotSize];
+} ipcShmSlot_t;
+
+/* Head, tail and doorbell sit on their own cache lines so producer and consumer do not false share. */
+struct ipcShmRing
+{
+    _Alignas(64) _Atomic uint64_t head;             //< Next slot to be written. Producer owned.
+    _Alignas(64) _Atomic uint64_t tail;             //< Next slot to be read. Consumer owned.
+    _Alignas(64) _Atomic int      doorbell;         //< 1 while a wakeup datagram is pending on the consumer socket.
+    _Atomic int                   reader;           //< 1 while a consumer has the ring open.
+    _Alignas(64) ipcShmSlot_t     slot[ipcShmNumSlots];
+};
+
+/* In-process channel, created by whichever end opens its port first. Lives as long as the process. */
+typedef struct ipcInprocChan
+{
+    struct ipcInprocChan* next;
+    uint16_t              port;
+    int                   doorbellFd;               //< eventfd both ends share, in semaphore mode.
+    ipcShmRing_t*         ring;
+} ipcInprocChan_t;
+
+static pthread_mutex_t  inprocLock  = PTHREAD_MUTEX_INITIALIZER;
+static ipcInprocChan_t* inprocChans = NULL;
+
+static int getEnvBackpressure(void)
+{
+    const char* env = getenv("TEC_IPC_BACKPRESSURE");
+
+    return ((env != NULL) && (strcmp(env, "1") == 0));
+}
+
+enum ipcTransport parseIpcTransport(const char* name)
+{
+    if (name == NULL)
+    {
+        return IPC_DEFAULT;
+    }
+    if (strcmp(name, "udp") == 0)
+    {
+        return IPC_UDP;
+    }
+    if (strcmp(name, "shm") == 0)
+    {
+        return IPC_SHM;
+    }
+    if (strcmp(name, "inproc") == 0)
+    {
+        return IPC_INPROC;
+    }
+    return IPC_DEFAULT;
+}
+
+static enum ipcTransport getEnvTransport(void)
+{
+    enum ipcTransport transport = parseIpcTransport(getenv("TEC_IPC_TRANSPORT"));
+
+    return (transport == IPC_DEFAULT) ? IPC_UDP : transport;
+}
+
+/* Both ends derive the segment name from the consumer port. */
+static void shmRingName(const ipcConfig_t* cfg, char* name, size_t size)
+{
+    snprintf(name, size, "/tecIpc%u", (unsigned int) cfg->port);
+}
+
+static int initShmRing(ipcConfig_t* cfg)
+{
+    char name[32];
+    int  fd;
+    void* map;
+
+    shmRingName(cfg, name, sizeof(name));
+    fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd == -1)
+    {
+        perror("Shared Memory Open Failed.");
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(ipcShmRing_t)) == -1)
+    {
+        perror("Shared Memory Resize Failed.");
+        close(fd);
+        return -1;
+    }
+    map = mmap(NULL, sizeof(ipcShmRing_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror("Shared Memory Map Failed.");
+        return -1;
+    }
+    cfg->shmRing = (ipcShmRing_t *) map;
+
+    if (cfg->direction == INPUT)
+    {
+        /* Consumer owns the read side. Discard anything left over from a previous run. */
+        atomic_store(&cfg->shmRing->tail, atomic_load(&cfg->shmRing->head));
+        atomic_store(&cfg->shmRing->doorbell, 0);
+        atomic_store(&cfg->shmRing->reader, 1);
+    }
+    return 0;
+}
+
+/* Both ends of the port share one ring and one eventfd. Nothing is reset, the other end may have sent already. */
+static int initInprocRing(ipcConfig_t* cfg)
+{
+    ipcInprocChan_t* chan;
+
+    pthread_mutex_lock(&inprocLock);
+    for (chan = inprocChans; (chan != NULL) && (chan->port != cfg->port); chan = chan->next)
+    {
+    }
+    if (chan == NULL)
+    {
+        chan = (ipcInprocChan_t *) malloc(sizeof(ipcInprocChan_t));
+        if (chan == NULL)
+        {
+            pthread_mutex_unlock(&inprocLock);
+            perror("In Process Channel Allocation Failed.");
+            return -1;
+        }
+        chan->port       = cfg->port;
+        chan->ring       = (ipcShmRing_t *) aligned_alloc(64, sizeof(ipcShmRing_t));
+        chan->doorbellFd = eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE | EFD_CLOEXEC);
+        if ((chan->ring == NULL) || (chan->doorbellFd == -1))
+        {
+            pthread_mutex_unlock(&inprocLock);
+            perror("In Process Channel Creation Failed.");
+            if (chan->doorbellFd != -1)
+            {
+                close(chan->doorbellFd);
+            }
+            free(chan->ring);
+            free(chan);
+            return -1;
+        }
+        atomic_init(&chan->ring->head, 0);
+        atomic_init(&chan->ring->tail, 0);
+        atomic_init(&chan->ring->doorbell, 0);
+        atomic_init(&chan->ring->reader, 0);
+        chan->next  = inprocChans;
+        inprocChans = chan;
+    }
+    pthread_mutex_unlock(&inprocLock);
+
+    cfg->shmRing = chan->ring;
+    cfg->ipcSock = chan->doorbellFd;
+    if (cfg->direction == INPUT)
+    {
+        atomic_store(&chan->ring->reader, 1);
+    }
+    return 0;
+}
+
+/* Send a zero length wakeup datagram to the consumer socket, or count the eventfd up by one. */
+static void postDoorbell(ipcConfig_t* cfg)
+{
+    if (cfg->transport == IPC_INPROC)
+    {
+        uint64_t one = 1;
+        ssize_t  ret = write(cfg->ipcSock, &one, sizeof(one));
+        (void) ret;
+        return;
+    }
+    sendto(cfg->ipcSock, NULL, 0, 0, (struct sockaddr *) &cfg->si, sizeof(cfg->si));
+}
+
+/* Take one pending wakeup without waiting. Returns -1 with errno set if none is there. */
+static ssize_t readDoorbell(ipcConfig_t* cfg)
+{
+    uint64_t count;
+
+    if (cfg->transport == IPC_INPROC)
+    {
+        return read(cfg->ipcSock, &count, sizeof(count));
+    }
+    return recv(cfg->ipcSock, NULL, 0, MSG_DONTWAIT);
+}
+
+/* Consume one wakeup datagram, waiting for it if it is still in flight. */
+static void takeDoorbell(ipcConfig_t* cfg)
+{
+    struct pollfd pfd;
+
+    pfd.fd     = cfg->ipcSock;
+    pfd.events = POLLIN;
+    while (readDoorbell(cfg) < 0)
+    {
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+        {
+            return;
+        }
+        poll(&pfd, 1, -1);
+    }
+}
+
+/* 
+ * Called by the consumer once it has seen the ring empty.
+ * Clears the doorbell so the next push raises it again, and re-raises it if a push raced with us.
+ * tokenHeld is set when the consumer already took the pending datagram.
+ */
+static void rearmDoorbell(ipcConfig_t* cfg, int tokenHeld)
+{
+    ipcShmRing_t* ring = cfg->shmRing;
+
+    if (cfg->transport == IPC_DIRECT)
+    {
+        return;
+    }
+    if ((atomic_exchange(&ring->doorbell, 0) == 1) && (tokenHeld == 0))
+    {
+        takeDoorbell(cfg);
+    }
+    if (atomic_load(&ring->head) != atomic_load(&ring->tail))
+    {
+        if (atomic_exchange(&ring->doorbell, 1) == 0)
+        {
+            postDoorbell(cfg);
+        }
+    }
+}
+
+static ssize_t shmRingPush(ipcConfig_t* cfg, uint8_t* dataBuf, size_t dataBufSize)
+{
+    ipcShmRing_t* ring = cfg->shmRing;
+    ipcShmSlot_t* slot;
+    uint64_t      head;
+
+    if (dataBufSize > ipcShmSlotSize)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while ((head - atomic_load_explicit(&ring->tail, memory_order_acquire)) >= ipcShmNumSlots)
+    {
+        if ((cfg->blockOnFull == 0) || (atomic_load_explicit(&ring->reader, memory_order_relaxed) == 0))
+        {
+            /* Ring full. Drop, same as a saturated socket buffer. Nobody would make space without a reader. */
+            errno = EAGAIN;
+            return -1;
+        }
+        /* Backpressure. Let the consumer catch up. */
+        sched_yield();
+    }
+
+    slot = &ring->slot[head % ipcShmNumSlots];
+    memcpy(slot->data, dataBuf, dataBufSize);
+    slot->len = (uint32_t) dataBufSize;
+    atomic_store(&ring->head, head + 1);
+
+    /* Only the empty to non-empty transition costs a syscall. */
+    if ((cfg->transport != IPC_DIRECT) && (atomic_exchange(&ring->doorbell, 1) == 0))
+    {
+        postDoorbell(cfg);
+    }
+    return (ssize_t) dataBufSize;
+}
+
+static ssize_t shmRingPop(ipcConfig_t* cfg, uint8_t* dataBuf, size_t dataBufSize, int block)
+{
+    ipcShmRing_t* ring  = cfg->shmRing;
+    int           woken = 0;
+
+    while (1)
+    {
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        if (atomic_load_explicit(&ring->head, memory_order_acquire) != tail)
+        {
+            ipcShmSlot_t* slot = &ring->slot[tail % ipcShmNumSlots];
+            size_t        len  = slot->len;
+
+            if (len > dataBufSize)
+            {
+                /* Truncate like recvfrom does for an undersized buffer. */
+                len = dataBufSize;
+            }
+            memcpy(dataBuf, slot->data, len);
+            atomic_store(&ring->tail, tail + 1);
+
+            if (atomic_load(&ring->head) == (tail + 1))
+            {
+                rearmDoorbell(cfg, woken);
+            }
+            else if (woken == 1)
+            {
+                /* Data still queued, keep the socket readable for poll based consumers. */
+                postDoorbell(cfg);
+            }
+            return (ssize_t) len;
+        }
+
+        /* Empty. Arm the doorbell, then sleep on the socket until a producer rings it. */
+        rearmDoorbell(cfg, woken);
+        woken = 0;
+        if ((block == 0) || (cfg->transport == IPC_DIRECT))
+        {
+            /* Nothing would ring a direct channel, its consumer only polls. */
+            errno = EAGAIN;
+            return -1;
+        }
+        if (atomic_load(&ring->head) == atomic_load(&ring->tail))
+        {
+            takeDoorbell(cfg);
+            woken = 1;
+        }
+    }
+}
 
 int initInterface(interfaceCfg_t* cfg)
 {
@@ -36,17 +366,205 @@ npy_array_t* npyLoadData(interfaceCfg_t* cfg)
     return npy_array_load(cfg->filePath);
 }
 
+/* Find the value following 'key': in an npy header dict. */
+static const char* npyHeaderValue(const char* dict, size_t dictLen, const char* key)
+{
+    size_t keyLen = strlen(key);
+
+    for (size_t i = 0; (i + keyLen + 2) < dictLen; i++)
+    {
+        if (((dict[i] == '\'') || (dict[i] == '"')) && (memcmp(&dict[i + 1], key, keyLen) == 0) &&
+            (dict[i + 1 + keyLen] == dict[i]))
+        {
+            const char* p = &dict[i + keyLen + 2];
+            while ((p < (dict + dictLen)) && ((*p == ' ') || (*p == ':')))
+            {
+                p++;
+            }
+            return p;
+        }
+    }
+    return NULL;
+}
+
+int npyParseHeader(const char* buf, size_t size, npyHeader_t* hdr)
+{
+    const uint8_t* u = (const uint8_t *) buf;
+    const char*    dict;
+    const char*    end;
+    const char*    p;
+    size_t         dictLen;
+
+    /* Magic string, version, then the header length. 2 bytes in v1, 4 bytes from v2 on. */
+    if ((size < 10) || (memcmp(buf, "\x93NUMPY", 6) != 0))
+    {
+        return -1;
+    }
+    if (u[6] == 1)
+    {
+        dictLen = (size_t) u[8] | ((size_t) u[9] << 8);
+        dict    = buf + 10;
+    }
+    else if ((size >= 12) && ((u[6] == 2) || (u[6] == 3)))
+    {
+        dictLen = (size_t) u[8] | ((size_t) u[9] << 8) | ((size_t) u[10] << 16) | ((size_t) u[11] << 24);
+        dict    = buf + 12;
+    }
+    else
+    {
+        return -1;
+    }
+    if ((size_t) ((dict + dictLen) - buf) > size)
+    {
+        return -1;
+    }
+    hdr->dataOffset = (size_t) ((dict + dictLen) - buf);
+    end             = dict + dictLen;
+
+    /* 'descr': '<f8' */
+    p = npyHeaderValue(dict, dictLen, "descr");
+    if ((p == NULL) || ((p + 4) >= end) || ((*p != '\'') && (*p != '"')))
+    {
+        return -1;
+    }
+    hdr->endianness = p[1];
+    hdr->typeChar   = p[2];
+    hdr->elemSize   = strtoul(p + 3, NULL, 10);
+
+    /* 'fortran_order': False */
+    p = npyHeaderValue(dict, dictLen, "fortran_order");
+    if (p == NULL)
+    {
+        return -1;
+    }
+    hdr->fortranOrder = (*p == 'T');
+
+    /* 'shape': (6001, 6), */
+    p = npyHeaderValue(dict, dictLen, "shape");
+    if ((p == NULL) || (*p != '('))
+    {
+        return -1;
+    }
+    p++;
+    hdr->ndim = 0;
+    while ((p < end) && (*p != ')'))
+    {
+        char* next;
+        unsigned long dim = strtoul(p, &next, 10);
+        if (next == p)
+        {
+            /* Separator. */
+            p++;
+            continue;
+        }
+        if (hdr->ndim == npyMaxDims)
+        {
+            return -1;
+        }
+        hdr->shape[hdr->ndim++] = dim;
+        p = next;
+    }
+
+    hdr->numRows = (hdr->ndim > 0) ? hdr->shape[0] : 1;
+    hdr->rowSize = hdr->elemSize;
+    for (size_t i = 1; i < hdr->ndim; i++)
+    {
+        hdr->rowSize *= hdr->shape[i];
+    }
+    return (hdr->elemSize > 0) ? 0 : -1;
+}
+
+int npyMapData(interfaceCfg_t* cfg, npyMap_t* map)
+{
+    struct stat st;
+    int         fd;
+
+    map->mapBase = NULL;
+    fd = open(cfg->filePath, O_RDONLY);
+    if (fd == -1)
+    {
+        perror("Npy Open Failed.");
+        return -1;
+    }
+    if ((fstat(fd, &st) == -1) || (st.st_size <= 0))
+    {
+        close(fd);
+        return -1;
+    }
+    map->mapSize = (size_t) st.st_size;
+    map->mapBase = mmap(NULL, map->mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    /* The mapping keeps the file referenced. */
+    close(fd);
+    if (map->mapBase == MAP_FAILED)
+    {
+        perror("Npy Map Failed.");
+        map->mapBase = NULL;
+        return -1;
+    }
+
+    /* Replay walks the rows front to back. */
+    madvise(map->mapBase, map->mapSize, MADV_SEQUENTIAL);
+
+    if ((npyParseHeader((const char *) map->mapBase, map->mapSize, &map->hdr) == -1) ||
+        (map->hdr.fortranOrder == 1) || (map->hdr.endianness == '>') ||
+        ((map->hdr.dataOffset + (map->hdr.numRows * map->hdr.rowSize)) > map->mapSize))
+    {
+        fprintf(stderr, "Unsupported npy file %s \n", cfg->filePath);
+        npyUnmapData(map);
+        return -1;
+    }
+    map->data = (const char *) map->mapBase + map->hdr.dataOffset;
+    return 0;
+}
+
+const char* npyMapRow(const npyMap_t* map, size_t row)
+{
+    if (row >= map->hdr.numRows)
+    {
+        return NULL;
+    }
+    return map->data + (row * map->hdr.rowSize);
+}
+
+int npyUnmapData(npyMap_t* map)
+{
+    int ret = 0;
+    if (map->mapBase != NULL)
+    {
+        ret = munmap(map->mapBase, map->mapSize);
+        map->mapBase = NULL;
+    }
+    return ret;
+}
+
 void setInterface(interfaceCfg_t* cfg, enum interfaceType type, char* filename)
 {
-    cfg->direction = type;
-    cfg->filePath  = filename;
-    initInterface(cfg);
+    /* Only records the interface. initInterface opens it for callers that want a FILE*. */
+    cfg->direction   = type;
+    cfg->filePath    = filename;
+    cfg->interfaceFp = NULL;
 }
 
 int initIPC(ipcConfig_t* cfg)
 {
     int sock = -1;
 
+    if (cfg->transport == IPC_DEFAULT)
+    {
+        cfg->transport = getEnvTransport();
+    }
+    cfg->shmRing     = NULL;
+    cfg->nonBlocking = 0;
+    cfg->blockOnFull = getEnvBackpressure();
+
+    if ((cfg->transport == IPC_INPROC) || (cfg->transport == IPC_DIRECT))
+    {
+        /* No socket, the shared eventfd stands in for it so poll and epoll work unchanged. Direct never rings it. */
+        cfg->ipcSock = -1;
+        initInprocRing(cfg);
+        return cfg->ipcSock;
+    }
+
     sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if(sock == -1)
     {
@@ -77,6 +595,14 @@ int initIPC(ipcConfig_t* cfg)
     }
     /* Set the socket in the structure itself. */
     cfg->ipcSock = sock;
+
+    /* Shared memory carries the data, the socket above stays as the pollable doorbell. */
+    if ((cfg->transport == IPC_SHM) && (initShmRing(cfg) == -1))
+    {
+        close(sock);
+        cfg->ipcSock = -1;
+        return -1;
+    }
     /* Code is redundant. */
     return sock;
 }
@@ -84,7 +610,15 @@ int initIPC(ipcConfig_t* cfg)
 ssize_t sendMsgIPC(ipcConfig_t* cfg, uint8_t* dataBuf, size_t dataBufSize)
 {
     ssize_t retVal;
-    retVal = sendto(cfg->ipcSock, dataBuf, dataBufSize, 0, (struct sockaddr *) &cfg->si, sizeof(cfg->si));
+    if (cfg->transport != IPC_UDP)
+    {
+        retVal = shmRingPush(cfg, dataBuf, dataBufSize);
+    }
+    else
+    {
+        retVal = sendto(cfg->ipcSock, dataBuf, dataBufSize, 0, (struct sockaddr *) &cfg->si, sizeof(cfg->si));
+    }
+    captureMsg(cfg->port, captureSend, (uint8_t) cfg->transport, dataBuf, retVal);
     return retVal;
 }
 
@@ -92,11 +626,141 @@ ssize_t recvMsgIPC(ipcConfig_t* cfg, uint8_t* dataBuf, size_t dataBufSize)
 {
     ssize_t retVal;
     socklen_t addrSize;
-    addrSize = sizeof(cfg->si);
-    retVal = recvfrom(cfg->ipcSock, dataBuf, dataBufSize, 0, (struct sockaddr *) &cfg->si, &addrSize);
+    if (cfg->transport != IPC_UDP)
+    {
+        retVal = shmRingPop(cfg, dataBuf, dataBufSize, (cfg->nonBlocking == 0));
+    }
+    else
+    {
+        addrSize = sizeof(cfg->si);
+        retVal = recvfrom(cfg->ipcSock, dataBuf, dataBufSize, 0, (struct sockaddr *) &cfg->si, &addrSize);
+    }
+    captureMsg(cfg->port, captureRecv, (uint8_t) cfg->transport, dataBuf, retVal);
     return retVal;
 }
 
+int sendMsgBatchIPC(ipcConfig_t* cfg, unsigned int numCfg, uint8_t* dataBuf, size_t dataBufSize)
+{
+    struct mmsghdr msg[ipcMaxBatch];
+    struct iovec   iov;
+    int            numSent = 0;
+
+    if ((numCfg == 0) || (cfg[0].transport != IPC_UDP))
+    {
+        for (size_t i = 0; i < numCfg; i++)
+        {
+            if (sendMsgIPC(&cfg[i], dataBuf, dataBufSize) >= 0)
+            {
+                numSent++;
+            }
+        }
+        return numSent;
+    }
+
+    /* Unconnected UDP: every destination goes out through the first socket in one syscall. */
+    iov.iov_base = dataBuf;
+    iov.iov_len  = dataBufSize;
+    memset(msg, 0, sizeof(msg));
+    while ((unsigned int) numSent < numCfg)
+    {
+        unsigned int numMsg = numCfg - numSent;
+        int          ret;
+
+        if (numMsg > ipcMaxBatch)
+        {
+            numMsg = ipcMaxBatch;
+        }
+        for (size_t i = 0; i < numMsg; i++)
+        {
+            msg[i].msg_hdr.msg_name    = &cfg[numSent + i].si;
+            msg[i].msg_hdr.msg_namelen = sizeof(cfg[numSent + i].si);
+            msg[i].msg_hdr.msg_iov     = &iov;
+            msg[i].msg_hdr.msg_iovlen  = 1;
+        }
+        ret = sendmmsg(cfg[0].ipcSock, msg, numMsg, 0);
+        if (ret <= 0)
+        {
+            break;
+        }
+        for (int i = 0; i < ret; i++)
+        {
+            captureMsg(cfg[numSent + i].port, captureSend, IPC_UDP, dataBuf, (ssize_t) dataBufSize);
+        }
+        numSent += ret;
+    }
+    return numSent;
+}
+
+int recvMsgBatchIPC(ipcConfig_t* cfg, uint8_t* dataBuf, size_t msgStride, size_t dataBufSize, ssize_t* msgLen, unsigned int maxMsgs)
+{
+    struct mmsghdr msg[ipcMaxBatch];
+    struct iovec   iov[ipcMaxBatch];
+    int            ret;
+
+    if (maxMsgs > ipcMaxBatch)
+    {
+        maxMsgs = ipcMaxBatch;
+    }
+
+    if (cfg->transport != IPC_UDP)
+    {
+        int numRx = 0;
+        /* First pop blocks, the rest only take what is already queued. */
+        while ((unsigned int) numRx < maxMsgs)
+        {
+            ssize_t len = shmRingPop(cfg, dataBuf + (numRx * msgStride), dataBufSize,
+                                     ((numRx == 0) && (cfg->nonBlocking == 0)));
+            if (len < 0)
+            {
+                break;
+            }
+            msgLen[numRx] = len;
+            captureMsg(cfg->port, captureRecv, (uint8_t) cfg->transport, dataBuf + (numRx * msgStride), len);
+            numRx++;
+        }
+        return (numRx > 0) ? numRx : -1;
+    }
+
+    memset(msg, 0, sizeof(msg));
+    for (size_t i = 0; i < maxMsgs; i++)
+    {
+        iov[i].iov_base            = dataBuf + (i * msgStride);
+        iov[i].iov_len             = dataBufSize;
+        msg[i].msg_hdr.msg_iov     = &iov[i];
+        msg[i].msg_hdr.msg_iovlen  = 1;
+    }
+    ret = recvmmsg(cfg->ipcSock, msg, maxMsgs, MSG_WAITFORONE, NULL);
+    for (int i = 0; i < ret; i++)
+    {
+        msgLen[i] = (ssize_t) msg[i].msg_len;
+        captureMsg(cfg->port, captureRecv, IPC_UDP, dataBuf + (i * msgStride), msgLen[i]);
+    }
+    return ret;
+}
+
+int setIpcNonBlocking(ipcConfig_t* cfg)
+{
+    int flags = fcntl(cfg->ipcSock, F_GETFL, 0);
+
+    if ((flags == -1) || (fcntl(cfg->ipcSock, F_SETFL, flags | O_NONBLOCK) == -1))
+    {
+        perror("Error Setting Non Blocking.");
+        return -1;
+    }
+    cfg->nonBlocking = 1;
+    return 0;
+}
+
+ssize_t pendingMsgIPC(const ipcConfig_t* cfg)
+{
+    if ((cfg->transport == IPC_UDP) || (cfg->shmRing == NULL))
+    {
+        return -1;
+    }
+    return (ssize_t) (atomic_load_explicit(&cfg->shmRing->head, memory_order_relaxed) -
+                      atomic_load_explicit(&cfg->shmRing->tail, memory_order_acquire));
+}
+
 void initPollFd(struct pollfd* fds, unsigned int numFd, int event)
 {
     for (size_t i = 0; i < numFd; i++)
@@ -106,9 +770,54 @@ void initPollFd(struct pollfd* fds, unsigned int numFd, int event)
 }
 
 void setIpcAddrPort(ipcConfig_t* cfg, char* addr, uint16_t port, enum interfaceType type)
+{
+    setIpcAddrPortTransport(cfg, addr, port, type, IPC_DEFAULT);
+}
+
+void setIpcAddrPortTransport(ipcConfig_t* cfg, char* addr, uint16_t port, enum interfaceType type, enum ipcTransport transport)
 {
     cfg->ipAddress = addr;
     cfg->port      = port;
     cfg->direction = type;
+    cfg->transport = (transport == IPC_DEFAULT) ? getEnvTransport() : transport;
     initIPC(cfg);
 }
+
+void unlinkIPC(const ipcConfig_t* cfg)
+{
+    char name[32];
+
+    if ((cfg->transport == IPC_SHM) && (cfg->direction == INPUT))
+    {
+        shmRingName(cfg, name, sizeof(name));
+        shm_unlink(name);
+    }
+}
+
+int closeIPC(ipcConfig_t* cfg)
+{
+    if ((cfg->shmRing != NULL) && (cfg->direction == INPUT))
+    {
+        /* Producers waiting for space go back to dropping. */
+        atomic_store(&cfg->shmRing->reader, 0);
+    }
+    if ((cfg->transport == IPC_INPROC) || (cfg->transport == IPC_DIRECT))
+    {
+        /* Ring and eventfd belong to the process registry, the other end may still use them. */
+        cfg->shmRing = NULL;
+        cfg->ipcSock = -1;
+        return 0;
+    }
+    if (cfg->shmRing != NULL)
+    {
+        unlinkIPC(cfg);
+        munmap(cfg->shmRing, sizeof(ipcShmRing_t));
+        cfg->shmRing = NULL;
+    }
+    if (cfg->ipcSock >= 0)
+    {
+        close(cfg->ipcSock);
+        cfg->ipcSock = -1;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+//
+#include <stdio.h>
+
+#include "latencyLib.h"
+
+int initLatencyTable(latencyTable_t* tab, const char* const* sensorNames, unsigned int numSensors,
+                     const char* const* stageNames, unsigned int numStages)
+{
+    if ((numSensors > latMaxSensors) || (numStages > latMaxStages))
+    {
+        fprintf(stderr, "Latency table limited to %u sensors, %u stages \n", latMaxSensors, latMaxStages);
+        return -1;
+    }
+    tab->sensorNames = sensorNames;
+    tab->stageNames  = stageNames;
+    tab->numSensors  = numSensors;
+    tab->numStages   = numStages;
+    for (unsigned int s = 0; s < latMaxSensors; s++)
+    {
+        for (unsigned int k = 0; k < latMaxStages; k++)
+        {
+            initTimeHist(&tab->hist[s][k]);
+        }
+    }
+    return 0;
+}
+
+void addLatency(latencyTable_t* tab, unsigned int sensor, unsigned int stage, uint64_t from_ns, uint64_t to_ns)
+{
+    if ((from_ns == 0) || (sensor >= tab->numSensors) || (stage >= tab->numStages))
+    {
+        return;
+    }
+    /* Stamps from another process on the same host share CLOCK_MONOTONIC, so only guard reordering. */
+    addTimeHist(&tab->hist[sensor][stage], (to_ns > from_ns) ? (to_ns - from_ns) : 0);
+}
+
+void printLatencyTable(const char* title, latencyTable_t* tab)
+{
+    printf("%s latency [us]:      count       mean        p50        p99      p99.9        max \n", title);
+    for (unsigned int s = 0; s < tab->numSensors; s++)
+    {
+        for (unsigned int k = 0; k < tab->numStages; k++)
+        {
+            timeHist_t* h = &tab->hist[s][k];
+            uint64_t    n = atomic_load_explicit(&h->numSamples, memory_order_relaxed);
+
+            if (n == 0)
+            {
+                continue;
+            }
+            printf("  %-5s %-10s %10lu %10.1f %10.1f %10.1f %10.1f %10.1f \n", tab->sensorNames[s],
+                   tab->stageNames[k], (unsigned long) n,
+                   (double) atomic_load_explicit(&h->sum_ns, memory_order_relaxed) * 1e-3 / (double) n,
+                   (double) getTimeHistPercentile(h, 0.5) * 1e-3,
+                   (double) getTimeHistPercentile(h, 0.99) * 1e-3,
+                   (double) getTimeHistPercentile(h, 0.999) * 1e-3,
+                   (double) atomic_load_explicit(&h->max_ns, memory_order_relaxed) * 1e-3);
+        }
+    }
+}
@@ -0,0 +1,157 @@
+//
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "latestLib.h"
+
+latestTable_t* openLatestTable(const char* name)
+{
+    void* map;
+    int   fd;
+
+    if (name == NULL)
+    {
+        map = aligned_alloc(64, sizeof(latestTable_t));
+        if (map == NULL)
+        {
+            perror("Latest Table Allocation Failed.");
+            return NULL;
+        }
+        memset(map, 0, sizeof(latestTable_t));
+        return (latestTable_t *) map;
+    }
+
+    /* A new segment reads as zero, every slot unpublished. */
+    fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd == -1)
+    {
+        perror("Latest Table Open Failed.");
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(latestTable_t)) == -1)
+    {
+        perror("Latest Table Resize Failed.");
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, sizeof(latestTable_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror("Latest Table Map Failed.");
+        return NULL;
+    }
+    return (latestTable_t *) map;
+}
+
+void closeLatestTable(latestTable_t* tab, const char* name)
+{
+    if (tab == NULL)
+    {
+        return;
+    }
+    if (name == NULL)
+    {
+        free(tab);
+    }
+    else
+    {
+        munmap(tab, sizeof(latestTable_t));
+    }
+}
+
+void resetLatestTable(latestTable_t* tab)
+{
+    for (unsigned int i = 0; i < latestMaxSlots; i++)
+    {
+        /* A reader in the middle of a copy sees the sequence change and retries, then finds nothing published. */
+        atomic_store_explicit(&tab->slot[i].size, 0, memory_order_relaxed);
+        atomic_store_explicit(&tab->slot[i].seq, 0, memory_order_release);
+    }
+}
+
+void unlinkLatestTable(const char* name)
+{
+    if (name != NULL)
+    {
+        shm_unlink(name);
+    }
+}
+
+int publishLatest(latestTable_t* tab, unsigned int slot, const void* data, size_t size)
+{
+    latestSlot_t*  s;
+    const uint8_t* src = (const uint8_t *) data;
+    uint32_t       seq;
+
+    if ((slot >= latestMaxSlots) || (size > latestSlotBytes))
+    {
+        return -1;
+    }
+    s   = &tab->slot[slot];
+    seq = atomic_load_explicit(&s->seq, memory_order_relaxed);
+
+    /* Odd sequence first, the payload may not become visible before it. */
+    atomic_store_explicit(&s->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (size_t i = 0; i * sizeof(uint64_t) < size; i++)
+    {
+        uint64_t w    = 0;
+        size_t   left = size - i * sizeof(uint64_t);
+
+        memcpy(&w, src + i * sizeof(uint64_t), (left < sizeof(w)) ? left : sizeof(w));
+        atomic_store_explicit(&s->word[i], w, memory_order_relaxed);
+    }
+    atomic_store_explicit(&s->size, (uint32_t) size, memory_order_relaxed);
+    atomic_store_explicit(&s->seq, seq + 2, memory_order_release);
+    return 0;
+}
+
+uint32_t readLatest(latestTable_t* tab, unsigned int slot, void* data, size_t size)
+{
+    latestSlot_t* s;
+    uint64_t      buf[latestSlotWords];
+    uint32_t      seq;
+    uint32_t      len;
+
+    if (slot >= latestMaxSlots)
+    {
+        return 0;
+    }
+    s = &tab->slot[slot];
+
+    while (1)
+    {
+        seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (seq == 0)
+        {
+            return 0;
+        }
+        if ((seq & 1U) != 0)
+        {
+            /* Publication in progress, it is a few stores long. */
+            continue;
+        }
+        len = atomic_load_explicit(&s->size, memory_order_relaxed);
+        if (len > latestSlotBytes)
+        {
+            continue;
+        }
+        for (size_t i = 0; i * sizeof(uint64_t) < len; i++)
+        {
+            buf[i] = atomic_load_explicit(&s->word[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&s->seq, memory_order_relaxed) == seq)
+        {
+            break;
+        }
+    }
+    memcpy(data, buf, (len < size) ? len : size);
+    return seq / 2;
+}
@@ -0,0 +1,214 @@
+//
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "lockstepLib.h"
+
+/* Shared between processes, so no FUTEX_PRIVATE_FLAG. */
+static int futexWait(_Atomic uint32_t* word, uint32_t val, int timeoutMs)
+{
+    struct timespec timeout = {timeoutMs / 1000, (long) (timeoutMs % 1000) * 1000000L};
+
+    return (int) syscall(SYS_futex, (uint32_t *) word, FUTEX_WAIT, val, &timeout, NULL, 0);
+}
+
+static void futexWakeAll(_Atomic uint32_t* word)
+{
+    syscall(SYS_futex, (uint32_t *) word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static lockstepShared_t* mapLockstep(int fd)
+{
+    void* map = mmap(NULL, sizeof(lockstepShared_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror("Lockstep Map Failed.");
+        return NULL;
+    }
+    return (lockstepShared_t *) map;
+}
+
+lockstepShared_t* createLockstep(const char* name, uint64_t tick_ns)
+{
+    lockstepShared_t* shm;
+    int               fd;
+
+    /* Members of an earlier run must not see this one. */
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1)
+    {
+        perror("Lockstep Open Failed.");
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(lockstepShared_t)) == -1)
+    {
+        perror("Lockstep Resize Failed.");
+        close(fd);
+        return NULL;
+    }
+    shm = mapLockstep(fd);
+    if (shm != NULL)
+    {
+        shm->tick_ns  = tick_ns;
+        shm->coordPid = (int32_t) getpid();
+    }
+    return shm;
+}
+
+unsigned int releaseLockstepStage(lockstepShared_t* shm, uint64_t tick, unsigned int stage)
+{
+    uint32_t num = atomic_load(&shm->numMembers[stage]);
+
+    if (num == 0)
+    {
+        return 0;
+    }
+    atomic_store(&shm->pending, num);
+    atomic_store(&shm->stage, stage);
+    atomic_store(&shm->tick, tick);
+    atomic_fetch_add(&shm->phase, 1);
+    futexWakeAll(&shm->phase);
+    return num;
+}
+
+int waitLockstepStage(lockstepShared_t* shm, int timeoutMs)
+{
+    uint32_t left = atomic_load(&shm->pending);
+
+    if (left == 0)
+    {
+        return 0;
+    }
+    futexWait(&shm->pending, left, timeoutMs);
+    return (atomic_load(&shm->pending) == 0) ? 0 : -1;
+}
+
+void stopLockstep(lockstepShared_t* shm)
+{
+    atomic_store(&shm->stop, 1);
+    atomic_fetch_add(&shm->phase, 1);
+    futexWakeAll(&shm->phase);
+}
+
+void closeLockstep(lockstepShared_t* shm, const char* name)
+{
+    if (shm == NULL)
+    {
+        return;
+    }
+    munmap(shm, sizeof(lockstepShared_t));
+    if (name != NULL)
+    {
+        shm_unlink(name);
+    }
+}
+
+int joinLockstep(lockstepMember_t* m, const char* name, unsigned int stage, int timeoutMs)
+{
+    struct timespec retry = {0, 10000000L};
+    int             fd;
+
+    if (stage >= lockstepMaxStages)
+    {
+        return -1;
+    }
+    /* The coordinator creates the segment, it may not be up yet. */
+    while ((fd = shm_open(name, O_RDWR, 0600)) == -1)
+    {
+        if ((errno != ENOENT) || (timeoutMs <= 0))
+        {
+            perror("Lockstep Join Failed.");
+            return -1;
+        }
+        nanosleep(&retry, NULL);
+        timeoutMs -= 10;
+    }
+    m->shm = mapLockstep(fd);
+    if (m->shm == NULL)
+    {
+        return -1;
+    }
+    m->stage     = stage;
+    m->seenPhase = atomic_load(&m->shm->phase);
+    m->active    = 0;
+    m->numTicks  = 0;
+    atomic_fetch_add(&m->shm->numMembers[stage], 1);
+    atomic_fetch_add(&m->shm->numJoined, 1);
+    return 0;
+}
+
+static void ackLockstep(lockstepMember_t* m)
+{
+    m->active = 0;
+    if (atomic_fetch_sub(&m->shm->pending, 1) == 1)
+    {
+        futexWakeAll(&m->shm->pending);
+    }
+}
+
+int awaitLockstep(lockstepMember_t* m)
+{
+    lockstepShared_t* shm = m->shm;
+
+    if (m->active == 1)
+    {
+        ackLockstep(m);
+    }
+    while (atomic_load(&shm->stop) == 0)
+    {
+        uint32_t phase = atomic_load(&shm->phase);
+        uint32_t stage;
+        uint64_t tick;
+
+        if (phase == m->seenPhase)
+        {
+            if ((futexWait(&shm->phase, phase, 1000) == -1) && (errno == ETIMEDOUT) &&
+                (kill((pid_t) shm->coordPid, 0) == -1) && (errno == ESRCH))
+            {
+                fprintf(stderr, "Lockstep coordinator gone. \n");
+                return -1;
+            }
+            continue;
+        }
+        /* Stage and tick belong to this phase only if it did not move while reading them. */
+        stage = atomic_load(&shm->stage);
+        tick  = atomic_load(&shm->tick);
+        if (atomic_load(&shm->phase) != phase)
+        {
+            continue;
+        }
+        m->seenPhase = phase;
+        if (stage == m->stage)
+        {
+            m->active       = 1;
+            m->tickStart_ns = tick * shm->tick_ns;
+            m->tickEnd_ns   = m->tickStart_ns + shm->tick_ns;
+            m->numTicks++;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void leaveLockstep(lockstepMember_t* m)
+{
+    /* The stage may be released and counting on this member, so leave only from inside a tick. */
+    if ((m->active == 0) && (awaitLockstep(m) == -1))
+    {
+        return;
+    }
+    atomic_fetch_sub(&m->shm->numMembers[m->stage], 1);
+    ackLockstep(m);
+}
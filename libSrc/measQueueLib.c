@@ -0,0 +1,92 @@
+//
+#include <string.h>
+
+#include "measQueueLib.h"
+
+size_t measQueueBytes(unsigned int capacity, size_t itemSize)
+{
+    /* Timestamps first, they keep the items 8 byte aligned. */
+    return (size_t) capacity * (sizeof(uint64_t) + itemSize);
+}
+
+int initMeasQueue(measQueue_t* q, void* mem, unsigned int capacity, size_t itemSize)
+{
+    if ((capacity == 0) || (mem == NULL))
+    {
+        return -1;
+    }
+    q->time_ns    = (uint64_t *) mem;
+    q->items      = (uint8_t *) mem + (size_t) capacity * sizeof(uint64_t);
+    q->itemSize   = itemSize;
+    q->capacity   = capacity;
+    q->head       = 0;
+    q->count      = 0;
+    q->numEvicted = 0;
+    q->numRefused = 0;
+    return 0;
+}
+
+static inline unsigned int measSlot(const measQueue_t* q, unsigned int i)
+{
+    return (q->head + i) % q->capacity;
+}
+
+int pushMeas(measQueue_t* q, uint64_t time_ns, const void* item, uint64_t evict_ns)
+{
+    unsigned int i;
+
+    if (q->count == q->capacity)
+    {
+        if (measTime(q, 0) > evict_ns)
+        {
+            q->numRefused++;
+            return -1;
+        }
+        q->head = measSlot(q, 1);
+        q->count--;
+        q->numEvicted++;
+    }
+
+    /* Shift the newer entries up one slot, usually none. */
+    for (i = q->count; (i > 0) && (measTime(q, i - 1) > time_ns); i--)
+    {
+        unsigned int to   = measSlot(q, i);
+        unsigned int from = measSlot(q, i - 1);
+
+        q->time_ns[to] = q->time_ns[from];
+        memcpy(q->items + (size_t) to * q->itemSize, q->items + (size_t) from * q->itemSize, q->itemSize);
+    }
+    q->time_ns[measSlot(q, i)] = time_ns;
+    memcpy(q->items + (size_t) measSlot(q, i) * q->itemSize, item, q->itemSize);
+    q->count++;
+    return 0;
+}
+
+unsigned int findMeasAfter(const measQueue_t* q, uint64_t time_ns)
+{
+    unsigned int lo = 0;
+    unsigned int hi = q->count;
+
+    while (lo < hi)
+    {
+        unsigned int mid = lo + (hi - lo) / 2;
+
+        if (measTime(q, mid) <= time_ns)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void trimMeas(measQueue_t* q, uint64_t time_ns)
+{
+    unsigned int num = findMeasAfter(q, time_ns);
+
+    q->head   = measSlot(q, num);
+    q->count -= num;
+}
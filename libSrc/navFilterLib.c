@@ -0,0 +1,212 @@
+//
+#include <math.h>
+
+#include "navFilterLib.h"
+
+size_t navFilterBytes(unsigned int histDepth, unsigned int measLen)
+{
+    return (size_t) histDepth * sizeof(navHist_t) + measQueueBytes(measLen, sizeof(navMeas_t));
+}
+
+int initNavFilter(navFilter_t* f, void* mem, unsigned int histDepth, unsigned int measLen,
+                  const navFilterCfg_t* cfg)
+{
+    if ((mem == NULL) || (histDepth == 0) || (cfg == NULL))
+    {
+        return -1;
+    }
+    f->cfg         = cfg;
+    f->valid       = 0;
+    f->hist        = (navHist_t *) mem;
+    f->histDepth   = histDepth;
+    f->histHead    = 0;
+    f->errLast_m   = 0.0;
+    f->errMax_m    = 0.0;
+    f->numRejected = 0;
+    f->numLate     = 0;
+    f->numRewinds  = 0;
+    f->numReplayed = 0;
+    f->cycle       = NULL;
+    f->update      = NULL;
+    f->rewind      = NULL;
+    return initMeasQueue(&f->meas, (uint8_t *) mem + (size_t) histDepth * sizeof(navHist_t), measLen,
+                         sizeof(navMeas_t));
+}
+
+/* Clock read for an optional histogram. */
+static inline uint64_t navClock(const timeHist_t* hist)
+{
+    return (hist != NULL) ? getTimeNs() : 0;
+}
+
+static inline void navRecord(timeHist_t* hist, uint64_t t0)
+{
+    if (hist != NULL)
+    {
+        addTimeHist(hist, getTimeNs() - t0);
+    }
+}
+
+void startNavFilter(navFilter_t* f, vec3_t pos_m, vec3_t vel_m_s, quat_t q_ib, uint64_t time_ns)
+{
+    initNavState(&f->nav, pos_m, vel_m_s, q_ib, time_ns);
+    initEskf(&f->kf, f->cfg->kf);
+    f->hist[0].nav = f->nav;
+    f->hist[0].kf  = f->kf;
+    f->histHead    = 1;
+    f->valid       = 1;
+}
+
+/* Propagate state and covariance to t_ns. The IMU sample carries rates, held over the interval. */
+static void navFilterPropagate(navFilter_t* f, vec3_t angRate_rad_s, vec3_t accel_m_s2, uint64_t t_ns)
+{
+    double dt     = (double) (t_ns - f->nav.time_ns) * 1e-9;
+    vec3_t dTheta = vec3Scale(angRate_rad_s, dt);
+    vec3_t dVel   = vec3Scale(accel_m_s2, dt);
+
+    eskfCorrectImu(&f->kf, &dTheta, &dVel, dt);
+    navPropagate(&f->nav, dTheta, dVel, dt);
+    eskfPropagate(&f->kf, &f->nav, dVel, dt);
+    f->nav.time_ns = t_ns;
+}
+
+static void navFilterApply(navFilter_t* f, const navMeas_t* meas)
+{
+    uint64_t t0 = navClock(f->update);
+
+    if (meas->kind == navMeasGnss)
+    {
+        f->errLast_m = vec3Norm(vec3Sub(meas->gnss.pos_m, f->nav.pos_m));
+        if (f->errLast_m > f->errMax_m)
+        {
+            f->errMax_m = f->errLast_m;
+        }
+        eskfUpdateGnss(&f->kf, &f->nav, meas->gnss.pos_m, meas->gnss.vel_m_s, f->cfg->gnssPosVar_m2,
+                       f->cfg->gnssVelVar_m2_s2);
+    }
+    else
+    {
+        eskfUpdateAttitude(&f->kf, &f->nav, meas->q_ib, f->cfg->attVar_rad2);
+    }
+    navRecord(f->update, t0);
+}
+
+/* Propagate to t_ns with the rates of one IMU sample, stopping at the queued measurements on the way. */
+static void navFilterAdvance(navFilter_t* f, vec3_t angRate_rad_s, vec3_t accel_m_s2, uint64_t t_ns)
+{
+    for (unsigned int i = findMeasAfter(&f->meas, f->nav.time_ns); i < f->meas.count; i++)
+    {
+        uint64_t tMeas = measTime(&f->meas, i);
+
+        if (tMeas > t_ns)
+        {
+            break;
+        }
+        if (tMeas > f->nav.time_ns)
+        {
+            navFilterPropagate(f, angRate_rad_s, accel_m_s2, tMeas);
+        }
+        navFilterApply(f, measItem(&f->meas, i));
+    }
+    if (t_ns > f->nav.time_ns)
+    {
+        navFilterPropagate(f, angRate_rad_s, accel_m_s2, t_ns);
+    }
+}
+
+/* Keep the state of this IMU step. Measurements no replay can reach any more leave the queue. */
+static void navFilterSave(navFilter_t* f, vec3_t angRate_rad_s, vec3_t accel_m_s2)
+{
+    navHist_t* h = &f->hist[f->histHead % f->histDepth];
+
+    h->nav           = f->nav;
+    h->kf            = f->kf;
+    h->angRate_rad_s = angRate_rad_s;
+    h->accel_m_s2    = accel_m_s2;
+    f->histHead++;
+    if (f->histHead >= f->histDepth)
+    {
+        trimMeas(&f->meas, f->hist[f->histHead % f->histDepth].nav.time_ns);
+    }
+}
+
+/*
+ * Restore the newest history entry before t_ns and replay the IMU steps after it, which now pick up the
+ * measurement just queued at t_ns. Returns -1 when the history does not reach back that far.
+ */
+static int navFilterRewind(navFilter_t* f, uint64_t t_ns)
+{
+    uint64_t t0     = navClock(f->rewind);
+    uint64_t oldest = (f->histHead > f->histDepth) ? (f->histHead - f->histDepth) : 0;
+    uint64_t k      = f->histHead;
+
+    while ((k > oldest) && (f->hist[(k - 1) % f->histDepth].nav.time_ns >= t_ns))
+    {
+        k--;
+    }
+    if (k == oldest)
+    {
+        return -1;
+    }
+    f->nav = f->hist[(k - 1) % f->histDepth].nav;
+    f->kf  = f->hist[(k - 1) % f->histDepth].kf;
+    for (; k < f->histHead; k++)
+    {
+        navHist_t* h = &f->hist[k % f->histDepth];
+
+        navFilterAdvance(f, h->angRate_rad_s, h->accel_m_s2, h->nav.time_ns);
+        h->nav = f->nav;
+        h->kf  = f->kf;
+        f->numReplayed++;
+    }
+    f->numRewinds++;
+    navRecord(f->rewind, t0);
+    return 0;
+}
+
+void navFilterImu(navFilter_t* f, vec3_t angRate_rad_s, vec3_t accel_m_s2, uint64_t t_ns)
+{
+    uint64_t t0 = navClock(f->cycle);
+
+    if ((f->valid == 0) || (t_ns <= f->nav.time_ns))
+    {
+        /* Older than the state, e.g. before the initial fix. */
+        return;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        if (!isfinite(angRate_rad_s.v[i]) || !isfinite(accel_m_s2.v[i]))
+        {
+            f->numRejected++;
+            return;
+        }
+    }
+    navFilterAdvance(f, angRate_rad_s, accel_m_s2, t_ns);
+    navFilterSave(f, angRate_rad_s, accel_m_s2);
+    navRecord(f->cycle, t0);
+}
+
+int navFilterMeasure(navFilter_t* f, uint64_t t_ns, const navMeas_t* meas)
+{
+    uint64_t first = (f->histHead > f->histDepth) ? (f->histHead - f->histDepth) : 0;
+
+    if (f->valid == 0)
+    {
+        return -1;
+    }
+    if (t_ns <= f->hist[first % f->histDepth].nav.time_ns)
+    {
+        f->numLate++;
+        return -1;
+    }
+    /* Only measurements the state already passed may make room, a pending one would be lost unseen. */
+    if (pushMeas(&f->meas, t_ns, meas, f->nav.time_ns) == -1)
+    {
+        return -1;
+    }
+    if (t_ns <= f->nav.time_ns)
+    {
+        navFilterRewind(f, t_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+//
+#include <string.h>
+
+#include "navLib.h"
+
+void initNavState(navState_t* nav, vec3_t pos_m, vec3_t vel_m_s, quat_t q_ib, uint64_t time_ns)
+{
+    memset(nav, 0, sizeof(*nav));
+    nav->q_ib     = quatNormalize(q_ib);
+    nav->vel_m_s  = vel_m_s;
+    nav->pos_m    = pos_m;
+    nav->mu_m3_s2 = navMuEarth_m3_s2;
+    nav->time_ns  = time_ns;
+}
+
+/* Point mass gravity at pos. */
+static vec3_t navGravity(const navState_t* nav, vec3_t pos)
+{
+    double r2 = vec3Dot(pos, pos);
+    double r  = sqrt(r2);
+
+    return vec3Scale(pos, -nav->mu_m3_s2 / (r2 * r));
+}
+
+void navPropagate(navState_t* nav, vec3_t dTheta, vec3_t dVel, double dt)
+{
+    mat3_t c_ib = quatToMat(nav->q_ib);
+    vec3_t coning;
+    vec3_t sculling;
+    vec3_t rotation;
+    vec3_t dVelBody;
+    vec3_t grav;
+    vec3_t velNew;
+
+    /* Coning: rotation vector of the step, not just the summed rates. */
+    coning = vec3Scale(vec3Cross(nav->prevDTheta, dTheta), 1.0 / 12.0);
+
+    /* Rotation of the velocity increment during the step, and sculling from rate and force correlation. */
+    rotation = vec3Scale(vec3Cross(dTheta, dVel), 0.5);
+    sculling = vec3Scale(vec3Add(vec3Cross(nav->prevDTheta, dVel), vec3Cross(nav->prevDVel, dTheta)), 1.0 / 12.0);
+    dVelBody = vec3Add(dVel, vec3Add(rotation, sculling));
+
+    /* Gravity at the predicted midpoint. */
+    grav   = navGravity(nav, vec3Add(nav->pos_m, vec3Scale(nav->vel_m_s, 0.5 * dt)));
+    velNew = vec3Add(nav->vel_m_s, vec3Add(mat3MulVec(&c_ib, dVelBody), vec3Scale(grav, dt)));
+
+    nav->pos_m      = vec3Add(nav->pos_m, vec3Scale(vec3Add(nav->vel_m_s, velNew), 0.5 * dt));
+    nav->vel_m_s    = velNew;
+    nav->q_ib       = quatNormalize(quatMul(nav->q_ib, quatFromRotVec(vec3Add(dTheta, coning))));
+    nav->prevDTheta = dTheta;
+    nav->prevDVel   = dVel;
+    nav->numSteps++;
+}
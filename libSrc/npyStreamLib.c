@@ -0,0 +1,210 @@
+//
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "npyStreamLib.h"
+
+/* Largest npy header we read ahead of the data. */
+#define npyStreamHeaderMax 65536U
+
+/* pread until size bytes are in or the file ends. */
+static ssize_t readFull(int fd, char* buf, size_t size, off_t offset)
+{
+    size_t done = 0;
+
+    while (done < size)
+    {
+        ssize_t ret = pread(fd, buf + done, size - done, offset + (off_t) done);
+        if (ret == 0)
+        {
+            break;
+        }
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t) ret;
+    }
+    return (ssize_t) done;
+}
+
+static void* npyPrefetchThread(void* argP)
+{
+    npyStream_t* st = (npyStream_t *) argP;
+    unsigned int fill = 0;
+
+    while (1)
+    {
+        size_t  rows;
+        ssize_t ret;
+        int     stop;
+
+        /* Wait until the reader hands the buffer back. */
+        pthread_mutex_lock(&st->lock);
+        while ((st->bufReady[fill] == 1) && (st->stop == 0))
+        {
+            pthread_cond_wait(&st->cond, &st->lock);
+        }
+        stop = st->stop;
+        pthread_mutex_unlock(&st->lock);
+        if (stop == 1)
+        {
+            break;
+        }
+
+        /* Read outside the lock, the reader is busy with the other buffer. */
+        rows = st->hdr.numRows - st->fillRow;
+        if (rows > st->chunkRows)
+        {
+            rows = st->chunkRows;
+        }
+        ret = readFull(st->fd, st->buf[fill], rows * st->hdr.rowSize,
+                       (off_t) (st->hdr.dataOffset + (st->fillRow * st->hdr.rowSize)));
+
+        pthread_mutex_lock(&st->lock);
+        if (ret != (ssize_t) (rows * st->hdr.rowSize))
+        {
+            st->ioError = 1;
+            rows        = 0;
+        }
+        st->fillRow       += rows;
+        st->bufRows[fill]  = rows;
+        st->bufReady[fill] = 1;
+        pthread_cond_broadcast(&st->cond);
+        pthread_mutex_unlock(&st->lock);
+
+        if (rows == 0)
+        {
+            /* End of file or error marker delivered. */
+            break;
+        }
+        fill ^= 1U;
+    }
+    return NULL;
+}
+
+int npyStreamOpen(interfaceCfg_t* cfg, npyStream_t* st, size_t chunkRows)
+{
+    char        head[npyStreamHeaderMax];
+    struct stat fst;
+    ssize_t     len;
+
+    st->fd = open(cfg->filePath, O_RDONLY);
+    if (st->fd == -1)
+    {
+        perror("Npy Open Failed.");
+        return -1;
+    }
+
+    len = readFull(st->fd, head, sizeof(head), 0);
+    if ((len <= 0) || (fstat(st->fd, &fst) == -1) ||
+        (npyParseHeader(head, (size_t) len, &st->hdr) == -1) ||
+        (st->hdr.fortranOrder == 1) || (st->hdr.endianness == '>') ||
+        ((st->hdr.dataOffset + (st->hdr.numRows * st->hdr.rowSize)) > (size_t) fst.st_size))
+    {
+        fprintf(stderr, "Unsupported npy file %s \n", cfg->filePath);
+        close(st->fd);
+        return -1;
+    }
+    posix_fadvise(st->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    st->chunkRows = (chunkRows == 0) ? npyStreamChunkRows : chunkRows;
+    st->buf[0]    = (char *) malloc(st->chunkRows * st->hdr.rowSize);
+    st->buf[1]    = (char *) malloc(st->chunkRows * st->hdr.rowSize);
+    if ((st->buf[0] == NULL) || (st->buf[1] == NULL))
+    {
+        free(st->buf[0]);
+        free(st->buf[1]);
+        close(st->fd);
+        return -1;
+    }
+
+    st->bufRows[0]  = 0;
+    st->bufRows[1]  = 0;
+    st->bufReady[0] = 0;
+    st->bufReady[1] = 0;
+    st->cur         = 0;
+    st->curHeld     = 0;
+    st->curIdx      = 0;
+    st->fillRow     = 0;
+    st->stop        = 0;
+    st->ioError     = 0;
+    st->numStalls   = 0;
+    pthread_mutex_init(&st->lock, NULL);
+    pthread_cond_init(&st->cond, NULL);
+
+    if (pthread_create(&st->thread, NULL, npyPrefetchThread, (void *) st) != 0)
+    {
+        pthread_mutex_destroy(&st->lock);
+        pthread_cond_destroy(&st->cond);
+        free(st->buf[0]);
+        free(st->buf[1]);
+        close(st->fd);
+        return -1;
+    }
+    return 0;
+}
+
+const char* npyStreamNextRow(npyStream_t* st)
+{
+    if ((st->curHeld == 1) && (st->curIdx < st->bufRows[st->cur]))
+    {
+        /* Fast path, no lock. The prefetcher does not touch a buffer the reader holds. */
+        return st->buf[st->cur] + (st->curIdx++ * st->hdr.rowSize);
+    }
+
+    pthread_mutex_lock(&st->lock);
+    if (st->curHeld == 1)
+    {
+        if (st->bufRows[st->cur] == 0)
+        {
+            /* End marker stays in place. */
+            pthread_mutex_unlock(&st->lock);
+            return NULL;
+        }
+        /* Chunk consumed, hand it back for refill and move to the other one. */
+        st->bufReady[st->cur] = 0;
+        st->curHeld = 0;
+        st->cur    ^= 1U;
+        st->curIdx  = 0;
+        pthread_cond_broadcast(&st->cond);
+    }
+    if (st->bufReady[st->cur] == 0)
+    {
+        st->numStalls++;
+        while (st->bufReady[st->cur] == 0)
+        {
+            pthread_cond_wait(&st->cond, &st->lock);
+        }
+    }
+    st->curHeld = 1;
+    pthread_mutex_unlock(&st->lock);
+
+    if (st->bufRows[st->cur] == 0)
+    {
+        return NULL;
+    }
+    return st->buf[st->cur] + (st->curIdx++ * st->hdr.rowSize);
+}
+
+int npyStreamClose(npyStream_t* st)
+{
+    pthread_mutex_lock(&st->lock);
+    st->stop = 1;
+    pthread_cond_broadcast(&st->cond);
+    pthread_mutex_unlock(&st->lock);
+    pthread_join(st->thread, NULL);
+
+    pthread_mutex_destroy(&st->lock);
+    pthread_cond_destroy(&st->cond);
+    free(st->buf[0]);
+    free(st->buf[1]);
+    return close(st->fd);
+}
@@ -0,0 +1,205 @@
+//
+#define _GNU_SOURCE                 // pthread_setaffinity_np
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "poolLib.h"
+
+static inline uint64_t poolRange(uint64_t next, uint64_t end)
+{
+    return (end << 32) | next;
+}
+
+int initPool(pool_t* pool, unsigned int numWorkers, int pin)
+{
+    if (numWorkers == 0)
+    {
+        numWorkers = 1;
+    }
+    pool->workers = (poolWorker_t *) aligned_alloc(64, numWorkers * sizeof(poolWorker_t));
+    if (pool->workers == NULL)
+    {
+        return -1;
+    }
+    pool->numWorkers = numWorkers;
+    pool->task       = NULL;
+    pool->ctx        = NULL;
+    atomic_init(&pool->stop, 0);
+    for (unsigned int i = 0; i < numWorkers; i++)
+    {
+        poolWorker_t* w = &pool->workers[i];
+
+        atomic_init(&w->range, 0);
+        w->owner     = pool;
+        w->id        = i;
+        w->cpu       = (pin != 0) ? (int) i : -1;
+        w->numRun    = 0;
+        w->numSteals = 0;
+    }
+    return 0;
+}
+
+/* Front index of the worker's own range. Returns -1 once it is empty. */
+static int poolTake(poolWorker_t* w, uint64_t* index)
+{
+    uint64_t r = atomic_load_explicit(&w->range, memory_order_relaxed);
+
+    while (1)
+    {
+        uint64_t next = r & 0xFFFFFFFFULL;
+        uint64_t end  = r >> 32;
+
+        if (next >= end)
+        {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak_explicit(&w->range, &r, poolRange(next + 1, end), memory_order_acq_rel,
+                                                  memory_order_relaxed))
+        {
+            *index = next;
+            return 0;
+        }
+    }
+}
+
+/* Move the upper half of the fullest other range, a last single task included, to w. Returns -1 if all are empty. */
+static int poolSteal(poolWorker_t* w)
+{
+    pool_t* pool = w->owner;
+
+    while (1)
+    {
+        poolWorker_t* victim = NULL;
+        uint64_t      r      = 0;
+        uint64_t      most   = 0;
+
+        for (unsigned int k = 1; k < pool->numWorkers; k++)
+        {
+            poolWorker_t* v    = &pool->workers[(w->id + k) % pool->numWorkers];
+            uint64_t      vr   = atomic_load_explicit(&v->range, memory_order_relaxed);
+            uint64_t      next = vr & 0xFFFFFFFFULL;
+            uint64_t      end  = vr >> 32;
+
+            if ((end > next) && (end - next > most))
+            {
+                victim = v;
+                r      = vr;
+                most   = end - next;
+            }
+        }
+        if (victim == NULL)
+        {
+            return -1;
+        }
+
+        uint64_t next = r & 0xFFFFFFFFULL;
+        uint64_t end  = r >> 32;
+        uint64_t mid  = next + (end - next) / 2;
+
+        if (atomic_compare_exchange_strong_explicit(&victim->range, &r, poolRange(next, mid), memory_order_acq_rel,
+                                                    memory_order_relaxed))
+        {
+            /* Own range is empty and nobody else writes an empty range, a plain store does. */
+            atomic_store_explicit(&w->range, poolRange(mid, end), memory_order_release);
+            w->numSteals++;
+            return 0;
+        }
+        /* Victim moved on, look again. */
+    }
+}
+
+static void* poolWorkerThread(void* argP)
+{
+    poolWorker_t* w    = (poolWorker_t *) argP;
+    pool_t*       pool = w->owner;
+    uint64_t      index;
+
+#if defined(__linux__)
+    if (w->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        {
+            fprintf(stderr, "Could not pin pool worker to CPU %d \n", w->cpu);
+        }
+    }
+#endif
+
+    while (atomic_load_explicit(&pool->stop, memory_order_relaxed) == 0)
+    {
+        if ((poolTake(w, &index) == -1) && ((poolSteal(w) == -1) || (poolTake(w, &index) == -1)))
+        {
+            break;
+        }
+        pool->task(pool->ctx, w->id, index);
+        w->numRun++;
+    }
+    return NULL;
+}
+
+uint64_t runPool(pool_t* pool, uint64_t numTasks, poolTask_t task, void* ctx)
+{
+    uint64_t total = 0;
+
+    if (numTasks > poolMaxTasks)
+    {
+        fprintf(stderr, "%lu tasks, at most %lu supported \n", (unsigned long) numTasks,
+                (unsigned long) poolMaxTasks);
+        return 0;
+    }
+    pool->task = task;
+    pool->ctx  = ctx;
+    /* Equal shares to start with, stealing evens out the rest. */
+    for (unsigned int i = 0; i < pool->numWorkers; i++)
+    {
+        poolWorker_t* w = &pool->workers[i];
+
+        atomic_store(&w->range, poolRange(numTasks * i / pool->numWorkers, numTasks * (i + 1) / pool->numWorkers));
+        w->numRun    = 0;
+        w->numSteals = 0;
+    }
+
+    if ((pool->numWorkers == 1) && (pool->workers[0].cpu < 0))
+    {
+        /* Single unpinned worker runs on the caller. */
+        poolWorkerThread(&pool->workers[0]);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < pool->numWorkers; i++)
+        {
+            pthread_create(&pool->workers[i].thread, NULL, poolWorkerThread, &pool->workers[i]);
+        }
+        for (unsigned int i = 0; i < pool->numWorkers; i++)
+        {
+            pthread_join(pool->workers[i].thread, NULL);
+        }
+    }
+    for (unsigned int i = 0; i < pool->numWorkers; i++)
+    {
+        total += pool->workers[i].numRun;
+    }
+    return total;
+}
+
+void stopPool(pool_t* pool)
+{
+    atomic_store(&pool->stop, 1);
+}
+
+void printPoolStats(pool_t* pool)
+{
+    for (unsigned int i = 0; i < pool->numWorkers; i++)
+    {
+        printf("Worker %u: %lu tasks, %lu steals \n", i, (unsigned long) pool->workers[i].numRun,
+               (unsigned long) pool->workers[i].numSteals);
+    }
+}
+
+void closePool(pool_t* pool)
+{
+    free(pool->workers);
+}
@@ -0,0 +1,145 @@
+//
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "residualLib.h"
+
+int initResidualUnit(residualUnit_t* unit, const residualCfg_t* cfg, unsigned int numChannels)
+{
+    if ((numChannels == 0) || (numChannels > residualMaxChannels) || !(cfg->alpha > 0.0) || (cfg->alpha > 1.0))
+    {
+        fprintf(stderr, "Bad residual config \n");
+        return -1;
+    }
+    for (unsigned int k = 0; k < numChannels; k++)
+    {
+        if (!(cfg->sigma[k] > 0.0))
+        {
+            fprintf(stderr, "Residual sigma of channel %u must be positive \n", k);
+            return -1;
+        }
+    }
+    memset(unit, 0, sizeof(*unit));
+    unit->cfg         = cfg;
+    unit->numChannels = numChannels;
+    return 0;
+}
+
+/* One channel sample. Returns the fault bits it raises. */
+static uint32_t updateResidualChannel(residualChannel_t* ch, const residualCfg_t* cfg, double sigma,
+                                      double value, double ref)
+{
+    uint32_t faults = 0;
+    double   r      = value - ref;
+    double   z      = r / sigma;
+    double   delta  = r - ch->mean;
+
+    /* Welford. */
+    ch->n++;
+    ch->mean += delta / (double) ch->n;
+    ch->m2   += delta * (r - ch->mean);
+
+    /* CUSUM, both directions. */
+    ch->cusumPos = fmax(0.0, ch->cusumPos + z - cfg->cusumSlack);
+    ch->cusumNeg = fmax(0.0, ch->cusumNeg - z - cfg->cusumSlack);
+    if ((ch->cusumPos > cfg->cusumLimit) || (ch->cusumNeg > cfg->cusumLimit))
+    {
+        faults |= residualBias;
+    }
+
+    if (ch->n == 1)
+    {
+        ch->ewma  = r;
+        ch->slope = 0.0;
+    }
+    else
+    {
+        ch->ewma  += cfg->alpha * (r - ch->ewma);
+        ch->slope += cfg->alpha * ((r - ch->prevResid) - ch->slope);
+
+        /* A ramp keeps the slope up, a step lets it decay, so require it for a full window. */
+        if ((fabs(ch->slope) / (cfg->alpha * sigma)) > cfg->driftLimit)
+        {
+            if ((double) ++ch->driftRun >= (1.0 / cfg->alpha))
+            {
+                faults |= residualDrift;
+            }
+        }
+        else
+        {
+            ch->driftRun = 0;
+        }
+
+        if ((value == ch->prevValue) && (ref != ch->prevRef))
+        {
+            if (++ch->stuckRun >= cfg->stuckSamples)
+            {
+                faults |= residualStuck;
+            }
+        }
+        else
+        {
+            ch->stuckRun = 0;
+        }
+    }
+    ch->prevResid = r;
+    ch->prevValue = value;
+    ch->prevRef   = ref;
+    return faults;
+}
+
+uint32_t updateResidualUnit(residualUnit_t* unit, const double* value, const double* ref)
+{
+    uint32_t raised = 0;
+
+    for (unsigned int k = 0; k < unit->numChannels; k++)
+    {
+        uint32_t faults;
+
+        if (!isfinite(value[k]) || !isfinite(ref[k]))
+        {
+            continue;
+        }
+        faults = updateResidualChannel(&unit->ch[k], unit->cfg, unit->cfg->sigma[k], value[k], ref[k]);
+        if ((faults & ~unit->faults) != 0)
+        {
+            if (unit->faults == 0)
+            {
+                unit->faultChannel = k;
+            }
+            raised       |= faults & ~unit->faults;
+            unit->faults |= faults;
+        }
+    }
+    return raised;
+}
+
+double getResidualStd(const residualChannel_t* ch)
+{
+    return (ch->n > 1) ? sqrt(ch->m2 / (double) (ch->n - 1)) : 0.0;
+}
+
+const char* residualFaultStr(uint32_t faults, char* buf)
+{
+    char* p = buf;
+
+    if (faults & residualBias)
+    {
+        *p++ = 'B';
+    }
+    if (faults & residualDrift)
+    {
+        *p++ = 'D';
+    }
+    if (faults & residualStuck)
+    {
+        *p++ = 'S';
+    }
+    if (p == buf)
+    {
+        *p++ = '-';
+    }
+    *p = '\0';
+    return buf;
+}
@@ -0,0 +1,226 @@
+//
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rigConfigLib.h"
+
+/* Trim leading and trailing blanks in place. */
+static char* rigTrim(char* str)
+{
+    char* end;
+
+    while (isspace((unsigned char) *str))
+    {
+        str++;
+    }
+    end = str + strlen(str);
+    while ((end > str) && isspace((unsigned char) end[-1]))
+    {
+        end--;
+    }
+    *end = '\0';
+    return str;
+}
+
+/* Unsigned integer no larger than max. */
+static int rigParseUint(const char* val, unsigned long max, unsigned long* out)
+{
+    char* end;
+
+    *out = strtoul(val, &end, 0);
+    return ((end == val) || (*end != '\0') || (*out > max) || (val[0] == '-')) ? -1 : 0;
+}
+
+static int rigSetKey(rigConfig_t* rig, rigSensor_t* sensor, const char* key, const char* val)
+{
+    unsigned long num;
+    char*         end;
+
+    if (sensor == NULL)
+    {
+        if (strcmp(key, "ipcAddr") == 0)
+        {
+            snprintf(rig->ipcAddr, sizeof(rig->ipcAddr), "%s", val);
+            return 0;
+        }
+        if ((strcmp(key, "actPort") == 0) && (rigParseUint(val, 65535, &num) == 0))
+        {
+            rig->actPort = (uint16_t) num;
+            return 0;
+        }
+        return -1;
+    }
+    if (strcmp(key, "file") == 0)
+    {
+        snprintf(sensor->file, sizeof(sensor->file), "%s", val);
+        return 0;
+    }
+    if (strcmp(key, "rate_Hz") == 0)
+    {
+        sensor->rate_Hz = strtod(val, &end);
+        return ((end == val) || (*end != '\0') || !(sensor->rate_Hz > 0.0)) ? -1 : 0;
+    }
+    if (strcmp(key, "latency_ms") == 0)
+    {
+        sensor->latency_ms = strtod(val, &end);
+        return ((end == val) || (*end != '\0') || !(sensor->latency_ms >= 0.0)) ? -1 : 0;
+    }
+    if (strcmp(key, "units") == 0)
+    {
+        if ((rigParseUint(val, 1024, &num) == -1) || (num == 0))
+        {
+            return -1;
+        }
+        sensor->numUnits = (unsigned int) num;
+        return 0;
+    }
+    if ((strcmp(key, "fdirPort") == 0) || (strcmp(key, "gncPort") == 0))
+    {
+        if (rigParseUint(val, 65535, &num) == -1)
+        {
+            return -1;
+        }
+        *((key[0] == 'f') ? &sensor->fdirPort : &sensor->gncPort) = (uint16_t) num;
+        return 0;
+    }
+    return -1;
+}
+
+int loadRigConfig(rigConfig_t* rig, const char* path)
+{
+    FILE*        fp;
+    char         line[512];
+    unsigned int lineNum = 0;
+    rigSensor_t* sensor  = NULL;
+    int          ret     = 0;
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        perror("Rig Config Open Failed.");
+        return -1;
+    }
+
+    while ((ret == 0) && (fgets(line, sizeof(line), fp) != NULL))
+    {
+        char* str;
+        char* eq;
+
+        lineNum++;
+        if (strchr(line, '#') != NULL)
+        {
+            *strchr(line, '#') = '\0';
+        }
+        str = rigTrim(line);
+        if (*str == '\0')
+        {
+            continue;
+        }
+
+        if (*str == '[')
+        {
+            char* close = strchr(str, ']');
+            char* name  = str + 1;
+
+            sensor = NULL;
+            if ((close != NULL) && (close[1] == '\0'))
+            {
+                *close = '\0';
+                name   = rigTrim(name);
+                for (unsigned int t = 0; t < rig->numTypes; t++)
+                {
+                    if (strcmp(rig->sensor[t].name, name) == 0)
+                    {
+                        sensor = &rig->sensor[t];
+                    }
+                }
+            }
+            if (sensor == NULL)
+            {
+                fprintf(stderr, "%s:%u: unknown section %s \n", path, lineNum, name);
+                ret = -1;
+            }
+            continue;
+        }
+
+        eq = strchr(str, '=');
+        if (eq == NULL)
+        {
+            fprintf(stderr, "%s:%u: expected key = value \n", path, lineNum);
+            ret = -1;
+            continue;
+        }
+        *eq = '\0';
+        if (rigSetKey(rig, sensor, rigTrim(str), rigTrim(eq + 1)) == -1)
+        {
+            fprintf(stderr, "%s:%u: bad key or value for %s \n", path, lineNum, rigTrim(str));
+            ret = -1;
+        }
+    }
+    fclose(fp);
+    return ret;
+}
+
+/* Whether port is one of the FDIR unit ports of s. */
+static int rigInFdirRange(const rigSensor_t* s, unsigned long port)
+{
+    return (port >= s->fdirPort) && (port < (unsigned long) s->fdirPort + s->numUnits);
+}
+
+int checkRigPorts(const rigConfig_t* rig)
+{
+    int ret = 0;
+
+    for (unsigned int t = 0; t < rig->numTypes; t++)
+    {
+        const rigSensor_t* s = &rig->sensor[t];
+
+        if ((unsigned long) s->fdirPort + s->numUnits > 65536UL)
+        {
+            fprintf(stderr, "%s: %u units from FDIR port %u run past port 65535 \n", s->name, s->numUnits,
+                    s->fdirPort);
+            ret = -1;
+            continue;
+        }
+        if (rigInFdirRange(s, rig->actPort) == 1)
+        {
+            fprintf(stderr, "%s: FDIR ports %u-%u hold the actuator port %u \n", s->name, s->fdirPort,
+                    s->fdirPort + s->numUnits - 1, rig->actPort);
+            ret = -1;
+        }
+        for (unsigned int o = 0; o < rig->numTypes; o++)
+        {
+            const rigSensor_t* other = &rig->sensor[o];
+
+            if (rigInFdirRange(s, other->gncPort) == 1)
+            {
+                fprintf(stderr, "%s: FDIR ports %u-%u hold the %s GNC port %u \n", s->name, s->fdirPort,
+                        s->fdirPort + s->numUnits - 1, other->name, other->gncPort);
+                ret = -1;
+            }
+            /* Ranges overlap when either holds the start of the other, reported once per pair. */
+            if ((o > t) && ((rigInFdirRange(s, other->fdirPort) == 1) || (rigInFdirRange(other, s->fdirPort) == 1)))
+            {
+                fprintf(stderr, "%s: FDIR ports %u-%u overlap the %s FDIR ports %u-%u \n", s->name, s->fdirPort,
+                        s->fdirPort + s->numUnits - 1, other->name, other->fdirPort,
+                        other->fdirPort + other->numUnits - 1);
+                ret = -1;
+            }
+        }
+    }
+    return ret;
+}
+
+void printRigConfig(const rigConfig_t* rig)
+{
+    printf("Rig on %s, actuator port %u \n", rig->ipcAddr, rig->actPort);
+    for (unsigned int t = 0; t < rig->numTypes; t++)
+    {
+        const rigSensor_t* s = &rig->sensor[t];
+
+        printf("  %-5s %u units at %.1f Hz, %.1f ms latency, FDIR ports %u-%u, GNC port %u, %s \n", s->name,
+               s->numUnits, s->rate_Hz, s->latency_ms, s->fdirPort, s->fdirPort + s->numUnits - 1, s->gncPort, s->file);
+    }
+}
@@ -0,0 +1,282 @@
+//
+#define _GNU_SOURCE                 // pthread_setaffinity_np
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "schedLib.h"
+
+int initSched(sched_t* sch, unsigned int numWorkers, int pin, double scale)
+{
+    if (numWorkers == 0)
+    {
+        numWorkers = 1;
+    }
+    sch->workers = (schedWorker_t *) calloc(numWorkers, sizeof(schedWorker_t));
+    if (sch->workers == NULL)
+    {
+        return -1;
+    }
+    sch->numWorkers = numWorkers;
+    sch->numStreams = 0;
+    sch->streams    = NULL;
+    sch->scale      = scale;
+    sch->gate       = NULL;
+    sch->gateCtx    = NULL;
+    atomic_init(&sch->stop, 0);
+    for (unsigned int i = 0; i < numWorkers; i++)
+    {
+        sch->workers[i].owner = sch;
+        sch->workers[i].cpu   = (pin != 0) ? (int) i : -1;
+    }
+    return 0;
+}
+
+/* Heap order: earlier release first, then lower id, so equal releases run in registration order. */
+static int streamBefore(const schedStream_t* a, const schedStream_t* b)
+{
+    if (a->nextRelease_ns != b->nextRelease_ns)
+    {
+        return a->nextRelease_ns < b->nextRelease_ns;
+    }
+    return a->id < b->id;
+}
+
+static void heapSiftUp(schedWorker_t* w, unsigned int i)
+{
+    while (i > 0)
+    {
+        unsigned int parent = (i - 1) / 2;
+        if (!streamBefore(w->heap[i], w->heap[parent]))
+        {
+            break;
+        }
+        schedStream_t* tmp = w->heap[i];
+        w->heap[i]      = w->heap[parent];
+        w->heap[parent] = tmp;
+        i = parent;
+    }
+}
+
+static void heapSiftDown(schedWorker_t* w, unsigned int i)
+{
+    while (1)
+    {
+        unsigned int first = i;
+        unsigned int l     = (2 * i) + 1;
+        unsigned int r     = l + 1;
+
+        if ((l < w->heapSize) && streamBefore(w->heap[l], w->heap[first]))
+        {
+            first = l;
+        }
+        if ((r < w->heapSize) && streamBefore(w->heap[r], w->heap[first]))
+        {
+            first = r;
+        }
+        if (first == i)
+        {
+            break;
+        }
+        schedStream_t* tmp = w->heap[i];
+        w->heap[i]     = w->heap[first];
+        w->heap[first] = tmp;
+        i = first;
+    }
+}
+
+schedStream_t* addSchedStream(sched_t* sch, const char* name, double rate_Hz, double phase_s,
+                              schedCallback_t callback, void* ctx)
+{
+    schedWorker_t* w = &sch->workers[0];
+    schedStream_t* s;
+
+    if (rate_Hz <= 0.0)
+    {
+        return NULL;
+    }
+    for (unsigned int i = 1; i < sch->numWorkers; i++)
+    {
+        if (sch->workers[i].load < w->load)
+        {
+            w = &sch->workers[i];
+        }
+    }
+    if (w->heapSize == w->heapCap)
+    {
+        unsigned int    cap  = (w->heapCap == 0) ? 16 : (2 * w->heapCap);
+        schedStream_t** heap = (schedStream_t **) realloc(w->heap, cap * sizeof(schedStream_t *));
+        if (heap == NULL)
+        {
+            return NULL;
+        }
+        w->heap    = heap;
+        w->heapCap = cap;
+    }
+
+    s = (schedStream_t *) calloc(1, sizeof(schedStream_t));
+    if (s == NULL)
+    {
+        return NULL;
+    }
+    s->name           = name;
+    s->callback       = callback;
+    s->ctx            = ctx;
+    s->period_s       = 1 / rate_Hz;
+    s->phase_ns       = (uint64_t) ((phase_s * 1e9) + 0.5);
+    s->nextRelease_ns = s->phase_ns;
+    s->id             = sch->numStreams++;
+    s->worker         = (unsigned int) (w - sch->workers);
+    s->load           = rate_Hz;
+    atomic_init(&s->numRuns, 0);
+    atomic_init(&s->numOverruns, 0);
+    initTimeHist(&s->lateness);
+    initTimeHist(&s->execTime);
+    s->next           = sch->streams;
+    sch->streams      = s;
+
+    w->load += rate_Hz;
+    w->heap[w->heapSize] = s;
+    heapSiftUp(w, w->heapSize);
+    w->heapSize++;
+    return s;
+}
+
+static void* schedWorkerThread(void* argP)
+{
+    schedWorker_t* w   = (schedWorker_t *) argP;
+    sched_t*       sch = w->owner;
+
+#if defined(__linux__)
+    if (w->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        {
+            fprintf(stderr, "Could not pin scheduler worker to CPU %d \n", w->cpu);
+        }
+    }
+#endif
+
+    while ((w->heapSize > 0) && (atomic_load_explicit(&sch->stop, memory_order_relaxed) == 0))
+    {
+        schedStream_t* s      = w->heap[0];
+        int            paced  = ((sch->gate == NULL) && (sch->scale > 0.0));
+        uint64_t       runs;
+        uint64_t       start;
+        uint64_t       end;
+        int            ret;
+
+        if (sch->gate != NULL)
+        {
+            if (sch->gate(sch->gateCtx, s->nextRelease_ns) == -1)
+            {
+                break;
+            }
+        }
+        else
+        {
+            vClockWaitUntil(&sch->clock, s->nextRelease_ns);
+        }
+        start = getTimeNs();
+        if (paced == 1)
+        {
+            uint64_t due = vClockToWallNs(&sch->clock, s->nextRelease_ns);
+            addTimeHist(&s->lateness, (start > due) ? (start - due) : 0);
+        }
+
+        ret = s->callback(s->ctx, s->nextRelease_ns);
+        end = getTimeNs();
+        addTimeHist(&s->execTime, end - start);
+        if (ret == -1)
+        {
+            /* Retire. The stream stays on the scheduler list for its stats. */
+            w->heapSize--;
+            w->heap[0] = w->heap[w->heapSize];
+            heapSiftDown(w, 0);
+            continue;
+        }
+        runs = atomic_fetch_add_explicit(&s->numRuns, 1, memory_order_relaxed) + 1;
+        /* Release k is at phase + k periods, so per stream phase never drifts. */
+        s->nextRelease_ns = s->phase_ns + (uint64_t) (((double) runs * s->period_s * 1e9) + 0.5);
+        if ((paced == 1) && (end > vClockToWallNs(&sch->clock, s->nextRelease_ns)))
+        {
+            /* The release ran into the next one of its stream, which now starts late. */
+            atomic_fetch_add_explicit(&s->numOverruns, 1, memory_order_relaxed);
+        }
+        heapSiftDown(w, 0);
+    }
+    return NULL;
+}
+
+void setSchedGate(sched_t* sch, schedGate_t gate, void* ctx)
+{
+    sch->gate    = gate;
+    sch->gateCtx = ctx;
+}
+
+uint64_t runSched(sched_t* sch)
+{
+    uint64_t total = 0;
+
+    /* Common time base for every worker. */
+    initVClock(&sch->clock, sch->scale);
+    if ((sch->numWorkers == 1) && (sch->workers[0].cpu < 0))
+    {
+        /* Single unpinned worker runs on the caller. */
+        schedWorkerThread(&sch->workers[0]);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < sch->numWorkers; i++)
+        {
+            pthread_create(&sch->workers[i].thread, NULL, schedWorkerThread, &sch->workers[i]);
+        }
+        for (unsigned int i = 0; i < sch->numWorkers; i++)
+        {
+            pthread_join(sch->workers[i].thread, NULL);
+        }
+    }
+    for (schedStream_t* s = sch->streams; s != NULL; s = s->next)
+    {
+        total += atomic_load(&s->numRuns);
+    }
+    return total;
+}
+
+void stopSched(sched_t* sch)
+{
+    atomic_store(&sch->stop, 1);
+}
+
+void printSchedStats(sched_t* sch)
+{
+    for (schedStream_t* s = sch->streams; s != NULL; s = s->next)
+    {
+        printf("%s: worker %u, %lu releases, %lu overruns. Lateness p99 <= %lu ns, max %lu ns. "
+               "Exec p99 <= %lu ns, max %lu ns \n", s->name, s->worker,
+               (unsigned long) atomic_load_explicit(&s->numRuns, memory_order_relaxed),
+               (unsigned long) atomic_load_explicit(&s->numOverruns, memory_order_relaxed),
+               (unsigned long) getTimeHistPercentile(&s->lateness, 0.99),
+               (unsigned long) atomic_load_explicit(&s->lateness.max_ns, memory_order_relaxed),
+               (unsigned long) getTimeHistPercentile(&s->execTime, 0.99),
+               (unsigned long) atomic_load_explicit(&s->execTime.max_ns, memory_order_relaxed));
+    }
+}
+
+void closeSched(sched_t* sch)
+{
+    while (sch->streams != NULL)
+    {
+        schedStream_t* s = sch->streams;
+        sch->streams = s->next;
+        free(s);
+    }
+    for (unsigned int i = 0; i < sch->numWorkers; i++)
+    {
+        free(sch->workers[i].heap);
+    }
+    free(sch->workers);
+}
@@ -0,0 +1,478 @@
+//
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "telemLib.h"
+#include "threadLib.h"
+
+/* Records per chunk the drain thread writes or prints in one go. */
+#define telemChunkRecs 1024U
+
+/* Longest conversion spec kept, "%-08.3ll" and the conversion. */
+#define telemSpecLen   16U
+
+/* One thread's records. Only that thread writes head, only the drain thread writes tail. */
+typedef struct
+{
+    _Alignas(64) _Atomic uint64_t head;             //< Next record to be written.
+    _Alignas(64) _Atomic uint64_t tail;             //< Next record to be drained.
+    _Alignas(64) _Atomic uint64_t numDropped;       //< Records lost on a full ring.
+    uint32_t                      seq;
+    uint16_t                      id;
+    telemRec_t                    rec[telemRingRecords];
+} telemRing_t;
+
+_Static_assert((telemRingRecords & (telemRingRecords - 1U)) == 0, "Telemetry ring size must be a power of two.");
+
+typedef struct
+{
+    atomic_int          on;
+    atomic_int          stop;
+    FILE*               fp;                         //< NULL prints text to stdout.
+    char                path[256];
+    pthread_t           drain;
+    uint64_t            start_ns;
+    _Atomic unsigned    numClaimed;                 //< Rings handed out, may pass telemMaxRings.
+    telemRing_t* _Atomic ring[telemMaxRings];       //< Published once allocated.
+    _Atomic uint64_t    numNoRing;                  //< Records of threads beyond telemMaxRings.
+    pthread_mutex_t     eventLock;
+    _Atomic unsigned    numEvents;
+    telemEventDef_t     event[telemMaxEvents];
+    unsigned int        numEventsOut;               //< Definitions already in the file. Drain thread only.
+    _Atomic uint64_t    numRecords;                 //< Drained.
+    _Atomic uint64_t    numBytes;                   //< Written to the file.
+    telemRec_t          out[telemChunkRecs];        //< Chunk being merged. Drain thread only.
+} telemLog_t;
+
+static telemLog_t telem = {.eventLock = PTHREAD_MUTEX_INITIALIZER};
+
+/* Ring of the calling thread, claimed on its first record. Rings outlive their threads. */
+static _Thread_local telemRing_t* telemSelf   = NULL;
+static _Thread_local int          telemNoRing = 0;
+
+/*
+ * Parse one conversion, *p just past its '%'. The spec without length modifier goes to spec. Returns the
+ * conversion character and moves *p past it, -1 for one not supported.
+ */
+static int telemParseConv(const char** p, char* spec)
+{
+    const char* s = *p;
+    size_t      n = 0;
+
+    spec[n++] = '%';
+    while ((*s != '\0') && (strchr("-+ #0", *s) != NULL) && (n < telemSpecLen - 4))
+    {
+        spec[n++] = *s++;
+    }
+    while ((((*s >= '0') && (*s <= '9')) || (*s == '.')) && (n < telemSpecLen - 4))
+    {
+        spec[n++] = *s++;
+    }
+    while ((*s != '\0') && (strchr("hlLqjzt", *s) != NULL))
+    {
+        s++;
+    }
+    spec[n] = '\0';
+    if ((*s == '\0') || (strchr("diuxXofeEgG", *s) == NULL))
+    {
+        return -1;
+    }
+    *p = s + 1;
+    return *s;
+}
+
+int checkTelemFmt(const char* fmt)
+{
+    char spec[telemSpecLen];
+    int  numConv = 0;
+
+    while (*fmt != '\0')
+    {
+        if (*fmt++ != '%')
+        {
+            continue;
+        }
+        if (*fmt == '%')
+        {
+            fmt++;
+            continue;
+        }
+        if ((telemParseConv(&fmt, spec) == -1) || (++numConv > (int) telemMaxArgs))
+        {
+            return -1;
+        }
+    }
+    return numConv;
+}
+
+int formatTelemRec(const telemEventDef_t* def, const telemRec_t* rec, char* buf, size_t size)
+{
+    const char*  p   = def->fmt;
+    const char*  end = def->fmt + strnlen(def->fmt, sizeof(def->fmt));
+    size_t       len = 0;
+    unsigned int arg = 0;
+
+    while (p < end)
+    {
+        char   spec[telemSpecLen];
+        char*  dst;
+        size_t room;
+        size_t n;
+        int    conv;
+        int    ret;
+
+        if ((*p != '%') || (p[1] == '%'))
+        {
+            /* Literal text, %% included. */
+            if (len + 1 < size)
+            {
+                buf[len] = *p;
+            }
+            len++;
+            p += (*p == '%') ? 2 : 1;
+            continue;
+        }
+        p++;
+        conv = telemParseConv(&p, spec);
+        if ((conv == -1) || (arg >= telemMaxArgs))
+        {
+            break;
+        }
+        dst  = (len < size) ? (buf + len) : NULL;
+        room = (len < size) ? (size - len) : 0;
+        n    = strlen(spec);
+        if (strchr("feEgG", conv) != NULL)
+        {
+            double v;
+
+            memcpy(&v, &rec->arg[arg], sizeof(v));
+            spec[n++] = (char) conv;
+            spec[n]   = '\0';
+            ret = snprintf(dst, room, spec, v);
+        }
+        else
+        {
+            /* Room was left for it by telemParseConv. */
+            spec[n++] = 'l';
+            spec[n++] = 'l';
+            spec[n++] = (char) conv;
+            spec[n]   = '\0';
+            if ((conv == 'd') || (conv == 'i'))
+            {
+                ret = snprintf(dst, room, spec, (long long) rec->arg[arg]);
+            }
+            else
+            {
+                ret = snprintf(dst, room, spec, (unsigned long long) rec->arg[arg]);
+            }
+        }
+        len += (ret > 0) ? (size_t) ret : 0;
+        arg++;
+    }
+    if (size > 0)
+    {
+        buf[(len < size) ? len : (size - 1)] = '\0';
+    }
+    return (int) len;
+}
+
+int telemEvent(const char* name, const char* fmt)
+{
+    unsigned int num;
+    int          id = -1;
+
+    if ((strlen(name) >= telemNameLen) || (strlen(fmt) >= telemFmtLen) || (checkTelemFmt(fmt) == -1))
+    {
+        fprintf(stderr, "Telemetry event %s: unusable format \"%s\" \n", name, fmt);
+        return -1;
+    }
+    pthread_mutex_lock(&telem.eventLock);
+    num = atomic_load(&telem.numEvents);
+    for (unsigned int i = 0; i < num; i++)
+    {
+        if (strcmp(telem.event[i].name, name) == 0)
+        {
+            id = (int) i;
+        }
+    }
+    if ((id == -1) && (num < telemMaxEvents))
+    {
+        telemEventDef_t* def = &telem.event[num];
+
+        memset(def, 0, sizeof(*def));
+        def->id = num;
+        memcpy(def->name, name, strlen(name));
+        memcpy(def->fmt, fmt, strlen(fmt));
+        /* Readers only look at events below the count. */
+        atomic_store_explicit(&telem.numEvents, num + 1, memory_order_release);
+        id = (int) num;
+    }
+    pthread_mutex_unlock(&telem.eventLock);
+    if (id == -1)
+    {
+        fprintf(stderr, "Telemetry event %s: more than %u events \n", name, telemMaxEvents);
+    }
+    return id;
+}
+
+static telemRing_t* claimTelemRing(void)
+{
+    unsigned int idx = atomic_fetch_add(&telem.numClaimed, 1);
+    telemRing_t* r;
+
+    if (idx >= telemMaxRings)
+    {
+        telemNoRing = 1;
+        return NULL;
+    }
+    r = (telemRing_t *) aligned_alloc(64, sizeof(telemRing_t));
+    if (r == NULL)
+    {
+        telemNoRing = 1;
+        return NULL;
+    }
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->numDropped, 0);
+    r->seq    = 0;
+    r->id     = (uint16_t) idx;
+    telemSelf = r;
+    atomic_store_explicit(&telem.ring[idx], r, memory_order_release);
+    return r;
+}
+
+void telemLog(int event, uint64_t arg0, uint64_t arg1)
+{
+    telemRing_t* r = telemSelf;
+    telemRec_t*  rec;
+    uint64_t     head;
+
+    if ((atomic_load_explicit(&telem.on, memory_order_relaxed) == 0) || (event < 0))
+    {
+        return;
+    }
+    if ((r == NULL) && ((telemNoRing == 1) || ((r = claimTelemRing()) == NULL)))
+    {
+        atomic_fetch_add_explicit(&telem.numNoRing, 1, memory_order_relaxed);
+        return;
+    }
+
+    head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if ((head - atomic_load_explicit(&r->tail, memory_order_acquire)) >= telemRingRecords)
+    {
+        /* Full. The drain is behind, never wait for it. */
+        atomic_fetch_add_explicit(&r->numDropped, 1, memory_order_relaxed);
+        r->seq++;
+        return;
+    }
+    rec          = &r->rec[head & (telemRingRecords - 1U)];
+    rec->time_ns = getTimeNs();
+    rec->event   = (uint16_t) event;
+    rec->ring    = r->id;
+    rec->seq     = r->seq++;
+    rec->arg[0]  = arg0;
+    rec->arg[1]  = arg1;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+static void writeTelemChunk(uint32_t kind, const void* data, uint32_t size)
+{
+    telemChunk_t chunk = {kind, size};
+
+    if ((fwrite(&chunk, sizeof(chunk), 1, telem.fp) == 1) && (fwrite(data, size, 1, telem.fp) == 1))
+    {
+        atomic_fetch_add_explicit(&telem.numBytes, sizeof(chunk) + size, memory_order_relaxed);
+    }
+}
+
+/* Write or print the merged records of the current chunk. */
+static void flushTelemChunk(unsigned int numOut)
+{
+    if (numOut == 0)
+    {
+        return;
+    }
+    if (telem.fp != NULL)
+    {
+        /* Definitions first, so the decoder knows every event it meets. */
+        unsigned int numEvents = atomic_load_explicit(&telem.numEvents, memory_order_acquire);
+
+        for (; telem.numEventsOut < numEvents; telem.numEventsOut++)
+        {
+            writeTelemChunk(telemChunkEvent, &telem.event[telem.numEventsOut], sizeof(telemEventDef_t));
+        }
+        writeTelemChunk(telemChunkRecords, telem.out, numOut * sizeof(telemRec_t));
+    }
+    else
+    {
+        char line[256];
+
+        for (unsigned int i = 0; i < numOut; i++)
+        {
+            formatTelemRec(&telem.event[telem.out[i].event], &telem.out[i], line, sizeof(line));
+            puts(line);
+        }
+    }
+    atomic_fetch_add_explicit(&telem.numRecords, numOut, memory_order_relaxed);
+}
+
+/* Empty every ring up to what it held at the start, merged by time. */
+static void drainTelem(void)
+{
+    telemRing_t* ring[telemMaxRings];
+    uint64_t     pos[telemMaxRings];
+    uint64_t     head[telemMaxRings];
+    unsigned int numRings = 0;
+    unsigned int numOut   = 0;
+
+    for (unsigned int i = 0; i < telemMaxRings; i++)
+    {
+        telemRing_t* r = atomic_load_explicit(&telem.ring[i], memory_order_acquire);
+
+        if (r != NULL)
+        {
+            ring[numRings] = r;
+            pos[numRings]  = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            head[numRings] = atomic_load_explicit(&r->head, memory_order_acquire);
+            numRings++;
+        }
+    }
+
+    while (1)
+    {
+        int next = -1;
+
+        /* Every ring is in time order already, take the oldest head. */
+        for (unsigned int k = 0; k < numRings; k++)
+        {
+            if ((pos[k] < head[k]) &&
+                ((next == -1) || (ring[k]->rec[pos[k] & (telemRingRecords - 1U)].time_ns <
+                                  ring[next]->rec[pos[next] & (telemRingRecords - 1U)].time_ns)))
+            {
+                next = (int) k;
+            }
+        }
+        if (next == -1)
+        {
+            break;
+        }
+        telem.out[numOut++] = ring[next]->rec[pos[next] & (telemRingRecords - 1U)];
+        pos[next]++;
+        if (numOut == telemChunkRecs)
+        {
+            flushTelemChunk(numOut);
+            numOut = 0;
+        }
+    }
+    flushTelemChunk(numOut);
+    for (unsigned int k = 0; k < numRings; k++)
+    {
+        /* Copied out, the writer may reuse the slots. */
+        atomic_store_explicit(&ring[k]->tail, pos[k], memory_order_release);
+    }
+    fflush((telem.fp != NULL) ? telem.fp : stdout);
+}
+
+static void* telemDrainThread(void* argP)
+{
+    struct timespec period = {0, telemDrainPeriod_ms * 1000000L};
+    (void) argP;
+
+    while (atomic_load(&telem.stop) == 0)
+    {
+        nanosleep(&period, NULL);
+        drainTelem();
+    }
+    /* What came in since the last pass. */
+    drainTelem();
+    return NULL;
+}
+
+int openTelem(const char* app)
+{
+    const char* dir = getenv("TEC_TELEM_DIR");
+
+    if (atomic_load(&telem.on) == 1)
+    {
+        return 0;
+    }
+    telem.fp       = NULL;
+    telem.start_ns = getTimeNs();
+    atomic_store(&telem.stop, 0);
+    if (dir != NULL)
+    {
+        telemFileHdr_t hdr;
+
+        snprintf(telem.path, sizeof(telem.path), "%s/%s.tlm", dir, app);
+        telem.fp = fopen(telem.path, "wb");
+        if (telem.fp == NULL)
+        {
+            perror("Telemetry File Open Failed.");
+            return -1;
+        }
+        memcpy(hdr.magic, telemMagic, sizeof(hdr.magic));
+        hdr.version  = telemVersion;
+        hdr.recSize  = sizeof(telemRec_t);
+        hdr.start_ns = telem.start_ns;
+        fwrite(&hdr, sizeof(hdr), 1, telem.fp);
+        atomic_store(&telem.numBytes, sizeof(hdr));
+        telem.numEventsOut = 0;
+    }
+    else
+    {
+        snprintf(telem.path, sizeof(telem.path), "stdout");
+    }
+    /* Signals stay with the application threads. */
+    sigset_t all;
+    sigset_t prev;
+    int      ret;
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &prev);
+    atomic_store(&telem.on, 1);
+    ret = pthread_create(&telem.drain, NULL, telemDrainThread, NULL);
+    pthread_sigmask(SIG_SETMASK, &prev, NULL);
+    if (ret != 0)
+    {
+        fprintf(stderr, "Could not start the telemetry drain \n");
+        atomic_store(&telem.on, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void closeTelem(void)
+{
+    if (atomic_exchange(&telem.on, 0) == 0)
+    {
+        return;
+    }
+    atomic_store(&telem.stop, 1);
+    pthread_join(telem.drain, NULL);
+    if (telem.fp != NULL)
+    {
+        fclose(telem.fp);
+        telem.fp = NULL;
+    }
+}
+
+void printTelemStats(void)
+{
+    unsigned int numRings   = atomic_load(&telem.numClaimed);
+    uint64_t     numDropped = atomic_load(&telem.numNoRing);
+
+    for (unsigned int i = 0; i < telemMaxRings; i++)
+    {
+        telemRing_t* r = atomic_load_explicit(&telem.ring[i], memory_order_acquire);
+
+        if (r != NULL)
+        {
+            numDropped += atomic_load_explicit(&r->numDropped, memory_order_relaxed);
+        }
+    }
+    printf("Telemetry: %lu records from %u threads to %s, %lu dropped, %lu bytes \n",
+           (unsigned long) atomic_load(&telem.numRecords), numRings, telem.path, (unsigned long) numDropped,
+           (unsigned long) atomic_load(&telem.numBytes));
+}
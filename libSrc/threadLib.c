@@ -1,21 +1,125 @@
 //
+#include <errno.h>
+#include <stdio.h>
+
 #include "threadLib.h"
 
-void setTaskPeriod(task_t *taskInfo, double freq)
+#define nsPerSec 1000000000L
+
+static uint64_t timespecToNs(const struct timespec *ts)
+{
+    return ((uint64_t) ts->tv_sec * (uint64_t) nsPerSec) + (uint64_t) ts->tv_nsec;
+}
+
+uint64_t getTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return timespecToNs(&now);
+}
+
+void initTimeHist(timeHist_t *hist)
+{
+    for (size_t i = 0; i < timeHistNumBuckets; i++)
+    {
+        atomic_init(&hist->count[i], 0);
+    }
+    atomic_init(&hist->numSamples, 0);
+    atomic_init(&hist->sum_ns, 0);
+    atomic_init(&hist->max_ns, 0);
+}
+
+/* Bucket index is the bit length of the value, constant time. */
+static unsigned int timeHistBucket(uint64_t ns)
+{
+    unsigned int bucket;
+
+    if (ns == 0)
+    {
+        return 0;
+    }
+#if defined(__GNUC__)
+    bucket = 64U - (unsigned int) __builtin_clzll(ns);
+#else
+    bucket = 0;
+    while (ns != 0)
+    {
+        bucket++;
+        ns >>= 1;
+    }
+#endif
+    return (bucket < timeHistNumBuckets) ? bucket : (timeHistNumBuckets - 1);
+}
+
+void addTimeHist(timeHist_t *hist, uint64_t ns)
 {
-    /* Obtain time period in seconds. */
-    double temp  = 1/freq;
-    /* Fractional part of the double. */
-    double frac  = temp - ((long) temp);
-    
-    long   seconds = (long) temp;
-    long   ns      = (long) (frac * 1000000000);
-    
-    taskInfo->taskPeriod.tv_sec  = seconds;
-    taskInfo->taskPeriod.tv_nsec = ns;
+    /* Single writer per histogram, relaxed is enough for readers taking snapshots. */
+    atomic_fetch_add_explicit(&hist->count[timeHistBucket(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->numSamples, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum_ns, ns, memory_order_relaxed);
+    if (ns > atomic_load_explicit(&hist->max_ns, memory_order_relaxed))
+    {
+        atomic_store_explicit(&hist->max_ns, ns, memory_order_relaxed);
+    }
 }
 
-int threadSleep(task_t *taskInfo)
+uint64_t getTimeHistPercentile(const timeHist_t *hist, double fraction)
 {
-    return (nanosleep(&taskInfo->taskPeriod, NULL));
+    uint64_t total = atomic_load_explicit(&hist->numSamples, memory_order_relaxed);
+    uint64_t want  = (uint64_t) ((double) total * fraction);
+    uint64_t max   = atomic_load_explicit(&hist->max_ns, memory_order_relaxed);
+    uint64_t seen  = 0;
+
+    for (unsigned int i = 0; i < timeHistNumBuckets; i++)
+    {
+        seen += atomic_load_explicit(&hist->count[i], memory_order_relaxed);
+        if ((seen > want) || ((seen == total) && (seen > 0)))
+        {
+            uint64_t bound = (i == 0) ? 0 : ((uint64_t) 1 << i);
+            /* The top bucket is never looser than the largest sample. */
+            return (bound < max) ? bound : max;
+        }
+    }
+    return 0;
+}
+
+void initVClock(vClock_t *clk, double scale)
+{
+    clk->scale = scale;
+    clock_gettime(CLOCK_MONOTONIC, &clk->start);
+}
+
+uint64_t vClockToWallNs(vClock_t *clk, uint64_t simTime_ns)
+{
+    if (clk->scale <= 0.0)
+    {
+        return timespecToNs(&clk->start);
+    }
+    return timespecToNs(&clk->start) + (uint64_t) ((double) simTime_ns / clk->scale);
+}
+
+int vClockWaitUntil(vClock_t *clk, uint64_t simTime_ns)
+{
+    struct timespec wake;
+    uint64_t        wall_ns;
+
+    if (clk->scale <= 0.0)
+    {
+        return 0;
+    }
+    wall_ns      = (uint64_t) ((double) simTime_ns / clk->scale);
+    wake.tv_sec  = clk->start.tv_sec + (time_t) (wall_ns / 1000000000U);
+    wake.tv_nsec = clk->start.tv_nsec + (long) (wall_ns % 1000000000U);
+    if (wake.tv_nsec >= 1000000000L)
+    {
+        wake.tv_sec++;
+        wake.tv_nsec -= 1000000000L;
+    }
+    /* Absolute deadline, so time spent sending does not accumulate. */
+    int ret;
+    do
+    {
+        ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+    } while (ret == EINTR);
+    return ret;
 }
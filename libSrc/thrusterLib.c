@@ -0,0 +1,350 @@
+//
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "thrusterLib.h"
+
+#define W thrWrenchDim
+
+int loadThrusterGeometry(thrAlloc_t* alloc, const char* path)
+{
+    FILE*        fp;
+    char         line[256];
+    unsigned int lineNum = 0;
+    int          ret     = 0;
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        perror("Thruster Geometry Open Failed.");
+        return -1;
+    }
+
+    while ((ret == 0) && (fgets(line, sizeof(line), fp) != NULL))
+    {
+        char*       str = line;
+        char*       hash;
+        thruster_t* t;
+        double      n;
+
+        lineNum++;
+        hash = strchr(str, '#');
+        if (hash != NULL)
+        {
+            *hash = '\0';
+        }
+        while (isspace((unsigned char) *str))
+        {
+            str++;
+        }
+        if (*str == '\0')
+        {
+            continue;
+        }
+        if (alloc->numThr == thrMaxThrusters)
+        {
+            fprintf(stderr, "%s:%u: more than %u thrusters \n", path, lineNum, thrMaxThrusters);
+            ret = -1;
+            break;
+        }
+
+        t = &alloc->thr[alloc->numThr];
+        if (sscanf(str, "%lf %lf %lf %lf %lf %lf %lf", &t->pos_m.v[0], &t->pos_m.v[1], &t->pos_m.v[2],
+                   &t->dir.v[0], &t->dir.v[1], &t->dir.v[2], &t->maxForce_N) != 7)
+        {
+            fprintf(stderr, "%s:%u: expected x y z dirX dirY dirZ maxForce \n", path, lineNum);
+            ret = -1;
+            break;
+        }
+        n = vec3Norm(t->dir);
+        if (!(n > 0.0) || !(t->maxForce_N > 0.0))
+        {
+            fprintf(stderr, "%s:%u: zero direction or force \n", path, lineNum);
+            ret = -1;
+            break;
+        }
+        t->dir = vec3Scale(t->dir, 1.0 / n);
+        alloc->numThr++;
+    }
+    fclose(fp);
+    return ret;
+}
+
+/* Solve the k x k system a x = b in place, Gauss elimination with partial pivoting. Returns -1 if singular. */
+static int thrSolve(double a[thrMaxThrusters][thrMaxThrusters], double* b, unsigned int k)
+{
+    for (unsigned int c = 0; c < k; c++)
+    {
+        unsigned int p = c;
+
+        for (unsigned int r = c + 1; r < k; r++)
+        {
+            if (fabs(a[r][c]) > fabs(a[p][c]))
+            {
+                p = r;
+            }
+        }
+        if (fabs(a[p][c]) < 1e-12)
+        {
+            return -1;
+        }
+        for (unsigned int j = 0; j < k; j++)
+        {
+            double t = a[c][j];
+            a[c][j]  = a[p][j];
+            a[p][j]  = t;
+        }
+        double t = b[c];
+        b[c]     = b[p];
+        b[p]     = t;
+        for (unsigned int r = c + 1; r < k; r++)
+        {
+            double f = a[r][c] / a[c][c];
+            for (unsigned int j = c; j < k; j++)
+            {
+                a[r][j] -= f * a[c][j];
+            }
+            b[r] -= f * b[c];
+        }
+    }
+    for (unsigned int r = k; r-- > 0;)
+    {
+        for (unsigned int j = r + 1; j < k; j++)
+        {
+            b[r] -= a[r][j] * b[j];
+        }
+        b[r] /= a[r][r];
+    }
+    return 0;
+}
+
+/* Least squares over the thrusters in set, A_set z = target, normal equations. */
+static int thrSubsetLs(double b[W][thrMaxThrusters], unsigned int n, const int* set, const double* target, double* z)
+{
+    double       ata[thrMaxThrusters][thrMaxThrusters];
+    double       atb[thrMaxThrusters];
+    unsigned int idx[thrMaxThrusters];
+    unsigned int k = 0;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        z[i] = 0.0;
+        if (set[i] == 1)
+        {
+            idx[k++] = i;
+        }
+    }
+    for (unsigned int r = 0; r < k; r++)
+    {
+        atb[r] = 0.0;
+        for (unsigned int w = 0; w < W; w++)
+        {
+            atb[r] += b[w][idx[r]] * target[w];
+        }
+        for (unsigned int c = 0; c < k; c++)
+        {
+            ata[r][c] = 0.0;
+            for (unsigned int w = 0; w < W; w++)
+            {
+                ata[r][c] += b[w][idx[r]] * b[w][idx[c]];
+            }
+        }
+    }
+    if (thrSolve(ata, atb, k) == -1)
+    {
+        return -1;
+    }
+    for (unsigned int r = 0; r < k; r++)
+    {
+        z[idx[r]] = atb[r];
+    }
+    return 0;
+}
+
+/* Non negative least squares, Lawson and Hanson. min |B x - target| with x >= 0. Returns the residual norm. */
+static double thrNnls(double b[W][thrMaxThrusters], unsigned int n, const double* target, double* x)
+{
+    int    set[thrMaxThrusters] = {0};
+    double z[thrMaxThrusters];
+    double res[W];
+    double norm = 0.0;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        x[i] = 0.0;
+    }
+    for (unsigned int iter = 0; iter < 3 * thrMaxThrusters; iter++)
+    {
+        unsigned int best  = n;
+        double       bestW = 1e-12;
+
+        /* Gradient of the residual for thrusters not in the set. */
+        for (unsigned int w = 0; w < W; w++)
+        {
+            res[w] = target[w];
+            for (unsigned int i = 0; i < n; i++)
+            {
+                res[w] -= b[w][i] * x[i];
+            }
+        }
+        for (unsigned int i = 0; i < n; i++)
+        {
+            double g = 0.0;
+            for (unsigned int w = 0; w < W; w++)
+            {
+                g += b[w][i] * res[w];
+            }
+            if ((set[i] == 0) && (g > bestW))
+            {
+                best  = i;
+                bestW = g;
+            }
+        }
+        if (best == n)
+        {
+            break;
+        }
+        set[best] = 1;
+
+        while (1)
+        {
+            double alpha = 1.0;
+
+            if (thrSubsetLs(b, n, set, target, z) == -1)
+            {
+                /* Dependent on the thrusters already in, leave it out. */
+                set[best] = 0;
+                break;
+            }
+            for (unsigned int i = 0; i < n; i++)
+            {
+                if ((set[i] == 1) && (z[i] <= 0.0) && (x[i] - z[i] > 0.0))
+                {
+                    double a = x[i] / (x[i] - z[i]);
+                    alpha    = (a < alpha) ? a : alpha;
+                }
+            }
+            for (unsigned int i = 0; i < n; i++)
+            {
+                x[i] += alpha * (z[i] - x[i]);
+                if ((set[i] == 1) && (x[i] <= 1e-12) && (alpha < 1.0))
+                {
+                    set[i] = 0;
+                    x[i]   = 0.0;
+                }
+            }
+            if (alpha >= 1.0)
+            {
+                break;
+            }
+        }
+    }
+
+    for (unsigned int w = 0; w < W; w++)
+    {
+        double r = target[w];
+        for (unsigned int i = 0; i < n; i++)
+        {
+            r -= b[w][i] * x[i];
+        }
+        norm += r * r;
+    }
+    return sqrt(norm);
+}
+
+int initThrusterAlloc(thrAlloc_t* alloc)
+{
+    double       b[W][thrMaxThrusters];             //< Wrench per unit force of each thruster.
+    unsigned int n         = alloc->numThr;
+    unsigned int numAxes   = 0;
+
+    memset(b, 0, sizeof(b));
+    for (unsigned int i = 0; i < n; i++)
+    {
+        vec3_t tq = vec3Cross(alloc->thr[i].pos_m, alloc->thr[i].dir);
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            b[k][i]     = alloc->thr[i].dir.v[k];
+            b[3 + k][i] = tq.v[k];
+        }
+    }
+
+    /* One table column per signed unit axis. An axis counts if at least one direction is reachable. */
+    alloc->complete = 1;
+    for (unsigned int w = 0; w < W; w++)
+    {
+        int reached = 0;
+
+        for (unsigned int sgn = 0; sgn < 2; sgn++)
+        {
+            double target[W] = {0.0};
+            double* col      = alloc->unit[sgn * W + w];
+
+            target[w] = (sgn == 0) ? 1.0 : -1.0;
+            if (thrNnls(b, n, target, col) > 1e-6)
+            {
+                /* Best effort towards the axis, the rest of the wrench goes astray. */
+                alloc->complete = 0;
+            }
+            else
+            {
+                reached = 1;
+            }
+        }
+        numAxes += reached;
+    }
+    if (numAxes < W)
+    {
+        fprintf(stderr, "Thrusters do not act on every axis \n");
+        return -1;
+    }
+    return 0;
+}
+
+void allocateThrusters(const thrAlloc_t* alloc, const double* wrench, double* duty)
+{
+    unsigned int n    = alloc->numThr;
+    double       peak = 0.0;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        duty[i] = 0.0;
+    }
+    /* Sum of the precomputed axes, each non negative. */
+    for (unsigned int w = 0; w < W; w++)
+    {
+        const double* col = alloc->unit[(wrench[w] < 0.0) ? W + w : w];
+        double        mag = fabs(wrench[w]);
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            duty[i] += mag * col[i];
+        }
+    }
+
+    /* Into the force limits, scaled together so the direction is kept. */
+    for (unsigned int i = 0; i < n; i++)
+    {
+        duty[i] /= alloc->thr[i].maxForce_N;
+        peak     = (duty[i] > peak) ? duty[i] : peak;
+    }
+    for (unsigned int i = 0; i < n; i++)
+    {
+        if (peak > 1.0)
+        {
+            duty[i] /= peak;
+        }
+        if (duty[i] < alloc->minDuty)
+        {
+            duty[i] = 0.0;
+        }
+    }
+}
+
+void printThrusterAlloc(const thrAlloc_t* alloc)
+{
+    printf("%u thrusters, %s, minimum duty %.3f \n", alloc->numThr,
+           (alloc->complete == 1) ? "any force and torque" : "not every wrench reachable", alloc->minDuty);
+}
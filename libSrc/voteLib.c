@@ -0,0 +1,184 @@
+//
+#include <stdio.h>
+#include <string.h>
+
+#include "voteLib.h"
+
+/* Branch free forms, so the lane loops vectorise without -ffast-math. */
+#define voteMin(a, b) (((a) < (b)) ? (a) : (b))
+#define voteMax(a, b) (((a) > (b)) ? (a) : (b))
+
+int initVoteFrame(voteFrame_t* frame, unsigned int numChannels, const double* tol)
+{
+    if ((numChannels == 0) || (numChannels > voteLanes))
+    {
+        fprintf(stderr, "Vote frame holds 1 to %u channels \n", voteLanes);
+        return -1;
+    }
+    memset(frame, 0, sizeof(*frame));
+    for (unsigned int k = 0; k < numChannels; k++)
+    {
+        if (!(tol[k] > 0.0))
+        {
+            fprintf(stderr, "Vote tolerance of channel %u must be positive \n", k);
+            return -1;
+        }
+        frame->invTol[k] = 1.0 / tol[k];
+    }
+    frame->numChannels = numChannels;
+    return 0;
+}
+
+void setVoteInput(voteFrame_t* frame, unsigned int unit, unsigned int lane, const double* val, unsigned int n)
+{
+    memcpy(&frame->in[unit][lane], val, n * sizeof(double));
+}
+
+/* 
+ * Larger unit sets. Odd even transposition sort of a copy, every compare exchange over all lanes at once.
+ * numUnits passes of numUnits / 2 exchanges, cheap for the few tens of units a rig has.
+ */
+static void voteSortMid(voteFrame_t* restrict frame, unsigned int numUnits)
+{
+    double sorted[voteMaxUnits][voteLanes];
+
+    memcpy(sorted, frame->in, numUnits * sizeof(sorted[0]));
+    for (unsigned int pass = 0; pass < numUnits; pass++)
+    {
+        for (unsigned int u = pass & 1U; (u + 1) < numUnits; u += 2)
+        {
+            double* restrict lo = sorted[u];
+            double* restrict hi = sorted[u + 1];
+
+            for (unsigned int k = 0; k < voteLanes; k++)
+            {
+                double l = voteMin(lo[k], hi[k]);
+                double h = voteMax(lo[k], hi[k]);
+                lo[k]    = l;
+                hi[k]    = h;
+            }
+        }
+    }
+    for (unsigned int k = 0; k < voteLanes; k++)
+    {
+        frame->mid[k] = 0.5 * (sorted[(numUnits - 1) / 2][k] + sorted[numUnits / 2][k]);
+    }
+}
+
+/* Mid value per lane. Fixed size compare networks for small unit counts. */
+static void voteMidLanes(voteFrame_t* restrict frame, unsigned int numUnits)
+{
+    const double* restrict a   = frame->in[0];
+    const double* restrict b   = frame->in[1];
+    const double* restrict c   = frame->in[2];
+    const double* restrict d   = frame->in[3];
+    double* restrict       mid = frame->mid;
+
+    switch (numUnits)
+    {
+        case 1:
+            for (unsigned int k = 0; k < voteLanes; k++)
+            {
+                mid[k] = a[k];
+            }
+            break;
+
+        case 2:
+            for (unsigned int k = 0; k < voteLanes; k++)
+            {
+                mid[k] = 0.5 * (a[k] + b[k]);
+            }
+            break;
+
+        case 3:
+            for (unsigned int k = 0; k < voteLanes; k++)
+            {
+                double lo = voteMin(a[k], b[k]);
+                double hi = voteMax(a[k], b[k]);
+                mid[k]    = voteMax(lo, voteMin(hi, c[k]));
+            }
+            break;
+
+        case 4:
+            /* The middle two are the larger low and the smaller high of the pairs. */
+            for (unsigned int k = 0; k < voteLanes; k++)
+            {
+                double lo = voteMax(voteMin(a[k], b[k]), voteMin(c[k], d[k]));
+                double hi = voteMin(voteMax(a[k], b[k]), voteMax(c[k], d[k]));
+                mid[k]    = 0.5 * (lo + hi);
+            }
+            break;
+
+        default:
+            voteSortMid(frame, numUnits);
+            break;
+    }
+}
+
+/* |in - mid| for every unit and lane, and each unit's largest deviation in tolerances. */
+static void voteDevLanes(voteFrame_t* restrict frame, unsigned int numUnits)
+{
+    double ratio[voteMaxUnits][voteLanes];
+
+    for (unsigned int u = 0; u < numUnits; u++)
+    {
+        for (unsigned int k = 0; k < voteLanes; k++)
+        {
+            double diff = frame->in[u][k] - frame->mid[k];
+
+            frame->absDev[u][k] = voteMax(diff, -diff);
+            /* Padding lanes have invTol 0 and never count. */
+            ratio[u][k] = frame->absDev[u][k] * frame->invTol[k];
+        }
+    }
+    for (unsigned int u = 0; u < numUnits; u++)
+    {
+        double worst = 0.0;
+
+        for (unsigned int k = 0; k < voteLanes; k++)
+        {
+            worst = voteMax(worst, ratio[u][k]);
+        }
+        frame->maxDev[u] = worst;
+    }
+}
+
+uint32_t voteMidValue(voteFrame_t* frame, unsigned int numUnits)
+{
+    uint32_t miscompare = 0;
+
+    if (numUnits > voteMaxUnits)
+    {
+        numUnits = voteMaxUnits;
+    }
+    frame->numUnits = numUnits;
+    if (numUnits == 0)
+    {
+        return 0;
+    }
+    voteMidLanes(frame, numUnits);
+    voteDevLanes(frame, numUnits);
+
+    for (unsigned int u = 0; u < numUnits; u++)
+    {
+        if (frame->maxDev[u] > 1.0)
+        {
+            miscompare |= 1U << u;
+        }
+    }
+    return miscompare;
+}
+
+unsigned int voteBestUnit(const voteFrame_t* frame)
+{
+    unsigned int best = 0;
+
+    for (unsigned int u = 1; u < frame->numUnits; u++)
+    {
+        if (frame->maxDev[u] < frame->maxDev[best])
+        {
+            best = u;
+        }
+    }
+    return best;
+}
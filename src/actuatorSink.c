@@ -0,0 +1,291 @@
+// & ()
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+#include "actuatorSink.h"
+#include "threadLib.h"
+#include "eventLoopLib.h"
+#include "captureLib.h"
+
+static const char* const sinkLatNames[numSinkLat] = {"gnc", "link", "valve", "total"};
+
+eventLoop_t    sinkLoop;
+ipcConfig_t    sinkIn;
+actCmd_u       sinkRxBuf;
+sinkStream_t   sinkStream;
+latencyTable_t sinkLatency;
+uint64_t       valveLatency_ns = sinkValveLatencyDefault_us * 1000ULL;
+
+/* Commands in flight through the valves, in arrival order. The latency is the same for all, so also in due order. */
+sinkPending_t  sinkQueue[sinkMaxInFlight];
+uint64_t       queueHead = 0;
+uint64_t       queueTail = 0;
+int            valveTimerFd = -1;
+
+/* Valve states the last applied command left, and how often each valve opened. */
+int            valveOpen[actMaxThrusters];
+uint64_t       valveCycles[actMaxThrusters];
+unsigned int   numValves = 0;
+
+/* SIGUSR1 prints the report, SIGINT and SIGTERM stop the loop. */
+int sinkSigFd = -1;
+
+/* The valves follow a command. */
+static void sinkApply(const sinkPending_t* p, uint64_t now)
+{
+    const actCmd_t* cmd    = &p->cmd;
+    unsigned int    sensor = (cmd->sensor < numGncSensorIf) ? cmd->sensor : 0U;
+    unsigned int    num    = (cmd->numActuators < actMaxThrusters) ? cmd->numActuators : actMaxThrusters;
+
+    for (unsigned int i = 0; i < num; i++)
+    {
+        int open = (cmd->duty[i] > 0.0);
+
+        if ((open == 1) && (valveOpen[i] == 0))
+        {
+            valveCycles[i]++;
+        }
+        valveOpen[i] = open;
+    }
+    if (num > numValves)
+    {
+        numValves = num;
+    }
+    addLatency(&sinkLatency, sensor, sinkLatGnc, cmd->gncRx_ns, cmd->sent_ns);
+    addLatency(&sinkLatency, sensor, sinkLatLink, cmd->sent_ns, p->rx_ns);
+    addLatency(&sinkLatency, sensor, sinkLatValve, p->rx_ns, now);
+    addLatency(&sinkLatency, sensor, sinkLatTotal, cmd->hdr.stamp_ns[stampRead], now);
+}
+
+/* Arm the valve timer for the oldest command in flight. */
+static void armValveTimer()
+{
+    struct itimerspec spec;
+
+    memset(&spec, 0, sizeof(spec));
+    if (queueHead != queueTail)
+    {
+        uint64_t due = sinkQueue[queueTail % sinkMaxInFlight].due_ns;
+
+        spec.it_value.tv_sec  = (time_t) (due / 1000000000ULL);
+        spec.it_value.tv_nsec = (long) (due % 1000000000ULL);
+        if ((spec.it_value.tv_sec == 0) && (spec.it_value.tv_nsec == 0))
+        {
+            /* A zero value disarms, anything in the past fires at once. */
+            spec.it_value.tv_nsec = 1;
+        }
+    }
+    if (timerfd_settime(valveTimerFd, TFD_TIMER_ABSTIME, &spec, NULL) == -1)
+    {
+        perror("Valve Timer Set Failed.");
+    }
+}
+
+/* Apply every command whose latency has passed. */
+static void sinkValveEvent(void* ctx)
+{
+    uint64_t expired;
+    uint64_t now = getTimeNs();
+    (void) ctx;
+
+    while (read(valveTimerFd, &expired, sizeof(expired)) == (ssize_t) sizeof(expired))
+    {
+    }
+    while ((queueHead != queueTail) && (sinkQueue[queueTail % sinkMaxInFlight].due_ns <= now))
+    {
+        sinkApply(&sinkQueue[queueTail % sinkMaxInFlight], now);
+        queueTail++;
+    }
+    armValveTimer();
+}
+
+/* Sequence and arrival bookkeeping of a received command. */
+static void sinkTrack(const actCmd_t* cmd, uint64_t rx_ns)
+{
+    sinkStream_t* s = &sinkStream;
+
+    if (s->numRx == 0)
+    {
+        s->firstRx_ns = rx_ns;
+        s->nextSeq    = cmd->hdr.seq;
+    }
+    else
+    {
+        addTimeHist(&s->interArrival, rx_ns - s->lastRx_ns);
+    }
+    s->numRx++;
+    s->lastRx_ns = rx_ns;
+
+    /* Wrap safe comparison against the next expected command number. Far behind it GNC has restarted. */
+    if (((int32_t) (cmd->hdr.seq - s->nextSeq) < 0) && ((s->nextSeq - cmd->hdr.seq) <= sinkMaxInFlight))
+    {
+        s->numStale++;
+        return;
+    }
+    if ((int32_t) (cmd->hdr.seq - s->nextSeq) > 0)
+    {
+        s->numGaps++;
+        s->numMissing += cmd->hdr.seq - s->nextSeq;
+    }
+    s->nextSeq = cmd->hdr.seq + 1U;
+}
+
+/* Command channel ready. Edge triggered, so drain everything queued. */
+static void sinkCmdEvent(void* ctx)
+{
+    int wasEmpty = (queueHead == queueTail);
+    (void) ctx;
+
+    while (recvMsgIPC(&sinkIn, sinkRxBuf.dataBuf, sizeof(sinkRxBuf.dataBuf)) >= 0)
+    {
+        uint64_t       now = getTimeNs();
+        sinkPending_t* p;
+
+        sinkTrack(&sinkRxBuf.data, now);
+        if ((queueHead - queueTail) == sinkMaxInFlight)
+        {
+            /* Keep the newest commands, the valves take the oldest one now. */
+            sinkStream.numOverflow++;
+            sinkApply(&sinkQueue[queueTail % sinkMaxInFlight], now);
+            queueTail++;
+        }
+        p         = &sinkQueue[queueHead % sinkMaxInFlight];
+        p->cmd    = sinkRxBuf.data;
+        p->rx_ns  = now;
+        p->due_ns = now + valveLatency_ns;
+        queueHead++;
+    }
+    if ((wasEmpty == 1) && (queueHead != queueTail))
+    {
+        /* The timer only needs to move when the head of the queue changed. */
+        armValveTimer();
+    }
+}
+
+static void printSinkReport()
+{
+    const sinkStream_t* s    = &sinkStream;
+    double              span = (double) (s->lastRx_ns - s->firstRx_ns) * 1e-9;
+
+    printf("Actuator commands: %lu received, %.1f per s, %lu gaps missing %lu, %lu stale, %lu applied early \n",
+           (unsigned long) s->numRx, (span > 0.0) ? (double) (s->numRx - 1) / span : 0.0,
+           (unsigned long) s->numGaps, (unsigned long) s->numMissing, (unsigned long) s->numStale,
+           (unsigned long) s->numOverflow);
+    printf("Command interval p50 %lu ns p99 %lu ns max %lu ns, %lu in flight \n",
+           (unsigned long) getTimeHistPercentile(&s->interArrival, 0.5),
+           (unsigned long) getTimeHistPercentile(&s->interArrival, 0.99),
+           (unsigned long) getTimeHistPercentile(&s->interArrival, 1.0), (unsigned long) (queueHead - queueTail));
+    for (unsigned int i = 0; i < numValves; i++)
+    {
+        printf("  Thruster %2u: %lu valve openings \n", i + 1, (unsigned long) valveCycles[i]);
+    }
+    printLatencyTable("Actuator Sink", &sinkLatency);
+}
+
+static void sinkSignalEvent(void* ctx)
+{
+    struct signalfd_siginfo info;
+    (void) ctx;
+
+    while (read(sinkSigFd, &info, sizeof(info)) == (ssize_t) sizeof(info))
+    {
+        if (info.ssi_signo == SIGUSR1)
+        {
+            printSinkReport();
+        }
+        else
+        {
+            stopEventLoop(&sinkLoop);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    rigConfig_t rig;
+    double      latency_us = sinkValveLatencyDefault_us;
+    int         opt;
+
+    while ((opt = getopt(argc, argv, "v:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'v':
+                /* Valve latency, in microseconds. */
+                latency_us = atof(optarg);
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-v valveLatency_us] \n", argv[0]);
+                return -1;
+        }
+    }
+    if (latency_us < 0.0)
+    {
+        fprintf(stderr, "Usage: %s [-v valveLatency_us] \n", argv[0]);
+        return -1;
+    }
+    valveLatency_ns = (uint64_t) (latency_us * 1000.0);
+
+    if ((initRigConfig(&rig) == -1) || (openCapture("ActuatorSink") == -1))
+    {
+        return -1;
+    }
+    setIpcAddrPort(&sinkIn, rig.ipcAddr, rig.actPort, INPUT);
+    if (sinkIn.ipcSock == -1)
+    {
+        return -1;
+    }
+    printf("Actuator sink on port %u, valve latency %.0f us \n", rig.actPort, latency_us);
+    initLatencyTable(&sinkLatency, sensorNames, numGncSensorIf, sinkLatNames, numSinkLat);
+    initTimeHist(&sinkStream.interArrival);
+
+    if (initEventLoop(&sinkLoop) == -1)
+    {
+        return -1;
+    }
+    valveTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (valveTimerFd == -1)
+    {
+        perror("Valve Timer Creation Failed.");
+        return -1;
+    }
+    addEventFd(&sinkLoop, valveTimerFd, sinkValveEvent, NULL);
+    addEventIPC(&sinkLoop, &sinkIn, sinkCmdEvent, NULL);
+
+    sigset_t sigSet;
+    sigemptyset(&sigSet);
+    sigaddset(&sigSet, SIGUSR1);
+    sigaddset(&sigSet, SIGINT);
+    sigaddset(&sigSet, SIGTERM);
+    sigprocmask(SIG_BLOCK, &sigSet, NULL);
+    sinkSigFd = signalfd(-1, &sigSet, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sinkSigFd == -1)
+    {
+        perror("Signal FD Failed.");
+    }
+    else
+    {
+        addEventFd(&sinkLoop, sinkSigFd, sinkSignalEvent, NULL);
+    }
+
+    runEventLoop(&sinkLoop);
+    closeCapture();
+    printSinkReport();
+    printCaptureStats();
+
+    if (sinkSigFd >= 0)
+    {
+        close(sinkSigFd);
+    }
+    close(valveTimerFd);
+    closeEventLoop(&sinkLoop);
+    closeIPC(&sinkIn);
+    return 0;
+}
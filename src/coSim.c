@@ -0,0 +1,184 @@
+// & ()
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+
+#include "config.h"
+#include "threadLib.h"
+#include "lockstepLib.h"
+
+/* Members of a full run: SensorsOut, the three FDIR sensor threads and GncMain. */
+#define coSimDefaultMembers 5U
+
+/* How often a wait looks at the signals. */
+#define coSimPoll_ms 100
+
+lockstepShared_t* coSim     = NULL;
+int               coSigFd   = -1;
+int               coStopped = 0;
+
+/* Wall time each stage took per tick. */
+timeHist_t        stageTime[numStepStages];
+
+/* SIGUSR1 prints the progress, SIGINT and SIGTERM stop the run. */
+static void coSimSignals(uint64_t tick, uint64_t t0)
+{
+    struct signalfd_siginfo info;
+
+    while ((coSigFd >= 0) && (read(coSigFd, &info, sizeof(info)) == (ssize_t) sizeof(info)))
+    {
+        if (info.ssi_signo == SIGUSR1)
+        {
+            printf("Tick %lu, %.3f s virtual after %.3f s \n", (unsigned long) tick,
+                   (double) (tick * coSim->tick_ns) * 1e-9, (double) (getTimeNs() - t0) * 1e-9);
+        }
+        else
+        {
+            coStopped = 1;
+        }
+    }
+}
+
+static void printCoSimReport(uint64_t numTicks, uint64_t wall_ns)
+{
+    double       virt_s  = (double) (numTicks * coSim->tick_ns) * 1e-9;
+    double       wall_s  = (double) wall_ns * 1e-9;
+    unsigned int slowest = 0;
+
+    printf("Lockstep: %lu ticks of %.3f ms, %.3f s virtual in %.3f s, %.1fx real time \n", (unsigned long) numTicks,
+           (double) coSim->tick_ns * 1e-6, virt_s, wall_s, (wall_s > 0.0) ? (virt_s / wall_s) : 0.0);
+    for (unsigned int s = 0; s < numStepStages; s++)
+    {
+        timeHist_t* h = &stageTime[s];
+
+        if (atomic_load(&h->sum_ns) > atomic_load(&stageTime[slowest].sum_ns))
+        {
+            slowest = s;
+        }
+        printf("  %-8s per tick p50 %lu ns p99 %lu ns max %lu ns, %.1f %% of the run \n", stepStageNames[s],
+               (unsigned long) getTimeHistPercentile(h, 0.5), (unsigned long) getTimeHistPercentile(h, 0.99),
+               (unsigned long) getTimeHistPercentile(h, 1.0),
+               (wall_ns > 0) ? (100.0 * (double) atomic_load(&h->sum_ns) / (double) wall_ns) : 0.0);
+    }
+    printf("Slowest stage: %s \n", stepStageNames[slowest]);
+}
+
+int main(int argc, char* argv[])
+{
+    double       tick_ms    = 1000.0 / imuRate_Hz;
+    double       end_s      = 0.0;
+    unsigned int numMembers = coSimDefaultMembers;
+    uint64_t     tick       = 0;
+    uint64_t     t0;
+    int          opt;
+
+    while ((opt = getopt(argc, argv, "t:n:e:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                /* Virtual time per tick. */
+                tick_ms = atof(optarg);
+                break;
+
+            case 'n':
+                /* Members to wait for before the first tick. */
+                numMembers = (unsigned int) atoi(optarg);
+                break;
+
+            case 'e':
+                /* Virtual end time, 0 runs until the sensors are out of data. */
+                end_s = atof(optarg);
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-t tick_ms] [-n numMembers] [-e end_s] \n", argv[0]);
+                return -1;
+        }
+    }
+    if (!(tick_ms > 0.0) || (end_s < 0.0) || (numMembers == 0))
+    {
+        fprintf(stderr, "Usage: %s [-t tick_ms] [-n numMembers] [-e end_s] \n", argv[0]);
+        return -1;
+    }
+
+    sigset_t sigSet;
+    sigemptyset(&sigSet);
+    sigaddset(&sigSet, SIGUSR1);
+    sigaddset(&sigSet, SIGINT);
+    sigaddset(&sigSet, SIGTERM);
+    sigprocmask(SIG_BLOCK, &sigSet, NULL);
+    coSigFd = signalfd(-1, &sigSet, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (coSigFd == -1)
+    {
+        perror("Signal FD Failed.");
+    }
+
+    coSim = createLockstep(lockstepName, (uint64_t) ((tick_ms * 1e6) + 0.5));
+    if (coSim == NULL)
+    {
+        return -1;
+    }
+    for (unsigned int s = 0; s < numStepStages; s++)
+    {
+        initTimeHist(&stageTime[s]);
+    }
+
+    printf("Lockstep coordinator, waiting for %u members \n", numMembers);
+    while ((atomic_load(&coSim->numJoined) < numMembers) && (coStopped == 0))
+    {
+        struct timespec retry = {0, 10000000L};
+
+        nanosleep(&retry, NULL);
+        coSimSignals(0, getTimeNs());
+    }
+    for (unsigned int s = 0; s < numStepStages; s++)
+    {
+        printf("  %-8s %u members \n", stepStageNames[s], atomic_load(&coSim->numMembers[s]));
+    }
+
+    t0 = getTimeNs();
+    while (coStopped == 0)
+    {
+        if ((end_s > 0.0) && ((double) (tick * coSim->tick_ns) * 1e-9 >= end_s))
+        {
+            break;
+        }
+        /* The stages of a tick one after the other, each sees all the previous one produced. */
+        for (unsigned int s = 0; (s < numStepStages) && (coStopped == 0); s++)
+        {
+            uint64_t ts = getTimeNs();
+
+            if (releaseLockstepStage(coSim, tick, s) == 0)
+            {
+                continue;
+            }
+            while ((waitLockstepStage(coSim, coSimPoll_ms) == -1) && (coStopped == 0))
+            {
+                coSimSignals(tick, t0);
+            }
+            addTimeHist(&stageTime[s], getTimeNs() - ts);
+        }
+        tick++;
+        coSimSignals(tick, t0);
+        if (atomic_load(&coSim->numMembers[stepSensors]) == 0)
+        {
+            /* Sensors are out of data and this tick carried their last samples downstream. */
+            break;
+        }
+    }
+    stopLockstep(coSim);
+    printCoSimReport(tick, getTimeNs() - t0);
+
+    closeLockstep(coSim, lockstepName);
+    if (coSigFd >= 0)
+    {
+        close(coSigFd);
+    }
+    return 0;
+}
@@ -1,108 +1,532 @@
 // & ()
 
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include "gnc.h"
-#include "threadLib.h"
-#include "interfaceLib.h"
-
-struct pollfd fds[3];
-
-/* IPC structures. */
-ipcConfig_t imuMsgConf;
-ipcConfig_t gnssMsgConf;
-ipcConfig_t strMsgConf;
-
-imuData_u    imuMsg;
-gnssData_u   gnssMsg;
-strTrkData_u stkMsg;
-
-int gncInit()
-{
-    printf("GNC Init... \n");
-    /* Set Socket IP and Ports. */
-    setIpcAddrPort(&imuMsgConf,  (char *) IPCAddr, ImuIpcPort, INPUT);
-    setIpcAddrPort(&gnssMsgConf, (char *) IPCAddr, GnssIpcPort, INPUT);
-    setIpcAddrPort(&strMsgConf,  (char *) IPCAddr, StrIpcPort, INPUT);
-    /* Set socket Directions. */
-    imuMsgConf.direction  = INPUT;
-    gnssMsgConf.direction = INPUT;
-    strMsgConf.direction  = INPUT;
-    /* Init the sockets. */
-    initIPC(&imuMsgConf);
-    initIPC(&gnssMsgConf);
-    initIPC(&strMsgConf);
-    /* Set sockets to the poll struct File descriptor. */
-    fds[0].fd = imuMsgConf.ipcSock;
-    fds[1].fd = gnssMsgConf.ipcSock;
-    fds[2].fd = strMsgConf.ipcSock;
-
-    initPollFd(fds, 3, POLLIN);
+
+/* GNC step rate and how many idle steps count as a sensor timeout. */
+#define gncRate_Hz       10.0
+#define gncTimeoutSteps  10U
+#define gncPeriod_ns     ((uint64_t) (1e9 / gncRate_Hz))
+
+/*
+ * IMU steps of navigation history, the oldest measurement time a late arrival can still be fused at. Unpaced,
+ * a GNSS fix can wait behind a full channel of IMU samples at FDIR and another at GNC, with room to spare.
+ */
+#define gncNavHistDepth  (4U * ipcShmNumSlots)
+/* GNSS fixes and attitudes held, within the history and up to a full channel of each ahead of the state. */
+#define gncMeasQueueLen  (4U * ipcShmNumSlots)
+
+/* Messages taken from one input before the next gets its turn. */
+#define gncDrainBurst    8U
+
+/* GNC side latency: transport from the previous hop, receive to actuate, and sensor read to actuate. */
+typedef enum
+{
+    gncLatLink  = 0,
+    gncLatGnc   = 1,
+    gncLatTotal = 2,
+    numGncLat   = 3
+} gncLatSpan_e;
+
+const char* const gncLatNames[numGncLat] = {"link", "gnc", "total"};
+
+_Static_assert(actMaxThrusters == maxNumActuators, "Actuator command must hold every actuator.");
+
+void initGncCfg(gncCfg_t* cfg)
+{
+    cfg->useLatest    = 0;
+    cfg->lockstep     = 0;
+    cfg->backpressure = 0;
+    cfg->stepped      = 0;
+    cfg->transport    = IPC_DEFAULT;
+    cfg->actTransport = IPC_DEFAULT;
+    cfg->rig          = NULL;
+    cfg->thr          = NULL;
+}
+
+/* Sensor channel ready. Edge triggered, the input stays ready until a drain round finds it empty. */
+static void gncSensorEvent(void* ctx)
+{
+    ((gncInput_t *) ctx)->ready = 1;
+}
+
+/*
+ * One round over the ready inputs, up to gncDrainBurst messages each, starting one input further every round.
+ * Draining one channel to the end would let the others fall behind by a whole ring. Returns 1 while any input
+ * is still ready.
+ */
+static int gncDrainInputs(gncStage_t* gnc)
+{
+    int pending = 0;
+
+    for (size_t k = 0; k < numGncSensorIf; k++)
+    {
+        gncInput_t*  in  = &gnc->inputs[(gnc->nextInput + k) % numGncSensorIf];
+        unsigned int num = 0;
+
+        while ((in->ready == 1) && (num < gncDrainBurst))
+        {
+            if (gncActuate(gnc, in->sensor, NULL) < 0)
+            {
+                in->ready = 0;
+                break;
+            }
+            gnc->rxSinceStep++;
+            num++;
+        }
+        pending |= in->ready;
+    }
+    gnc->nextInput = (gnc->nextInput + 1) % numGncSensorIf;
+    return pending;
+}
+
+static void gncStepEvent(void* ctx)
+{
+    gncStep((gncStage_t *) ctx);
+}
+
+int gncInit(gncStage_t* gnc, const gncCfg_t* cfg)
+{
+    rigConfig_t rig;
+
+    if (cfg->stepped == 0)
+    {
+        printf("GNC Init... \n");
+    }
+    memset(gnc, 0, sizeof(*gnc));
+    gnc->cfg          = *cfg;
+    gnc->nextStep_ns  = gncPeriod_ns;
+    gnc->actOnEvent   = telemEvent("actOn", "Setting Actuators 0x%03lx to On at %.3f s ");
+    gnc->actOffEvent  = telemEvent("actOff", "All Actuators Off at %.3f s ");
+    gnc->timeoutEvent = telemEvent("sensorTimeout", "Sensor Input Timed out. Timeout: %u ");
+    if (cfg->rig != NULL)
+    {
+        rig = *cfg->rig;
+    }
+    else if (initRigConfig(&rig) == -1)
+    {
+        return -1;
+    }
+    if (initArena(&gnc->arena, arenaSizeOf(numGncSensorIf * sizeof(gncInput_t)) +
+                               arenaSizeOf(navFilterBytes(gncNavHistDepth, gncMeasQueueLen))) == -1)
+    {
+        return -1;
+    }
+    gnc->inputs = arenaAlloc(&gnc->arena, numGncSensorIf * sizeof(gncInput_t));
+    if (initNavFilter(&gnc->nav, arenaAlloc(&gnc->arena, navFilterBytes(gncNavHistDepth, gncMeasQueueLen)),
+                      gncNavHistDepth, gncMeasQueueLen, &gncNavCfg) == -1)
+    {
+        return -1;
+    }
+    gnc->nav.cycle  = &gnc->navCycle;
+    gnc->nav.update = &gnc->navUpdate;
+    gnc->nav.rewind = &gnc->navRewind;
+    initLatencyTable(&gnc->latency, sensorNames, numGncSensorIf, gncLatNames, numGncLat);
+    initTimeHist(&gnc->navCycle);
+    initTimeHist(&gnc->navUpdate);
+    initTimeHist(&gnc->navRewind);
+    initTimeHist(&gnc->allocCycle);
+
+    if (cfg->thr != NULL)
+    {
+        gnc->thr = *cfg->thr;
+    }
+    else if (initThrusterConfig(&gnc->thr) == -1)
+    {
+        return -1;
+    }
+    else
+    {
+        printThrusterAlloc(&gnc->thr);
+    }
+    setIpcAddrPortTransport(&gnc->actOut, rig.ipcAddr, rig.actPort, OUTPUT, cfg->actTransport);
+    if (gnc->actOut.ipcSock == -1)
+    {
+        return -1;
+    }
+    if (cfg->backpressure == 1)
+    {
+        /* Waits only while an ActuatorSink has the channel open, a run without one keeps dropping. */
+        gnc->actOut.blockOnFull = 1;
+    }
+
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        gnc->inputs[i].owner  = gnc;
+        gnc->inputs[i].sensor = (sensorIn_e) i;
+    }
+    if (initEventLoop(&gnc->loop) == -1)
+    {
+        return -1;
+    }
+    if (cfg->useLatest == 1)
+    {
+        gnc->latest = openLatestTable(latestTableName);
+        if (gnc->latest == NULL)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        /* Set Socket IP and Ports. Opens the sockets as well. */
+        for (size_t i = 0; i < numGncSensorIf; i++)
+        {
+            gncInput_t* in = &gnc->inputs[i];
+
+            setIpcAddrPortTransport(&in->cfg, rig.ipcAddr, rig.sensor[i].gncPort, INPUT, cfg->transport);
+            if ((cfg->lockstep == 1) || (cfg->stepped == 1))
+            {
+                setIpcNonBlocking(&in->cfg);
+            }
+            else
+            {
+                addEventIPC(&gnc->loop, &in->cfg, gncSensorEvent, in);
+            }
+        }
+    }
+
+    if (cfg->lockstep == 1)
+    {
+        return joinLockstep(&gnc->stepMember, lockstepName, stepGnc, lockstepJoinTimeout_ms);
+    }
+    if (cfg->stepped == 1)
+    {
+        return 0;
+    }
+    addEventTimer(&gnc->loop, gncRate_Hz, gncStepEvent, gnc);
     return 0;
 }
 
-/* GNC Actuate. */
-void gncActuate(sensorIn_e sensor, actuatorData_t* actDat)
+/* Record the hops of a message that has just been acted on. */
+static void gncTrace(gncStage_t* gnc, sensorIn_e sensor, const msgHeader_t* hdr, uint64_t rx_ns)
+{
+    uint64_t now  = getTimeNs();
+    /* Without FDIR the previous hop is the sensor itself. */
+    uint64_t prev = (hdr->stamp_ns[stampFdirOut] != 0) ? hdr->stamp_ns[stampFdirOut] : hdr->stamp_ns[stampSent];
+
+    addLatency(&gnc->latency, sensor, gncLatLink, prev, rx_ns);
+    addLatency(&gnc->latency, sensor, gncLatGnc, rx_ns, now);
+    addLatency(&gnc->latency, sensor, gncLatTotal, hdr->stamp_ns[stampRead], now);
+}
+
+/* Start the navigation state at the time of the newest GNSS fix. */
+static void gncNavInit(gncStage_t* gnc)
+{
+    const gnssData_t*   gnss = &gnc->inputs[GNSS].msg.gnss.data;
+    const strTrkData_t* str  = &gnc->inputs[STK].msg.str.data;
+    vec3_t              pos;
+    vec3_t              vel;
+    quat_t              q_ib;
+
+    memcpy(pos.v, gnss->positionGd_m, sizeof(pos.v));
+    memcpy(vel.v, gnss->velocityEnu_m_s, sizeof(vel.v));
+    memcpy(q_ib.q, str->quaternion, sizeof(q_ib.q));
+    startNavFilter(&gnc->nav, pos, vel, q_ib, gnss->hdr.simTime_ns);
+    if (gnc->cfg.stepped == 1)
+    {
+        return;
+    }
+    printf("Navigation initialised at %.3f s \n", (double) gnss->hdr.simTime_ns * 1e-9);
+}
+
+/* Propagate to the time of an IMU sample, through the measurements due in between. */
+static void gncNavStep(gncStage_t* gnc, const imuData_t* imu)
+{
+    vec3_t angRate_rad_s;
+    vec3_t accel_m_s2;
+
+    if (gnc->nav.valid == 0)
+    {
+        if ((gnc->inputs[GNSS].numRx > 0) && (gnc->inputs[STK].numRx > 0))
+        {
+            gncNavInit(gnc);
+        }
+        return;
+    }
+    memcpy(angRate_rad_s.v, imu->angInc, sizeof(angRate_rad_s.v));
+    memcpy(accel_m_s2.v, imu->velInc, sizeof(accel_m_s2.v));
+    navFilterImu(&gnc->nav, angRate_rad_s, accel_m_s2, imu->hdr.simTime_ns);
+}
+
+/* GNSS fix or attitude into the navigation filter at its sensor time. */
+static void gncNavMeasure(gncStage_t* gnc, sensorIn_e sensor, const sensorMsg_u* msg)
+{
+    navMeas_t meas;
+
+    if (sensor == GNSS)
+    {
+        meas.kind = navMeasGnss;
+        memcpy(meas.gnss.pos_m.v, msg->gnss.data.positionGd_m, sizeof(meas.gnss.pos_m.v));
+        memcpy(meas.gnss.vel_m_s.v, msg->gnss.data.velocityEnu_m_s, sizeof(meas.gnss.vel_m_s.v));
+    }
+    else
+    {
+        meas.kind = navMeasAttitude;
+        memcpy(meas.q_ib.q, msg->str.data.quaternion, sizeof(meas.q_ib.q));
+    }
+    navFilterMeasure(&gnc->nav, msg->imu.data.hdr.simTime_ns, &meas);
+}
+
+/* Rate damping torque, allocated to the thrusters. */
+static void gncControl(gncStage_t* gnc, actuatorData_t* act, uint64_t simTime_ns)
+{
+    double   wrench[thrWrenchDim] = {0.0};
+    uint64_t t0                   = getTimeNs();
+    uint64_t mask                 = 0;
+
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        double rate = gnc->rate_rad_s.v[i] - ((gnc->nav.valid == 1) ? gnc->nav.kf.gyroBias.v[i] : 0.0);
+        wrench[3 + i] = -gncRateGain * rate;
+    }
+    allocateThrusters(&gnc->thr, wrench, act->duty);
+    act->numActuators = gnc->thr.numThr;
+    for (unsigned int i = 0; i < gnc->thr.numThr; i++)
+    {
+        act->actuatorState[i] = (act->duty[i] > 0.0);
+    }
+    addTimeHist(&gnc->allocCycle, getTimeNs() - t0);
+
+    /* Thruster i fires when bit i is set. */
+    for (unsigned int i = 0; i < act->numActuators; i++)
+    {
+        mask |= (uint64_t) (act->actuatorState[i] == 1) << i;
+    }
+    if (mask == 0)
+    {
+        telemLog(gnc->actOffEvent, telemF64((double) simTime_ns * 1e-9), 0);
+    }
+    else
+    {
+        telemLog(gnc->actOnEvent, mask, telemF64((double) simTime_ns * 1e-9));
+    }
+}
+
+/* Send the commanded duty cycles, stamped with the sensor message that caused them. */
+static void gncPublish(gncStage_t* gnc, const gncInput_t* in, uint64_t rx_ns, const actuatorData_t* act)
+{
+    actCmd_t* cmd = &gnc->cmd.data;
+
+    cmd->hdr          = in->msg.imu.data.hdr;
+    cmd->srcSeq       = cmd->hdr.seq;
+    cmd->hdr.seq      = gnc->actSeq++;
+    cmd->sensor       = (uint32_t) in->sensor;
+    cmd->gncRx_ns     = rx_ns;
+    cmd->numActuators = act->numActuators;
+    memcpy(cmd->duty, act->duty, act->numActuators * sizeof(cmd->duty[0]));
+    cmd->sent_ns      = getTimeNs();
+    if (sendMsgIPC(&gnc->actOut, gnc->cmd.dataBuf, sizeof(gnc->cmd.dataBuf)) < 0)
+    {
+        gnc->actDropped++;
+    }
+}
+
+/* Act on the message held in an input. */
+static void gncApply(gncStage_t* gnc, gncInput_t* in, uint64_t rx_ns, actuatorData_t* act)
 {
-    switch (sensor)
+    in->numRx++;
+    switch (in->sensor)
     {
         case IMU:
-            recvMsgIPC(&imuMsgConf, imuMsg.dataBuf, sizeof(imuData_t));
-            printf("Setting Actuators {5} to On \n");
+            gncNavStep(gnc, &in->msg.imu.data);
+            for (int i = 0; i < 3; i++)
+            {
+                if (isfinite(in->msg.imu.data.angInc[i]))
+                {
+                    gnc->rate_rad_s.v[i] = in->msg.imu.data.angInc[i];
+                }
+            }
             break;
 
         case GNSS:
-            recvMsgIPC(&gnssMsgConf, gnssMsg.dataBuf, sizeof(gnssData_t));
-            printf("Setting Actuators {2, 6} to On \n");
-            break;
-
         case STK:
-            recvMsgIPC(&strMsgConf, stkMsg.dataBuf, sizeof(strTrkData_t));
-            printf("Settings Actuators {1, 2, 3} to On \n");
+            gncNavMeasure(gnc, in->sensor, &in->msg);
             break;
 
         default:
             break;
     }
+    gncControl(gnc, act, in->msg.imu.data.hdr.simTime_ns);
+    gncPublish(gnc, in, rx_ns, act);
+    gncTrace(gnc, in->sensor, &in->msg.imu.data.hdr, rx_ns);
 }
 
-int main()
+/* GNC Actuate. Returns the received message size, -1 once the input is drained. */
+int gncActuate(gncStage_t* gnc, sensorIn_e sensor, actuatorData_t* actDat)
 {
-    task_t      gncTask;
-
-    gncInit();
-    setTaskPeriod(&gncTask, 10.0);
+    const size_t msgSize[numGncSensorIf] = {sizeof(imuData_t), sizeof(gnssData_t), sizeof(strTrkData_t)};
+    gncInput_t*  in = &gnc->inputs[sensor];
+    ssize_t      ret;
 
-    unsigned int timeOutCtr = 0;
+    ret = recvMsgIPC(&in->cfg, (uint8_t *) &in->msg, msgSize[sensor]);
+    if (ret >= 0)
+    {
+        gncApply(gnc, in, getTimeNs(), (actDat != NULL) ? actDat : &gnc->act);
+    }
+    return (int) ret;
+}
 
-    while (1)
+/* Take the newest sample of every sensor from the FDIR table. Samples published in between are skipped. */
+static void gncReadLatest(gncStage_t* gnc)
+{
+    for (size_t i = 0; i < numGncSensorIf; i++)
     {
-        int ret;
-        ret = poll(fds, 3, 1000);
-        /* Positive Retval indicates success. */
-        if (ret > 0)
+        gncInput_t* in  = &gnc->inputs[i];
+        uint32_t    gen = readLatest(gnc->latest, (unsigned int) i, &in->msg, sizeof(in->msg));
+
+        if (gen < in->lastGen)
         {
-            for (size_t i = 0; i < 3; i++)
-            {
-                /* Find the FD that caused poll to return. */
-                if (fds[i].revents == fds[i].events)
-                {
-                    /* Actuate away. */
-                    gncActuate((sensorIn_e) i, NULL);
-                }
-            }
+            /* FDIR started after this stage and reset the table, counting starts again. */
+            in->lastGen = 0;
         }
-        else if(ret == 0)
+        if (gen != in->lastGen)
         {
-            /* No data to be read. Or socket timeout. */
-            printf("Poll Timed out. \n");
-            timeOutCtr++;
+            in->numSkipped += gen - in->lastGen - 1U;
+            in->lastGen     = gen;
+            gncApply(gnc, in, getTimeNs(), &gnc->act);
+            gnc->rxSinceStep++;
         }
-        else
+    }
+}
+
+/* Periodic GNC step, driven by the loop timer. */
+void gncStep(gncStage_t* gnc)
+{
+    if (gnc->latest != NULL)
+    {
+        gncReadLatest(gnc);
+    }
+    if (gnc->rxSinceStep > 0)
+    {
+        gnc->idleSteps = 0;
+    }
+    else if (++gnc->idleSteps == gncTimeoutSteps)
+    {
+        /* No data to be read for a full second. */
+        gnc->timeOutCtr++;
+        gnc->idleSteps = 0;
+        telemLog(gnc->timeoutEvent, gnc->timeOutCtr, 0);
+    }
+    gnc->rxSinceStep = 0;
+}
+
+void stepGncStage(gncStage_t* gnc, uint64_t tickEnd_ns)
+{
+    for (size_t i = 0; (gnc->latest == NULL) && (i < numGncSensorIf); i++)
+    {
+        while (gncActuate(gnc, (sensorIn_e) i, NULL) >= 0)
         {
-            /* Error Handling. */
-            perror("Poll Error. \n");
+            gnc->rxSinceStep++;
         }
-        printf("Timeout: %d \n", timeOutCtr);
+    }
+    while (gnc->nextStep_ns < tickEnd_ns)
+    {
+        gncStep(gnc);
+        gnc->nextStep_ns += gncPeriod_ns;
+    }
+}
+
+/* 
+ * Lockstep loop. Every tick takes the inputs in a fixed sensor order, then runs the GNC steps due in the
+ * tick, so a run gives the same commands every time.
+ */
+static void gncRunLockstep(gncStage_t* gnc)
+{
+    gnc->loop.running = 1;
+    while ((gnc->loop.running == 1) && (awaitLockstep(&gnc->stepMember) == 0))
+    {
+        stepGncStage(gnc, gnc->stepMember.tickEnd_ns);
+        /* Signals only. */
+        stepEventLoop(&gnc->loop, 0);
+    }
+    if (gnc->loop.running == 0)
+    {
+        leaveLockstep(&gnc->stepMember);
+    }
+}
+
+int gncRun(gncStage_t* gnc)
+{
+    int pending = 0;
+
+    if (gnc->cfg.lockstep == 1)
+    {
+        gncRunLockstep(gnc);
+        return 0;
+    }
+    /* While inputs hold data the loop only polls, so the step timer and the other inputs still get their turn. */
+    gnc->loop.running = 1;
+    while (gnc->loop.running == 1)
+    {
+        if (stepEventLoop(&gnc->loop, pending ? 0 : -1) == -1)
+        {
+            perror("Epoll Wait Failed.");
+            return -1;
+        }
+        pending = gncDrainInputs(gnc);
     }
     return 0;
 }
+
+void gncStop(gncStage_t* gnc)
+{
+    stopEventLoop(&gnc->loop);
+}
+
+void printGncStats(gncStage_t* gnc)
+{
+    printLatencyTable("GNC", &gnc->latency);
+}
+
+int gncTerminate(gncStage_t* gnc)
+{
+    const navFilter_t* nav = &gnc->nav;
+
+    printGncStats(gnc);
+    for (size_t i = 0; (gnc->latest != NULL) && (i < numGncSensorIf); i++)
+    {
+        printf("%s: %u samples published, %u skipped between steps \n", sensorNames[i], gnc->inputs[i].lastGen,
+               gnc->inputs[i].numSkipped);
+    }
+    closeLatestTable(gnc->latest, latestTableName);
+    printf("Actuator commands: %u sent, %lu dropped \n", gnc->actSeq, (unsigned long) gnc->actDropped);
+    printf("Thruster allocation p50 %lu ns max %lu ns \n",
+           (unsigned long) getTimeHistPercentile(&gnc->allocCycle, 0.5),
+           (unsigned long) getTimeHistPercentile(&gnc->allocCycle, 1.0));
+    if (nav->valid == 1)
+    {
+        printf("Navigation: %lu IMU steps to %.3f s, %lu rejected, %lu updates, %lu gated, %lu too late, GNSS "
+               "innovation last %.2f m max %.2f m \n", (unsigned long) nav->nav.numSteps,
+               (double) nav->nav.time_ns * 1e-9, (unsigned long) nav->numRejected,
+               (unsigned long) nav->kf.numUpdates, (unsigned long) nav->kf.numRejected,
+               (unsigned long) nav->numLate, nav->errLast_m, nav->errMax_m);
+        printf("Navigation: %lu rewinds replayed %lu IMU steps, rewind p50 %lu ns max %lu ns, %lu measurements "
+               "evicted, %lu lost to a full queue \n", (unsigned long) nav->numRewinds,
+               (unsigned long) nav->numReplayed, (unsigned long) getTimeHistPercentile(&gnc->navRewind, 0.5),
+               (unsigned long) getTimeHistPercentile(&gnc->navRewind, 1.0), (unsigned long) nav->meas.numEvicted,
+               (unsigned long) nav->meas.numRefused);
+        printf("Navigation: IMU step p50 %lu ns p99.9 %lu ns max %lu ns, update p50 %lu ns max %lu ns \n",
+               (unsigned long) getTimeHistPercentile(&gnc->navCycle, 0.5),
+               (unsigned long) getTimeHistPercentile(&gnc->navCycle, 0.999),
+               (unsigned long) getTimeHistPercentile(&gnc->navCycle, 1.0),
+               (unsigned long) getTimeHistPercentile(&gnc->navUpdate, 0.5),
+               (unsigned long) getTimeHistPercentile(&gnc->navUpdate, 1.0));
+    }
+    closeGncStage(gnc);
+    return 0;
+}
+
+void closeGncStage(gncStage_t* gnc)
+{
+    closeEventLoop(&gnc->loop);
+    for (size_t i = 0; (gnc->latest == NULL) && (i < numGncSensorIf); i++)
+    {
+        closeIPC(&gnc->inputs[i].cfg);
+    }
+    closeIPC(&gnc->actOut);
+    closeArena(&gnc->arena);
+}
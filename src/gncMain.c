@@ -0,0 +1,89 @@
+// GncMain: the GNC stage as a process of its own.
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include "gnc.h"
+#include "captureLib.h"
+
+/* Large, and only one per process. */
+gncStage_t gnc;
+
+/* SIGUSR1 prints the latency, SIGINT and SIGTERM stop the loop. */
+int gncSigFd = -1;
+
+static void gncSignalEvent(void* ctx)
+{
+    struct signalfd_siginfo info;
+    (void) ctx;
+
+    while (read(gncSigFd, &info, sizeof(info)) == (ssize_t) sizeof(info))
+    {
+        if (info.ssi_signo == SIGUSR1)
+        {
+            printGncStats(&gnc);
+        }
+        else
+        {
+            gncStop(&gnc);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    gncCfg_t cfg;
+    int      opt;
+
+    initGncCfg(&cfg);
+    while ((opt = getopt(argc, argv, "ls")) != -1)
+    {
+        switch (opt)
+        {
+            case 'l':
+                cfg.useLatest = 1;
+                break;
+
+            case 's':
+                cfg.lockstep = 1;
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-l] [-s] \n", argv[0]);
+                return -1;
+        }
+    }
+
+    if ((openTelem("GncMain") == -1) || (openCapture("GncMain") == -1) || (gncInit(&gnc, &cfg) == -1))
+    {
+        return -1;
+    }
+
+    sigset_t sigSet;
+    sigemptyset(&sigSet);
+    sigaddset(&sigSet, SIGUSR1);
+    sigaddset(&sigSet, SIGINT);
+    sigaddset(&sigSet, SIGTERM);
+    sigprocmask(SIG_BLOCK, &sigSet, NULL);
+    gncSigFd = signalfd(-1, &sigSet, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (gncSigFd == -1)
+    {
+        perror("Signal FD Failed.");
+    }
+    else
+    {
+        addEventFd(&gnc.loop, gncSigFd, gncSignalEvent, NULL);
+    }
+
+    gncRun(&gnc);
+    if (gncSigFd >= 0)
+    {
+        close(gncSigFd);
+    }
+    closeTelem();
+    closeCapture();
+    printTelemStats();
+    printCaptureStats();
+    return gncTerminate(&gnc);
+}
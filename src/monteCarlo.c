@@ -0,0 +1,616 @@
+// & ()
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "monteCarlo.h"
+#include "arenaLib.h"
+
+mcCampaign_t campaign;
+
+/* Set by the campaign thread once the pool returned. */
+atomic_int   campaignDone = 0;
+
+const char* const mcMetricNames[numMcMetrics] = {"navErrMax_m", "navErrLast_m", "navGated", "navRewinds",
+                                                 "impulse_Ns", "falseIsolations", "missedSamples", "runTime_ms"};
+
+/* Value and packet faults a run may get. The others reach FDIR as missing samples, like a dropout. */
+const faultKind_e mcFaultKinds[] = {faultBias, faultDrift, faultNoise, faultStuck, faultDropout};
+#define mcNumFaultKinds (sizeof(mcFaultKinds) / sizeof(mcFaultKinds[0]))
+
+/* splitmix64. Also the finaliser that turns campaign seed and run index into a run seed. */
+static inline uint64_t mcMix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t mcNext(uint64_t* rng)
+{
+    *rng += 0x9E3779B97F4A7C15ULL;
+    return mcMix(*rng);
+}
+
+/* Uniform in [0, 1). */
+static inline double mcUniform(uint64_t* rng)
+{
+    return (double) (mcNext(rng) >> 11) * 0x1.0p-53;
+}
+
+static unsigned int mcPick(uint64_t* rng, unsigned int lo, unsigned int hi)
+{
+    return lo + (unsigned int) (mcUniform(rng) * (double) (hi - lo + 1U));
+}
+
+void mcDisperse(const mcCampaign_t* mc, uint64_t index, mcDispersion_t* disp)
+{
+    uint64_t rng;
+
+    disp->seed = mcMix(mc->seed ^ mcMix(index + 1U));
+    rng        = disp->seed;
+    for (unsigned int s = 0; s < numGncSensorIf; s++)
+    {
+        disp->numUnits[s] = mcPick(&rng, mc->minUnits, mc->maxUnits);
+    }
+
+    memset(&disp->fault, 0, sizeof(disp->fault));
+    disp->haveFault = (mcUniform(&rng) < mc->faultProb);
+    if (disp->haveFault == 0)
+    {
+        return;
+    }
+    /* Voted sensors only, the star tracker has nothing to compare a unit against. */
+    disp->faultSensor      = (mcUniform(&rng) < 0.5) ? IMU : GNSS;
+    disp->fault.kind       = mcFaultKinds[mcPick(&rng, 0, mcNumFaultKinds - 1U)];
+    disp->fault.unit       = mcPick(&rng, 0, disp->numUnits[disp->faultSensor] - 1U);
+    disp->fault.channel    = (int) mcPick(&rng, 0, fdirVoteChannels - 1U);
+    disp->fault.start_ns   = (uint64_t) ((mcOnsetMin + (mcOnsetMax - mcOnsetMin) * mcUniform(&rng)) *
+                                         (double) mc->end_ns);
+    disp->fault.end_ns     = UINT64_MAX;
+
+    /* Sized against the residual detector noise of the channel. */
+    const residualCfg_t* cfg   = (disp->faultSensor == IMU) ? &imuResidualCfg : &gnssResidualCfg;
+    double               sigma = cfg->sigma[disp->fault.channel];
+
+    switch (disp->fault.kind)
+    {
+        case faultBias:
+        case faultNoise:
+            disp->fault.magnitude = (2.0 + 8.0 * mcUniform(&rng)) * sigma;
+            break;
+
+        case faultDrift:
+            /* Per second. */
+            disp->fault.magnitude = (0.2 + 1.8 * mcUniform(&rng)) * sigma;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Rig, faults and stages of a run, consumers first. */
+static int mcStart(mcCampaign_t* mc, mcWorker_t* w, const mcDispersion_t* disp)
+{
+    sensCfg_t sensCfg;
+    fdirCfg_t fdirCfg;
+    gncCfg_t  gncCfg;
+
+    initFaultScript(&w->script, sensorSections, numGncSensorIf);
+    if (disp->haveFault == 1)
+    {
+        addFault(&w->script, disp->faultSensor, &disp->fault);
+    }
+    for (unsigned int i = 0; i < numGncSensorIf; i++)
+    {
+        w->rig.sensor[i].numUnits = disp->numUnits[i];
+    }
+    w->now_ns     = 0;
+    w->end_ns     = mc->end_ns;
+    w->force_N    = 0.0;
+    w->control_ns = 0;
+    w->impulse_Ns = 0.0;
+
+    initGncCfg(&gncCfg);
+    gncCfg.stepped      = 1;
+    gncCfg.transport    = IPC_DIRECT;
+    gncCfg.actTransport = IPC_DIRECT;
+    gncCfg.rig          = &w->rig;
+    gncCfg.thr          = &mc->thr;
+    if (gncInit(&w->gnc, &gncCfg) == -1)
+    {
+        return -1;
+    }
+
+    initFdirCfg(&fdirCfg);
+    fdirCfg.stepped   = 1;
+    fdirCfg.transport = IPC_DIRECT;
+    fdirCfg.rig       = &w->rig;
+    if (initFdirStage(&w->fdir, &fdirCfg) == -1)
+    {
+        return -1;
+    }
+
+    initSensCfg(&sensCfg);
+    sensCfg.replayScale = 0.0;
+    sensCfg.fdir        = 1;
+    sensCfg.transport   = IPC_DIRECT;
+    sensCfg.rig         = &w->rig;
+    sensCfg.script      = &w->script;
+    sensCfg.seed        = disp->seed;
+    for (unsigned int i = 0; i < numGncSensorIf; i++)
+    {
+        sensCfg.noise[i] = mc->noise[i];
+    }
+    return initSensStage(&w->sens, &sensCfg);
+}
+
+/*
+ * Everything the sensors sent up to now: FDIR votes it, GNC acts on it and its commands are integrated. The
+ * previous command's thrust counts up to now.
+ */
+static void mcDeliver(mcWorker_t* w)
+{
+    const actCmd_t*   cmd = &w->cmd.data;
+    const thrAlloc_t* thr = &w->gnc.thr;
+
+    stepFdirStage(&w->fdir);
+    stepGncStage(&w->gnc, w->now_ns);
+    while (recvMsgIPC(&w->actIn, w->cmd.dataBuf, sizeof(w->cmd.dataBuf)) >= 0)
+    {
+        w->impulse_Ns += w->force_N * (double) (w->now_ns - w->control_ns) * 1e-9;
+        w->force_N     = 0.0;
+        for (unsigned int i = 0; (i < cmd->numActuators) && (i < thr->numThr); i++)
+        {
+            w->force_N += cmd->duty[i] * thr->thr[i].maxForce_N;
+        }
+        w->control_ns = w->now_ns;
+    }
+}
+
+/* Scheduler gate of the sensors stage. Before time moves on, what was sent until now is delivered. */
+static int mcGate(void* ctx, uint64_t release_ns)
+{
+    mcWorker_t* w = (mcWorker_t *) ctx;
+
+    if (release_ns >= w->end_ns)
+    {
+        return -1;
+    }
+    if (release_ns > w->now_ns)
+    {
+        mcDeliver(w);
+        w->now_ns = release_ns;
+    }
+    return 0;
+}
+
+/* Close the stages of a run, whose channels stay in the process for the next. */
+static void mcClose(mcWorker_t* w)
+{
+    closeSensStage(&w->sens);
+    closeFdirStage(&w->fdir);
+    closeGncStage(&w->gnc);
+}
+
+static void addMcStat(mcStat_t* st, double x)
+{
+    double d = x - st->mean;
+
+    if ((st->n == 0) || (x < st->min))
+    {
+        st->min = x;
+    }
+    if ((st->n == 0) || (x > st->max))
+    {
+        st->max = x;
+    }
+    st->n++;
+    st->mean += d / (double) st->n;
+    st->m2   += d * (x - st->mean);
+}
+
+/* Fold b into a, Chan et al. */
+static void mergeMcStat(mcStat_t* a, const mcStat_t* b)
+{
+    uint64_t n = a->n + b->n;
+    double   d = b->mean - a->mean;
+
+    if (b->n == 0)
+    {
+        return;
+    }
+    if (a->n == 0)
+    {
+        *a = *b;
+        return;
+    }
+    a->mean += d * (double) b->n / (double) n;
+    a->m2   += b->m2 + d * d * (double) a->n * (double) b->n / (double) n;
+    a->min   = (b->min < a->min) ? b->min : a->min;
+    a->max   = (b->max > a->max) ? b->max : a->max;
+    a->n     = n;
+}
+
+/* Score the run into the worker's summary and the result file. */
+static void mcFinish(mcCampaign_t* mc, mcWorker_t* w, const mcDispersion_t* disp, uint64_t index, uint64_t wall_ns)
+{
+    mcSummary_t* sum       = &w->sum;
+    unsigned int numFalse  = 0;
+    uint64_t     missed    = 0;
+    uint64_t     isolated  = UINT64_MAX;
+    double       value[numMcMetrics];
+
+    for (unsigned int i = 0; i < numGncSensorIf; i++)
+    {
+        const taskArg_t* s = w->fdir.arg[i];
+
+        for (unsigned int u = 0; u < s->numSensors; u++)
+        {
+            const fdirUnit_t* unit = &s->unit[u];
+
+            missed += atomic_load_explicit(&unit->numMissed, memory_order_relaxed);
+            if (atomic_load_explicit(&unit->faults, memory_order_relaxed) == 0)
+            {
+                continue;
+            }
+            if ((disp->haveFault == 1) && (disp->faultSensor == (sensorIn_e) i) && (disp->fault.unit == u) &&
+                (unit->isolated_ns >= disp->fault.start_ns))
+            {
+                isolated = unit->isolated_ns;
+            }
+            else
+            {
+                numFalse++;
+            }
+        }
+    }
+    if (disp->haveFault == 1)
+    {
+        sum->numInjected[disp->fault.kind]++;
+        if (isolated != UINT64_MAX)
+        {
+            sum->numDetected[disp->fault.kind]++;
+            addMcStat(&sum->detectLat[disp->fault.kind], (double) (isolated - disp->fault.start_ns) * 1e-9);
+        }
+    }
+
+    value[mcNavErrMax]  = w->gnc.nav.errMax_m;
+    value[mcNavErrLast] = w->gnc.nav.errLast_m;
+    value[mcNavGated]   = (double) w->gnc.nav.kf.numRejected;
+    value[mcNavRewinds] = (double) w->gnc.nav.numRewinds;
+    value[mcImpulse]    = w->impulse_Ns;
+    value[mcFalseIso]   = (double) numFalse;
+    value[mcMissed]     = (double) missed;
+    value[mcRunTime]    = (double) wall_ns * 1e-6;
+    for (unsigned int m = 0; m < numMcMetrics; m++)
+    {
+        addMcStat(&sum->metric[m], value[m]);
+    }
+    sum->numRuns++;
+    sum->numFalseRuns += (numFalse > 0);
+
+    if (mc->csv != NULL)
+    {
+        /* One call per line, stdio keeps the lines of concurrent workers whole. */
+        fprintf(mc->csv, "%lu,%016lx,%u,%u,%u,%s,%s,%d,%.3f,%.3f,%.3f,%.3f,%.0f,%.0f,%.3f,%u,%lu,%.3f\n",
+                (unsigned long) index, (unsigned long) disp->seed, disp->numUnits[IMU], disp->numUnits[GNSS],
+                disp->numUnits[STK], (disp->haveFault == 1) ? sensorNames[disp->faultSensor] : "-",
+                (disp->haveFault == 1) ? faultKindName(disp->fault.kind) : "-",
+                (disp->haveFault == 1) ? (int) disp->fault.unit : -1,
+                (disp->haveFault == 1) ? (double) disp->fault.start_ns * 1e-9 : -1.0,
+                (isolated != UINT64_MAX) ? (double) isolated * 1e-9 : -1.0, value[mcNavErrMax], value[mcNavErrLast],
+                value[mcNavGated], value[mcNavRewinds], value[mcImpulse], numFalse, (unsigned long) missed,
+                value[mcRunTime]);
+    }
+    atomic_fetch_add_explicit(&mc->numDone, 1, memory_order_relaxed);
+}
+
+void mcRun(void* ctx, unsigned int worker, uint64_t index)
+{
+    mcCampaign_t*  mc = (mcCampaign_t *) ctx;
+    mcWorker_t*    w  = &mc->worker[worker];
+    uint64_t       t0 = getTimeNs();
+    mcDispersion_t disp;
+
+    mcDisperse(mc, index, &disp);
+    if (mcStart(mc, w, &disp) == -1)
+    {
+        fprintf(stderr, "Run %lu could not start, stopping the campaign \n", (unsigned long) index);
+        stopPool(&mc->pool);
+        return;
+    }
+    runSensStage(&w->sens, mcGate, w);
+    /* The last releases before the end. */
+    mcDeliver(w);
+    mcFinish(mc, w, &disp, index, getTimeNs() - t0);
+    mcClose(w);
+}
+
+void printMcSummary(mcCampaign_t* mc)
+{
+    mcSummary_t sum;
+    uint64_t    numFaulted = 0;
+    double      wall_s     = (double) (getTimeNs() - mc->start_ns) * 1e-9;
+
+    /* Worker summaries are only read once the pool is done. */
+    memset(&sum, 0, sizeof(sum));
+    for (unsigned int i = 0; i < mc->pool.numWorkers; i++)
+    {
+        const mcSummary_t* ws = &mc->worker[i].sum;
+
+        sum.numRuns      += ws->numRuns;
+        sum.numFalseRuns += ws->numFalseRuns;
+        for (unsigned int m = 0; m < numMcMetrics; m++)
+        {
+            mergeMcStat(&sum.metric[m], &ws->metric[m]);
+        }
+        for (unsigned int k = 0; k < numFaultKinds; k++)
+        {
+            sum.numInjected[k] += ws->numInjected[k];
+            sum.numDetected[k] += ws->numDetected[k];
+            mergeMcStat(&sum.detectLat[k], &ws->detectLat[k]);
+        }
+    }
+
+    printf("Campaign: %lu of %lu runs in %.3f s on %u workers, %.1f runs/s, seed %lu \n",
+           (unsigned long) sum.numRuns, (unsigned long) mc->numRuns, wall_s, mc->pool.numWorkers,
+           (wall_s > 0.0) ? ((double) sum.numRuns / wall_s) : 0.0, (unsigned long) mc->seed);
+    printf("  %-16s %12s %12s %12s %12s \n", "", "mean", "std", "min", "max");
+    for (unsigned int m = 0; m < numMcMetrics; m++)
+    {
+        const mcStat_t* st = &sum.metric[m];
+
+        printf("  %-16s %12.3f %12.3f %12.3f %12.3f \n", mcMetricNames[m], st->mean,
+               (st->n > 1) ? sqrt(st->m2 / (double) (st->n - 1)) : 0.0, st->min, st->max);
+    }
+    for (unsigned int k = 0; k < numFaultKinds; k++)
+    {
+        numFaulted += sum.numInjected[k];
+    }
+    printf("Faults: %lu runs with an injected fault, %lu runs with a false isolation \n", (unsigned long) numFaulted,
+           (unsigned long) sum.numFalseRuns);
+    for (unsigned int k = 0; k < numFaultKinds; k++)
+    {
+        const mcStat_t* lat = &sum.detectLat[k];
+
+        if (sum.numInjected[k] == 0)
+        {
+            continue;
+        }
+        printf("  %-8s %6lu injected, %6lu isolated (%5.1f %%)", faultKindName((faultKind_e) k),
+               (unsigned long) sum.numInjected[k], (unsigned long) sum.numDetected[k],
+               100.0 * (double) sum.numDetected[k] / (double) sum.numInjected[k]);
+        if (lat->n > 0)
+        {
+            printf(", latency mean %.3f s max %.3f s", lat->mean, lat->max);
+        }
+        printf(" \n");
+    }
+    printPoolStats(&mc->pool);
+}
+
+/* Fixed per worker state: the campaign rig on ports of the worker, and the actuator channel. */
+static int initMcWorker(mcCampaign_t* mc, mcWorker_t* w, unsigned int index)
+{
+    uint16_t base = (uint16_t) (mcPortBase + index * mcPortsPerWorker);
+
+    w->rig = mc->rig;
+    for (unsigned int i = 0; i < numGncSensorIf; i++)
+    {
+        w->rig.sensor[i].fdirPort = (uint16_t) (base + i * mcMaxUnits);
+        w->rig.sensor[i].gncPort  = (uint16_t) (base + numGncSensorIf * mcMaxUnits + i);
+    }
+    w->rig.actPort = (uint16_t) (base + numGncSensorIf * (mcMaxUnits + 1U));
+
+    setIpcAddrPortTransport(&w->actIn, w->rig.ipcAddr, w->rig.actPort, INPUT, IPC_DIRECT);
+    if (w->actIn.ipcSock == -1)
+    {
+        return -1;
+    }
+    setIpcNonBlocking(&w->actIn);
+    return 0;
+}
+
+/* Runs the pool off the main thread, which stays free for signals. */
+void* campaignThread(void* argP)
+{
+    mcCampaign_t* mc = (mcCampaign_t *) argP;
+
+    runPool(&mc->pool, mc->numRuns, mcRun, mc);
+    atomic_store(&campaignDone, 1);
+    kill(getpid(), SIGUSR2);
+    return NULL;
+}
+
+static void mcUsage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [-n runs] [-j numWorkers] [-r seed] [-p faultProb] [-u minUnits:maxUnits] "
+                    "[-e end_s] [-o results.csv] \n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    /* Residual detector noise of the voted sensors. The star tracker has no detector. */
+    const double*  sigma[numGncSensorIf] = {imuResidualCfg.sigma, gnssResidualCfg.sigma, NULL};
+    mcCampaign_t*  mc         = &campaign;
+    long           numCpu     = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int   numWorkers = (numCpu > 0) ? (unsigned int) numCpu : 1U;
+    double         end_s      = 0.0;
+    const char*    csvPath    = NULL;
+    interfaceCfg_t imuIf;
+    npyMap_t       imuData;
+    arena_t        arena;
+    int            opt;
+
+    mc->numRuns   = mcDefaultRuns;
+    mc->seed      = 1;
+    mc->faultProb = 0.5;
+    mc->minUnits  = defaultUnitsPerSensor;
+    mc->maxUnits  = defaultUnitsPerSensor + 2U;
+    while ((opt = getopt(argc, argv, "n:j:r:p:u:e:o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                mc->numRuns = strtoull(optarg, NULL, 0);
+                break;
+
+            case 'j':
+                numWorkers = (unsigned int) atoi(optarg);
+                break;
+
+            case 'r':
+                mc->seed = strtoull(optarg, NULL, 0);
+                break;
+
+            case 'p':
+                /* Share of runs with an injected fault. */
+                mc->faultProb = atof(optarg);
+                break;
+
+            case 'u':
+                /* Units per sensor type, drawn per run and type. */
+                if (sscanf(optarg, "%u:%u", &mc->minUnits, &mc->maxUnits) != 2)
+                {
+                    mc->minUnits = 0;
+                }
+                break;
+
+            case 'e':
+                /* Scenario end, 0 replays all rows. */
+                end_s = atof(optarg);
+                break;
+
+            case 'o':
+                csvPath = optarg;
+                break;
+
+            default:
+                mcUsage(argv[0]);
+                return -1;
+        }
+    }
+    if ((mc->numRuns == 0) || (mc->numRuns > poolMaxTasks) || (numWorkers == 0) || (mc->minUnits == 0) ||
+        (mc->minUnits > mc->maxUnits) || (mc->maxUnits > mcMaxUnits) || (mc->faultProb < 0.0) || (end_s < 0.0) ||
+        (mcPortBase + (uint64_t) numWorkers * mcPortsPerWorker > UINT16_MAX))
+    {
+        mcUsage(argv[0]);
+        return -1;
+    }
+
+    if (initRigConfig(&mc->rig) == -1)
+    {
+        return -1;
+    }
+    /* Runs end with the IMU rows, or earlier. Every run maps the data again, as the sensor stage does. */
+    setInterface(&imuIf, INPUT, mc->rig.sensor[IMU].file);
+    if (npyMapData(&imuIf, &imuData) == -1)
+    {
+        fprintf(stderr, "Could not map sensor data %s \n", mc->rig.sensor[IMU].file);
+        return -1;
+    }
+    mc->end_ns = (uint64_t) ((double) imuData.hdr.numRows / mc->rig.sensor[IMU].rate_Hz * 1e9);
+    npyUnmapData(&imuData);
+    if ((end_s > 0.0) && ((uint64_t) (end_s * 1e9) < mc->end_ns))
+    {
+        mc->end_ns = (uint64_t) (end_s * 1e9);
+    }
+    if (initThrusterConfig(&mc->thr) == -1)
+    {
+        return -1;
+    }
+    for (unsigned int i = 0; i < numGncSensorIf; i++)
+    {
+        for (unsigned int c = 0; c < mcMaxChannels; c++)
+        {
+            mc->noise[i][c] = (sigma[i] != NULL) ? (mcNoiseFrac * sigma[i][c]) : mcStrNoise;
+        }
+    }
+
+    /* More than one worker are pinned, one per CPU, unless there are more workers than CPUs. */
+    if (initPool(&mc->pool, numWorkers, (numWorkers > 1) && ((long) numWorkers <= numCpu)) == -1)
+    {
+        return -1;
+    }
+    if (initArena(&arena, arenaSizeOf(numWorkers * sizeof(mcWorker_t))) == -1)
+    {
+        return -1;
+    }
+    mc->worker = arenaAlloc(&arena, numWorkers * sizeof(mcWorker_t));
+    for (unsigned int i = 0; i < numWorkers; i++)
+    {
+        if (initMcWorker(mc, &mc->worker[i], i) == -1)
+        {
+            return -1;
+        }
+    }
+
+    if (csvPath != NULL)
+    {
+        mc->csv = fopen(csvPath, "w");
+        if (mc->csv == NULL)
+        {
+            perror("Result File Open Failed.");
+            return -1;
+        }
+        fprintf(mc->csv, "run,seed,imuUnits,gnssUnits,strUnits,faultSensor,faultKind,faultUnit,onset_s,isolated_s,"
+                        "navErrMax_m,navErrLast_m,navGated,navRewinds,impulse_Ns,falseIsolations,missedSamples,"
+                        "runTime_ms\n");
+    }
+
+    /*
+     * Workers leave signals to the main thread. SIGUSR1 prints the progress, SIGUSR2 marks the end of the
+     * campaign and SIGINT or SIGTERM stop it early, still printing the summary of the runs done.
+     */
+    sigset_t  sigSet;
+    pthread_t campaign;
+
+    sigemptyset(&sigSet);
+    sigaddset(&sigSet, SIGUSR1);
+    sigaddset(&sigSet, SIGUSR2);
+    sigaddset(&sigSet, SIGINT);
+    sigaddset(&sigSet, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+
+    printf("Monte Carlo: %lu runs of %.1f s, %u to %u units per sensor, fault in %.0f %% of runs, %u workers \n",
+           (unsigned long) mc->numRuns, (double) mc->end_ns * 1e-9, mc->minUnits, mc->maxUnits, 100.0 * mc->faultProb,
+           numWorkers);
+    mc->start_ns = getTimeNs();
+    pthread_create(&campaign, NULL, campaignThread, (void *) mc);
+    while (atomic_load(&campaignDone) == 0)
+    {
+        struct timespec pollPeriod = {1, 0};
+        int             sig        = sigtimedwait(&sigSet, NULL, &pollPeriod);
+
+        if (sig == SIGUSR1)
+        {
+            printf("%lu of %lu runs after %.3f s \n",
+                   (unsigned long) atomic_load_explicit(&mc->numDone, memory_order_relaxed),
+                   (unsigned long) mc->numRuns, (double) (getTimeNs() - mc->start_ns) * 1e-9);
+        }
+        else if ((sig == SIGINT) || (sig == SIGTERM))
+        {
+            stopPool(&mc->pool);
+        }
+    }
+    pthread_join(campaign, NULL);
+    printMcSummary(mc);
+
+    if (mc->csv != NULL)
+    {
+        fclose(mc->csv);
+    }
+    for (unsigned int i = 0; i < numWorkers; i++)
+    {
+        closeIPC(&mc->worker[i].actIn);
+    }
+    closePool(&mc->pool);
+    closeArena(&arena);
+    return 0;
+}
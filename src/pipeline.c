@@ -0,0 +1,164 @@
+// Pipeline: sensors, FDIR and GNC as threads of one process. Same stages as SensorsOut, FdirHandler and GncMain,
+// linked together and by default connected through in-process rings instead of sockets.
+
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sensors.h"
+#include "sensorFdir.h"
+#include "gnc.h"
+#include "captureLib.h"
+
+/* Time FDIR and GNC get to take what is still queued once the replay ended. */
+#define pipeDrain_ms 500
+
+/* Stages are large, and only one pipeline runs per process. */
+sensStage_t pipeSens;
+fdirStage_t pipeFdir;
+gncStage_t  pipeGnc;
+
+static void* pipeGncThread(void* argP)
+{
+    gncRun((gncStage_t *) argP);
+    return NULL;
+}
+
+static void printPipeStats(void)
+{
+    printSensStats(&pipeSens);
+    printFdirStage(&pipeFdir);
+    printGncStats(&pipeGnc);
+}
+
+static void pipeUsage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [-x speedFactor] [-j numWorkers] [-f faultScript] [-d frameDeadline_us] [-l] "
+            "[-t udp|shm|inproc] \n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    sensCfg_t         sensCfg;
+    fdirCfg_t         fdirCfg;
+    gncCfg_t          gncCfg;
+    enum ipcTransport transport = IPC_INPROC;
+    pthread_t         gncThread;
+    int               opt;
+
+    initSensCfg(&sensCfg);
+    initFdirCfg(&fdirCfg);
+    initGncCfg(&gncCfg);
+    while ((opt = getopt(argc, argv, "x:j:f:d:lt:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'x':
+                sensCfg.replayScale = atof(optarg);
+                break;
+
+            case 'j':
+                sensCfg.numWorkers = (unsigned int) atoi(optarg);
+                break;
+
+            case 'f':
+                sensCfg.faultPath = optarg;
+                break;
+
+            case 'd':
+                fdirCfg.deadline_us = atof(optarg);
+                break;
+
+            case 'l':
+                /* GNC reads the latest table, FDIR streams nothing. */
+                fdirCfg.streamOut = 0;
+                gncCfg.useLatest  = 1;
+                break;
+
+            case 't':
+                transport = parseIpcTransport(optarg);
+                break;
+
+            default:
+                pipeUsage(argv[0]);
+                return -1;
+        }
+    }
+    if ((sensCfg.replayScale < 0.0) || (sensCfg.numWorkers == 0) || (fdirCfg.deadline_us < 0.0) ||
+        (transport == IPC_DEFAULT))
+    {
+        pipeUsage(argv[0]);
+        return -1;
+    }
+    /* Always the full chain. Actuator commands keep TEC_IPC_TRANSPORT, an ActuatorSink may listen. */
+    sensCfg.fdir      = 1;
+    sensCfg.transport = transport;
+    fdirCfg.transport = transport;
+    gncCfg.transport  = transport;
+    if ((sensCfg.replayScale == 0.0) || (sensCfg.replayScale > 1.0))
+    {
+        /* Ahead of real time the slowest stage sets the pace, every channel waits for space rather than drop. */
+        fdirCfg.backpressure = 1;
+        gncCfg.backpressure  = 1;
+    }
+
+    /*
+     * Stage threads inherit the mask and leave signals to this thread. SIGUSR1 prints statistics, SIGUSR2
+     * marks the end of the replay and SIGINT or SIGTERM stop it early, still printing the reports.
+     */
+    sigset_t sigSet;
+
+    sigemptyset(&sigSet);
+    sigaddset(&sigSet, SIGUSR1);
+    sigaddset(&sigSet, SIGUSR2);
+    sigaddset(&sigSet, SIGINT);
+    sigaddset(&sigSet, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+
+    /* Consumers first, so sockets are bound before anything is sent to them. */
+    if ((openTelem("Pipeline") == -1) || (openCapture("Pipeline") == -1) || (gncInit(&pipeGnc, &gncCfg) == -1) ||
+        (initFdirStage(&pipeFdir, &fdirCfg) == -1) || (initSensStage(&pipeSens, &sensCfg) == -1))
+    {
+        return -1;
+    }
+    if ((pthread_create(&gncThread, NULL, pipeGncThread, &pipeGnc) != 0) || (startFdirStage(&pipeFdir) == -1) ||
+        (startSensStage(&pipeSens) == -1))
+    {
+        fprintf(stderr, "Could not start the pipeline \n");
+        return -1;
+    }
+
+    while (sensStageDone(&pipeSens) == 0)
+    {
+        struct timespec pollPeriod = {1, 0};
+        int             sig        = sigtimedwait(&sigSet, NULL, &pollPeriod);
+
+        if (sig == SIGUSR1)
+        {
+            printPipeStats();
+        }
+        else if ((sig == SIGINT) || (sig == SIGTERM))
+        {
+            stopSensStage(&pipeSens);
+        }
+    }
+    joinSensStage(&pipeSens);
+
+    struct timespec drain = {pipeDrain_ms / 1000, (pipeDrain_ms % 1000) * 1000000L};
+    nanosleep(&drain, NULL);
+    gncStop(&pipeGnc);
+    pthread_join(gncThread, NULL);
+    closeTelem();
+    closeCapture();
+
+    printSensReport(&pipeSens);
+    printFdirStage(&pipeFdir);
+    releaseFdirStage(&pipeFdir);
+    gncTerminate(&pipeGnc);
+    printTelemStats();
+    printCaptureStats();
+    closeSensStage(&pipeSens);
+    /* The FDIR threads block on their inputs, so exit without joining. */
+    return 0;
+}
@@ -0,0 +1,257 @@
+// Replay: sends the messages of a capture again, to an FdirHandler or GncMain running on its own.
+
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "captureLib.h"
+#include "interfaceLib.h"
+#include "msgHeader.h"
+#include "threadLib.h"
+
+/* Channels one replay sends on. */
+#define replayMaxChans 64U
+
+typedef enum
+{
+    replayAll  = 0,
+    replayFdir = 1,                                 //< FDIR unit inputs, what SensorsOut sends.
+    replayGnc  = 2                                  //< GNC inputs, what FdirHandler forwards.
+} replayTarget_e;
+
+typedef struct
+{
+    uint16_t    port;
+    uint64_t    numSent;
+    uint64_t    numDropped;
+    ipcConfig_t cfg;
+} replayChan_t;
+
+replayChan_t replayChans[replayMaxChans];
+unsigned int replayNumChans = 0;
+
+volatile sig_atomic_t replayStop = 0;
+
+static void replayStopHandler(int sig)
+{
+    (void) sig;
+    replayStop = 1;
+}
+
+/* Whether a port is an input of the target, as the rig places them. */
+static int replayPortMatch(const rigConfig_t* rig, replayTarget_e target, uint16_t port)
+{
+    if (target == replayAll)
+    {
+        return 1;
+    }
+    for (unsigned int i = 0; i < numGncSensorIf; i++)
+    {
+        const rigSensor_t* rs = &rig->sensor[i];
+
+        if (((target == replayGnc) && (port == rs->gncPort)) ||
+            ((target == replayFdir) && (port >= rs->fdirPort) && (port < rs->fdirPort + rs->numUnits)))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Output channel to port, opened on first use. NULL once replayMaxChans are open. */
+static replayChan_t* replayChan(const rigConfig_t* rig, uint16_t port, enum ipcTransport transport, int maxSpeed)
+{
+    for (unsigned int i = 0; i < replayNumChans; i++)
+    {
+        if (replayChans[i].port == port)
+        {
+            return &replayChans[i];
+        }
+    }
+    if (replayNumChans == replayMaxChans)
+    {
+        return NULL;
+    }
+
+    replayChan_t* ch = &replayChans[replayNumChans];
+
+    memset(ch, 0, sizeof(*ch));
+    ch->port = port;
+    setIpcAddrPortTransport(&ch->cfg, (char *) rig->ipcAddr, port, OUTPUT, transport);
+    if (ch->cfg.ipcSock == -1)
+    {
+        return NULL;
+    }
+    /* Unpaced, a shared memory channel waits for the target rather than drop. */
+    if (maxSpeed == 1)
+    {
+        ch->cfg.blockOnFull = 1;
+    }
+    replayNumChans++;
+    return ch;
+}
+
+static void replayUsage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [-x speedFactor] [-f | -g] [-s] [-e] [-t udp|shm] capture.cap \n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    rigConfig_t         rig;
+    captureMap_t        map;
+    vClock_t            clk;
+    uint8_t             msgBuf[ipcShmSlotSize];
+    replayTarget_e      target    = replayAll;
+    captureDir_e        dir       = captureRecv;
+    enum ipcTransport   transport = IPC_DEFAULT;
+    double              scale     = 1.0;
+    int                 exact     = 0;
+    const captureRec_t* first     = NULL;
+    replayChan_t*       prev      = NULL;
+    uint64_t            numSent   = 0;
+    uint64_t            last_ns   = 0;
+    uint64_t            start_ns;
+    int                 opt;
+
+    while ((opt = getopt(argc, argv, "x:fgset:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'x':
+                scale = atof(optarg);
+                break;
+
+            case 'f':
+                target = replayFdir;
+                break;
+
+            case 'g':
+                target = replayGnc;
+                break;
+
+            case 's':
+                /* What the captured process sent, rather than what it received. */
+                dir = captureSend;
+                break;
+
+            case 'e':
+                /* Bytes exactly as captured, stamps included. */
+                exact = 1;
+                break;
+
+            case 't':
+                transport = parseIpcTransport(optarg);
+                if ((transport == IPC_DEFAULT) || (transport == IPC_INPROC))
+                {
+                    replayUsage(argv[0]);
+                    return -1;
+                }
+                break;
+
+            default:
+                replayUsage(argv[0]);
+                return -1;
+        }
+    }
+    if ((optind >= argc) || (scale < 0.0))
+    {
+        replayUsage(argv[0]);
+        return -1;
+    }
+
+    if ((initRigConfig(&rig) == -1) || (mapCapture(argv[optind], &map) == -1))
+    {
+        return -1;
+    }
+    printf("Replaying %s of %s at %s \n", (dir == captureRecv) ? "inputs" : "outputs", map.hdr->app,
+           (scale == 0.0) ? "full speed" : "the captured pace");
+
+    signal(SIGINT, replayStopHandler);
+    signal(SIGTERM, replayStopHandler);
+
+    /* Capture time since the first message is the scenario time of the clock. */
+    initVClock(&clk, scale);
+    start_ns = getTimeNs();
+    for (const captureRec_t* rec = nextCaptureRec(&map, NULL); (rec != NULL) && (replayStop == 0);
+         rec = nextCaptureRec(&map, rec))
+    {
+        replayChan_t* ch;
+
+        if ((rec->dir != dir) || (rec->len > sizeof(msgBuf)) || (replayPortMatch(&rig, target, rec->port) == 0))
+        {
+            continue;
+        }
+        if (first == NULL)
+        {
+            first = rec;
+        }
+        ch = replayChan(&rig, rec->port, transport, (scale == 0.0));
+        if (ch == NULL)
+        {
+            fprintf(stderr, "Could not open a channel to port %u \n", rec->port);
+            break;
+        }
+        /* Records of different threads may be slightly out of order, those go at once. */
+        if (rec->time_ns > first->time_ns)
+        {
+            vClockWaitUntil(&clk, rec->time_ns - first->time_ns);
+        }
+        /*
+         * Unpaced, the target would take each channel in its own order. Moving to another channel waits until
+         * the last one was taken, so messages arrive in captured order however fast the target is.
+         */
+        if ((scale == 0.0) && (prev != NULL) && (prev != ch))
+        {
+            while ((pendingMsgIPC(&prev->cfg) > 0) && (replayStop == 0))
+            {
+                sched_yield();
+            }
+        }
+        prev = ch;
+
+        memcpy(msgBuf, captureRecData(rec), rec->len);
+        if ((exact == 0) && (rec->len >= sizeof(msgHeader_t)))
+        {
+            /* Hops keep their spacing but move to this clock, so the target's latency tables stay meaningful. */
+            msgHeader_t* hdr   = (msgHeader_t *) msgBuf;
+            uint64_t     shift = getTimeNs() - rec->time_ns;
+
+            for (unsigned int s = 0; s < numMsgStamps; s++)
+            {
+                if (hdr->stamp_ns[s] != 0)
+                {
+                    hdr->stamp_ns[s] += shift;
+                }
+            }
+        }
+        if (sendMsgIPC(&ch->cfg, msgBuf, rec->len) >= 0)
+        {
+            ch->numSent++;
+            numSent++;
+        }
+        else
+        {
+            ch->numDropped++;
+        }
+        last_ns = rec->time_ns;
+    }
+
+    printf("Replayed %lu messages on %u channels, %.3f s of capture in %.3f s \n", (unsigned long) numSent,
+           replayNumChans, (first != NULL) ? (double) (last_ns - first->time_ns) * 1e-9 : 0.0,
+           (double) (getTimeNs() - start_ns) * 1e-9);
+    for (unsigned int i = 0; i < replayNumChans; i++)
+    {
+        printf("  port %u: %lu sent, %lu dropped \n", replayChans[i].port, (unsigned long) replayChans[i].numSent,
+               (unsigned long) replayChans[i].numDropped);
+    }
+    if (map.hdr->numDropped > 0)
+    {
+        printf("The capture itself dropped %lu messages \n", (unsigned long) map.hdr->numDropped);
+    }
+    unmapCapture(&map);
+    return 0;
+}
@@ -1,164 +1,682 @@
 // ()
+#define _GNU_SOURCE
+
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "sensorFdir.h"
-#include "threadLib.h"
 
-void initFdirReadIpc(ipcConfig_t* cfg, uint16_t numSensors, uint16_t basePort)
+const char* const fdirLatNames[numFdirLat] = {"link", "fdir"};
+
+/* Telemetry of each forwarded frame: units received and the one selected. */
+static const char* const fdirSelectName[numGncSensorIf] = {"imuSelect", "gnssSelect", "strSelect"};
+static const char* const fdirSelectFmt[numGncSensorIf]  = {"Rx %u IMU Packets, Selecting IMU %u ",
+                                                           "Rx %u GNSS Packets, Selecting GNSS %u ",
+                                                           "Rx %u STR Packets, Selecting STR %u "};
+
+size_t fdirArenaSize(unsigned int numUnits)
 {
-    for (size_t i = 0; i < numSensors; i++)
+    return arenaSizeOf(sizeof(taskArg_t)) + arenaSizeOf(numUnits * sizeof(fdirUnit_t)) +
+           arenaSizeOf(numUnits * sizeof(sensorMsg_u)) + arenaSizeOf(numUnits * sizeof(unsigned int)) +
+           arenaSizeOf(sizeof(voteFrame_t)) + arenaSizeOf(sizeof(ipcConfig_t));
+}
+
+taskArg_t* initFdirSensor(fdirStage_t* st, sensorIn_e sensor, uint64_t deadline_ns)
+{
+    const rigConfig_t* rig   = &st->rig;
+    arena_t*           arena = &st->arena;
+    const rigSensor_t* rs    = &rig->sensor[sensor];
+    taskArg_t*         args;
+
+    if (rs->numUnits > voteMaxUnits)
+    {
+        fprintf(stderr, "%s: FDIR votes over at most %u units \n", sensorNames[sensor], voteMaxUnits);
+        return NULL;
+    }
+    /* Hot state first: the task, then its units, then the frame slots. */
+    args = arenaAlloc(arena, sizeof(taskArg_t));
+    if (args == NULL)
+    {
+        return NULL;
+    }
+    args->owner       = st;
+    args->sensor      = sensor;
+    args->numSensors  = rs->numUnits;
+    args->deadline_ns = deadline_ns;
+    args->selectEvent = telemEvent(fdirSelectName[sensor], fdirSelectFmt[sensor]);
+    args->unit        = arenaAlloc(arena, rs->numUnits * sizeof(fdirUnit_t));
+    args->slot        = arenaAlloc(arena, rs->numUnits * sizeof(sensorMsg_u));
+    args->rxUnit      = arenaAlloc(arena, rs->numUnits * sizeof(unsigned int));
+    args->outputCfg   = arenaAlloc(arena, sizeof(ipcConfig_t));
+    if ((args->unit == NULL) || (args->slot == NULL) || (args->rxUnit == NULL) || (args->outputCfg == NULL))
+    {
+        return NULL;
+    }
+
+    /* Quaternions do not vote per component, q and -q are the same attitude. */
+    if (sensor != STK)
+    {
+        args->vote = arenaAlloc(arena, sizeof(voteFrame_t));
+        if ((args->vote == NULL) ||
+            (initVoteFrame(args->vote, fdirVoteChannels, (sensor == IMU) ? imuVoteTol : gnssVoteTol) == -1))
+        {
+            return NULL;
+        }
+    }
+
+    for (unsigned int u = 0; u < args->numSensors; u++)
     {
+        ipcConfig_t* cfg = &args->unit[u].inputCfg;
+
+        if (args->vote != NULL)
+        {
+            initResidualUnit(&args->unit[u].resid, (sensor == IMU) ? &imuResidualCfg : &gnssResidualCfg,
+                             fdirVoteChannels);
+        }
         /* Application receives sensor data. */
-        cfg[i].direction = INPUT;
-        cfg[i].ipAddress = (char *) IPCAddr;
-        cfg[i].port      = basePort + i;
-        initIPC(&cfg[i]);
+        setIpcAddrPortTransport(cfg, (char *) rig->ipcAddr, rs->fdirPort + u, INPUT, st->cfg.transport);
+        /* Frames are collected by polling all units, see fdirCollect. */
+        setIpcNonBlocking(cfg);
         /* Set up the Poll FD. */
-        cfg[i].sockPoll.fd     = cfg[i].ipcSock;
-        cfg[i].sockPoll.events = POLLIN;
+        cfg->sockPoll.fd     = cfg->ipcSock;
+        cfg->sockPoll.events = POLLIN;
     }
+
+    /* Forward to GNC. */
+    setIpcAddrPortTransport(args->outputCfg, (char *) rig->ipcAddr, rs->gncPort, OUTPUT, st->cfg.transport);
+    if (st->cfg.backpressure == 1)
+    {
+        args->outputCfg->blockOnFull = 1;
+    }
+    return args;
 }
 
-void initGncSendIpc(ipcConfig_t* cfg, unsigned int numIf)
+/* Load the channels of the given receive slots into vote frame rows 0..numRows-1. */
+static void fdirLoadVote(taskArg_t* args, const unsigned int* slotOf, unsigned int numRows)
 {
-    /* Initialize the sockets to transmit data. */
-    for (size_t i = 0; i < numIf; i++)
+    for (unsigned int row = 0; row < numRows; row++)
     {
-        cfg[i].direction = OUTPUT;
-        cfg[i].ipAddress = (char* ) IPCAddr;
+        unsigned int slot = slotOf[row];
+
+        switch (args->sensor)
+        {
+            case IMU:
+                setVoteInput(args->vote, row, 0, args->slot[slot].imu.data.velInc, 3);
+                setVoteInput(args->vote, row, 3, args->slot[slot].imu.data.angInc, 3);
+                break;
+
+            case GNSS:
+                setVoteInput(args->vote, row, 0, args->slot[slot].gnss.data.positionGd_m, 3);
+                setVoteInput(args->vote, row, 3, args->slot[slot].gnss.data.velocityEnu_m_s, 3);
+                break;
+
+            default:
+                break;
+        }
     }
-    /* Set the ports Individually. */
-    cfg[IMU].port  = ImuIpcPort;
-    cfg[GNSS].port = GnssIpcPort;
-    cfg[STK].port  = StrIpcPort;
+}
 
-    /* Init the Sockets. */
-    for (size_t i = 0; i < numIf; i++)
+/* Overwrite the channels of the forwarded message with the voted values. */
+static void fdirStoreVote(taskArg_t* args, unsigned int index)
+{
+    const double* mid = args->vote->mid;
+
+    switch (args->sensor)
     {
-        initIPC(&cfg[i]);
+        case IMU:
+            memcpy(args->slot[index].imu.data.velInc, &mid[0], sizeof(args->slot[index].imu.data.velInc));
+            memcpy(args->slot[index].imu.data.angInc, &mid[3], sizeof(args->slot[index].imu.data.angInc));
+            break;
+
+        case GNSS:
+            memcpy(args->slot[index].gnss.data.positionGd_m, &mid[0], sizeof(args->slot[index].gnss.data.positionGd_m));
+            memcpy(args->slot[index].gnss.data.velocityEnu_m_s, &mid[3], sizeof(args->slot[index].gnss.data.velocityEnu_m_s));
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Run the residual detectors of every loaded row against the vote and isolate units that raise a fault. */
+static void fdirCheckResiduals(taskArg_t* args, const unsigned int* slotOf, unsigned int numRows)
+{
+    for (unsigned int row = 0; row < numRows; row++)
+    {
+        unsigned int    u     = args->rxUnit[slotOf[row]];
+        residualUnit_t* resid = &args->unit[u].resid;
+        uint32_t        raised;
+
+        raised = updateResidualUnit(resid, args->vote->in[row], args->vote->mid);
+        if (raised != 0)
+        {
+            char               flags[4];
+            const msgHeader_t* hdr = (const msgHeader_t *) &args->slot[slotOf[row]];
+
+            if (atomic_load_explicit(&args->unit[u].faults, memory_order_relaxed) == 0)
+            {
+                args->unit[u].isolated_ns = hdr->simTime_ns;
+            }
+            atomic_store_explicit(&args->unit[u].faults, resid->faults, memory_order_relaxed);
+            if (args->owner->cfg.stepped == 1)
+            {
+                continue;
+            }
+            /* Scenario time of the sample, detection latency is this minus the fault onset. */
+            printf("%s %u isolated at %.3f s, fault %s on channel %u \n", sensorNames[args->sensor], u,
+                   (double) hdr->simTime_ns * 1e-9, residualFaultStr(resid->faults, flags), resid->faultChannel);
+        }
     }
 }
 
 unsigned int fdirSelect(taskArg_t* args, unsigned int numRx)
 {
-    if (numRx == args->numSensors)
+    unsigned int slotOf[voteMaxUnits];
+    unsigned int numRows    = 0;
+    unsigned int numHealthy = 0;
+    uint32_t     miscompare;
+    unsigned int row;
+
+    if ((args->vote == NULL) || (numRx == 0))
     {
-        /* All Sensors Working, select index 0 */
+        /* Nothing to vote on, forward the first unit. */
         return 0;
     }
-    else if (numRx < args->numSensors)
+
+    /* Healthy units first. Only they vote, isolated units are still checked against the result. */
+    for (unsigned int pass = 0; pass < 2; pass++)
+    {
+        for (unsigned int k = 0; k < numRx; k++)
+        {
+            int isolated = (args->unit[args->rxUnit[k]].resid.faults != 0);
+
+            if (isolated == (int) pass)
+            {
+                slotOf[numRows++] = k;
+            }
+        }
+        if (pass == 0)
+        {
+            numHealthy = numRows;
+        }
+    }
+    if (numHealthy == 0)
     {
-        /* We have a problem now. */
-        /* Select index less than numSensors. */
-        args->numSensors = numRx;
-        return numRx;
+        /* Everything isolated. A vote over all units still beats forwarding one blindly. */
+        numHealthy = numRows;
     }
+
+    fdirLoadVote(args, slotOf, numRows);
+    miscompare = voteMidValue(args->vote, numHealthy);
+    for (row = 0; row < numHealthy; row++)
+    {
+        unsigned int u = args->rxUnit[slotOf[row]];
+
+        if (((miscompare >> row) & 1U) &&
+            (atomic_fetch_add_explicit(&args->unit[u].numMiscompare, 1, memory_order_relaxed) == 0) &&
+            (args->owner->cfg.stepped == 0))
+        {
+            printf("%s %u miscompares, %.1f tolerances from the voted value \n", sensorNames[args->sensor], u,
+                   args->vote->maxDev[row]);
+        }
+    }
+    fdirCheckResiduals(args, slotOf, numRows);
+
+    /* Forward the healthy unit closest to the vote, carrying the voted channels. */
+    row = slotOf[voteBestUnit(args->vote)];
+    fdirStoreVote(args, row);
+    return row;
 }
 
-void* fdirThread(void* argP)
+msgHeader_t* fdirPeekSample(taskArg_t* args, unsigned int unit)
 {
-    taskArg_t* args = (taskArg_t *) argP;
-    ssize_t ret;
+    fdirBurst_t* burst = &args->unit[unit].burst;
+
+    if (burst->next >= burst->count)
+    {
+        /* Queue drained. Take everything the unit has queued in one receive. */
+        int ret = recvMsgBatchIPC(&args->unit[unit].inputCfg, (uint8_t *) burst->msg, sizeof(sensorMsg_u),
+                                  sizeof(sensorMsg_u), burst->len, fdirMaxBurst);
+        burst->next  = 0;
+        burst->count = (ret > 0) ? (unsigned int) ret : 0;
+        if (ret <= 0)
+        {
+            return NULL;
+        }
+
+        /* Every sensor message starts with its header, so any union member reaches it. */
+        uint64_t now = getTimeNs();
+        for (unsigned int k = 0; k < burst->count; k++)
+        {
+            msgHeader_t* hdr = &burst->msg[k].imu.data.hdr;
+
+            hdr->stamp_ns[stampFdirIn] = now;
+            addLatency(&args->owner->latency, args->sensor, fdirLatLink, hdr->stamp_ns[stampSent], now);
+        }
+    }
+    return &burst->msg[burst->next].imu.data.hdr;
+}
+
+ssize_t fdirNextSample(taskArg_t* args, unsigned int unit, uint8_t* dataBuf, size_t dataBufSize)
+{
+    fdirBurst_t* burst = &args->unit[unit].burst;
+    ssize_t      len;
+
+    if (fdirPeekSample(args, unit) == NULL)
+    {
+        return -1;
+    }
+    len = burst->len[burst->next];
+    if (dataBuf != NULL)
+    {
+        memcpy(dataBuf, &burst->msg[burst->next], dataBufSize);
+    }
+    burst->next++;
+    return len;
+}
+
+/* Sequence order that survives wrap around. */
+static int seqAfter(uint32_t a, uint32_t b)
+{
+    return (int32_t) (a - b) > 0;
+}
+
+/* Receive slot buffer of this sensor type. */
+static uint8_t* fdirSlot(taskArg_t* args, unsigned int slot, size_t* size)
+{
+    switch (args->sensor)
+    {
+        case IMU:
+            *size = sizeof(imuData_t);
+            return args->slot[slot].imu.dataBuf;
+
+        case GNSS:
+            *size = sizeof(gnssData_t);
+            return args->slot[slot].gnss.dataBuf;
+
+        default:
+            *size = sizeof(strTrkData_t);
+            return args->slot[slot].str.dataBuf;
+    }
+}
+
+unsigned int fdirCollect(taskArg_t* args)
+{
+    struct pollfd fds[voteMaxUnits];
+    uint32_t      expect   = 0;     //< Units the frame waits for.
+    uint32_t      got      = 0;     //< Units with a sample in this frame.
+    uint32_t      done     = 0;     //< Units that delivered or moved past this frame.
+    unsigned int  numRx    = 0;
+    int           open     = 0;
+    uint32_t      seq      = 0;
+    uint64_t      deadline = 0;
+
+    for (unsigned int u = 0; u < args->numSensors; u++)
+    {
+        if (args->unit[u].missRun < fdirSilentFrames)
+        {
+            expect |= 1U << u;
+        }
+    }
+
     while (1)
     {
-        /* Receive IMU Data. */
-        for (size_t i = 0; i < args->numSensors; i++)
+        if (open == 0)
         {
-            switch (args->sensor)
+            /*
+             * Open the frame at the oldest sample queued on any unit. Opening at whichever unit is polled first
+             * would turn the others' copies of a sample that unit missed late, and lose the frame.
+             */
+            for (unsigned int u = 0; u < args->numSensors; u++)
             {
-            case IMU:
-                ret = recvMsgIPC(&args->inputCfg[i], imuMsg[i].dataBuf, sizeof(imuData_t));
-                rxImu++;
-                break;
+                msgHeader_t* hdr;
 
-            case GNSS:
-                ret = recvMsgIPC(&args->inputCfg[i], gnssMsg[i].dataBuf, sizeof(gnssData_t));
-                rxGnss++;
-                break;
+                while ((hdr = fdirPeekSample(args, u)) != NULL)
+                {
+                    if (args->haveLast && !seqAfter(hdr->seq, args->lastSeq))
+                    {
+                        /* Its frame closed already. */
+                        fdirNextSample(args, u, NULL, 0);
+                        atomic_fetch_add_explicit(&args->unit[u].numLate, 1, memory_order_relaxed);
+                        continue;
+                    }
+                    if ((open == 0) || seqAfter(seq, hdr->seq))
+                    {
+                        open = 1;
+                        seq  = hdr->seq;
+                    }
+                    break;
+                }
+            }
+            if (open)
+            {
+                deadline = getTimeNs() + args->deadline_ns;
+            }
+        }
 
-            case STK:
-                ret = recvMsgIPC(&args->inputCfg[i], strMsg[i].dataBuf, sizeof(strTrkData_t));
-                rxStr++;
-                break;
-            
-            default:
-                break;
+        for (unsigned int u = 0; (u < args->numSensors) && open; u++)
+        {
+            msgHeader_t* hdr;
+
+            while ((((done >> u) & 1U) == 0) && ((hdr = fdirPeekSample(args, u)) != NULL))
+            {
+                if ((args->haveLast && !seqAfter(hdr->seq, args->lastSeq)) || seqAfter(seq, hdr->seq))
+                {
+                    /* Its frame closed already, or was skipped while this unit lagged. */
+                    fdirNextSample(args, u, NULL, 0);
+                    atomic_fetch_add_explicit(&args->unit[u].numLate, 1, memory_order_relaxed);
+                    continue;
+                }
+                if (hdr->seq == seq)
+                {
+                    size_t   size;
+                    uint8_t* buf = fdirSlot(args, numRx, &size);
+
+                    fdirNextSample(args, u, buf, size);
+                    args->rxUnit[numRx++] = u;
+                    got |= 1U << u;
+                }
+                /* A newer sample stays queued for the next frame. */
+                done |= 1U << u;
             }
         }
-        (void) ret;
-        /* Select One sensor and Transmit. Hardcoded for now. */
-        switch (args->sensor)
+        if (open && ((done & expect) == expect))
         {
-            unsigned int index;
-            case IMU:
-                index = fdirSelect(args, rxImu);
-                printf("Rx %d IMU Packets, Selecting IMU %d \n", rxImu, index);
-                sendMsgIPC(&args->outputCfg[args->sensor], imuMsg[index].dataBuf, sizeof(imuData_t));
-                /* Reset the receive counter. */
-                rxImu = 0;
-                break;
+            break;
+        }
 
-            case GNSS:
-                index = fdirSelect(args, rxGnss);
-                printf("Rx %d GNSS Packets, Selecting GNSS %d \n", rxGnss, index);
-                sendMsgIPC(&args->outputCfg[args->sensor], gnssMsg[index].dataBuf, sizeof(gnssData_t));
-                rxGnss = 0;
-                break;
+        if ((open == 0) && ((args->owner->cfg.lockstep == 1) || (args->owner->cfg.stepped == 1)))
+        {
+            /* The tick's samples are all queued, there is nothing to wait for. */
+            return 0;
+        }
 
-            case STK:
-                index = fdirSelect(args, rxStr);
-                printf("Rx %d STR Packets, Selecting STR %d \n", rxStr, index);
-                sendMsgIPC(&args->outputCfg[args->sensor], strMsg[index].dataBuf, sizeof(strTrkData_t));
-                rxStr = 0;
+        /* Wait on the units still expected. Until the first sample there is no deadline. */
+        struct timespec  left;
+        struct timespec* timeout = NULL;
+        if (open)
+        {
+            uint64_t now = getTimeNs();
+            if (now >= deadline)
+            {
                 break;
+            }
+            left.tv_sec  = (time_t) ((deadline - now) / 1000000000ULL);
+            left.tv_nsec = (long) ((deadline - now) % 1000000000ULL);
+            timeout      = &left;
+        }
+        for (unsigned int u = 0; u < args->numSensors; u++)
+        {
+            fds[u]    = args->unit[u].inputCfg.sockPoll;
+            fds[u].fd = ((done >> u) & 1U) ? -1 : args->unit[u].inputCfg.ipcSock;
+        }
+        ppoll(fds, args->numSensors, timeout, NULL);
+    }
 
-            default:
-                break;
+    for (unsigned int u = 0; u < args->numSensors; u++)
+    {
+        if (((got >> u) & 1U) == 0)
+        {
+            atomic_fetch_add_explicit(&args->unit[u].numMissed, 1, memory_order_relaxed);
+            args->unit[u].missRun++;
+        }
+        else
+        {
+            args->unit[u].missRun = 0;
+        }
+    }
+    atomic_fetch_add_explicit(&args->numFrames, 1, memory_order_relaxed);
+    args->lastSeq  = seq;
+    args->haveLast = 1;
+    return numRx;
+}
+
+void printFdirStats(taskArg_t* args)
+{
+    printf("%s: %lu frames. ", sensorNames[args->sensor],
+           (unsigned long) atomic_load_explicit(&args->numFrames, memory_order_relaxed));
+    for (unsigned int u = 0; u < args->numSensors; u++)
+    {
+        fdirUnit_t* unit = &args->unit[u];
+        char        flags[4];
+
+        printf("Unit %u missed %lu, late %lu, miscompared %lu, faults %s. ", u,
+               (unsigned long) atomic_load_explicit(&unit->numMissed, memory_order_relaxed),
+               (unsigned long) atomic_load_explicit(&unit->numLate, memory_order_relaxed),
+               (unsigned long) atomic_load_explicit(&unit->numMiscompare, memory_order_relaxed),
+               residualFaultStr(atomic_load_explicit(&unit->faults, memory_order_relaxed), flags));
+    }
+    printf("\n");
+}
+
+void fdirStampOut(taskArg_t* args, msgHeader_t* hdr)
+{
+    hdr->stamp_ns[stampFdirOut] = getTimeNs();
+    addLatency(&args->owner->latency, args->sensor, fdirLatVote, hdr->stamp_ns[stampFdirIn], hdr->stamp_ns[stampFdirOut]);
+}
+
+/* Vote the frame just collected and forward it. */
+static void fdirForward(taskArg_t* args, unsigned int numRx)
+{
+    unsigned int index = fdirSelect(args, numRx);
+    sensorMsg_u* sel   = &args->slot[index];
+    size_t       size  = 0;
+
+    telemLog(args->selectEvent, numRx, args->rxUnit[index]);
+    switch (args->sensor)
+    {
+        case IMU:
+            fdirStampOut(args, &sel->imu.data.hdr);
+            size = sizeof(imuData_t);
+            break;
+
+        case GNSS:
+            fdirStampOut(args, &sel->gnss.data.hdr);
+            size = sizeof(gnssData_t);
+            break;
+
+        case STK:
+            fdirStampOut(args, &sel->str.data.hdr);
+            size = sizeof(strTrkData_t);
+            break;
+
+        default:
+            break;
+    }
+    if (size > 0)
+    {
+        /* Latest voted sample for readers of the table, then the stream to GNC. */
+        if (args->owner->latest != NULL)
+        {
+            publishLatest(args->owner->latest, args->sensor, sel, size);
+        }
+        if (args->owner->cfg.streamOut == 1)
+        {
+            sendMsgIPC(args->outputCfg, (uint8_t *) sel, size);
         }
     }
+}
+
+void* fdirThread(void* argP)
+{
+    taskArg_t* args = (taskArg_t *) argP;
+
+    if (args->owner->cfg.lockstep == 1)
+    {
+        /* Every tick, vote all frames the sensors sent in it. */
+        while (awaitLockstep(&args->step) == 0)
+        {
+            unsigned int numRx;
+
+            while ((numRx = fdirCollect(args)) > 0)
+            {
+                fdirForward(args, numRx);
+            }
+        }
+        atomic_fetch_add(&args->owner->threadsDone, 1);
+        kill(getpid(), SIGUSR2);
+        return NULL;
+    }
+
+    while (1)
+    {
+        /* Frame of whatever arrived by the deadline. */
+        fdirForward(args, fdirCollect(args));
+    }
     return NULL;
 }
 
-int main()
-{
-    sensorConfig_t cfg;
-    task_t         fdirTasks[numGncSensorIf];
-    taskArg_t      arg[3];
-
-    /* Classic TMR. */
-    setNumSensors(&cfg, 3, 3, 3);
-    
-    /* Initialize the sockets. */
-    initFdirReadIpc(imuMsgConf, cfg.imuConf.numImuSensors, imuFdirPort);
-    initFdirReadIpc(gnssMsgConf, cfg.imuConf.numImuSensors, gnssFdirPort);
-    initFdirReadIpc(strMsgConf, cfg.imuConf.numImuSensors, strFdirPort);
-
-    /* Init the output Sockets. */
-    initGncSendIpc(gncSendIpc, numGncSensorIf);
-    
-    /* Set up argument struct. */
-    arg[0].inputCfg    = imuMsgConf;
-    arg[0].sensor      = IMU;
-    arg[0].numSensors  = cfg.imuConf.numImuSensors;
-    arg[0].outputCfg   = &gncSendIpc[0];
-
-    arg[1].inputCfg    = gnssMsgConf;
-    arg[1].sensor      = GNSS;
-    arg[1].numSensors  = cfg.gnssConf.numGnssSensors;
-    arg[1].outputCfg   = &gncSendIpc[1];
-
-    arg[2].inputCfg    = strMsgConf;
-    arg[2].sensor      = STK;
-    arg[2].numSensors  = cfg.strConf.numStrTrk;
-    arg[2].outputCfg   = &gncSendIpc[2];
-
-    /* Start the Threads. */
+void initFdirCfg(fdirCfg_t* cfg)
+{
+    cfg->deadline_us  = fdirDeadlineDefault_us;
+    cfg->streamOut    = 1;
+    cfg->lockstep     = 0;
+    cfg->backpressure = 0;
+    cfg->stepped      = 0;
+    cfg->transport    = IPC_DEFAULT;
+    cfg->rig          = NULL;
+}
+
+int initFdirStage(fdirStage_t* st, const fdirCfg_t* cfg)
+{
+    size_t arenaSize = 0;
+
+    st->cfg = *cfg;
+    st->latest = NULL;
+    atomic_init(&st->threadsDone, 0);
+    if (cfg->rig != NULL)
+    {
+        st->rig = *cfg->rig;
+    }
+    else if (initRigConfig(&st->rig) == -1)
+    {
+        return -1;
+    }
+    else
+    {
+        printRigConfig(&st->rig);
+    }
+
+    /* All per sensor state in one block, each sensor type contiguous. */
     for (size_t i = 0; i < numGncSensorIf; i++)
     {
-        pthread_create(&fdirTasks[i].taskThread, NULL, fdirThread, (void *) &arg[i]);
+        arenaSize += fdirArenaSize(st->rig.sensor[i].numUnits);
+    }
+    if (initArena(&st->arena, arenaSize) == -1)
+    {
+        return -1;
     }
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        /* In lockstep or stepped a frame never waits, the samples up to now are all queued. */
+        st->arg[i] = initFdirSensor(st, (sensorIn_e) i, ((cfg->lockstep == 1) || (cfg->stepped == 1)) ?
+                                    0 : (uint64_t) (cfg->deadline_us * 1000.0));
+        if (st->arg[i] == NULL)
+        {
+            return -1;
+        }
+    }
+    initLatencyTable(&st->latency, sensorNames, numGncSensorIf, fdirLatNames, numFdirLat);
+    if (cfg->stepped == 1)
+    {
+        return 0;
+    }
+    st->latest = openLatestTable(latestTableName);
+    if (st->latest == NULL)
+    {
+        return -1;
+    }
+    /* The segment of an earlier run may still exist, its samples are not this run's. */
+    resetLatestTable(st->latest);
 
-    pthread_join(fdirTasks[0].taskThread, NULL);
-    pthread_join(fdirTasks[1].taskThread, NULL);
-    pthread_join(fdirTasks[2].taskThread, NULL);
+    for (size_t i = 0; (cfg->lockstep == 1) && (i < numGncSensorIf); i++)
+    {
+        /* GNC drains only after this stage acknowledged its tick, so never wait for space. */
+        st->arg[i]->outputCfg->blockOnFull = 0;
+        if (joinLockstep(&st->arg[i]->step, lockstepName, stepFdir, lockstepJoinTimeout_ms) == -1)
+        {
+            return -1;
+        }
+    }
     return 0;
 }
+
+int startFdirStage(fdirStage_t* st)
+{
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        if (pthread_create(&st->threads[i], NULL, fdirThread, (void *) st->arg[i]) != 0)
+        {
+            fprintf(stderr, "Could not start the %s FDIR thread \n", sensorNames[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void stepFdirStage(fdirStage_t* st)
+{
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        unsigned int numRx;
+
+        while ((numRx = fdirCollect(st->arg[i])) > 0)
+        {
+            fdirForward(st->arg[i], numRx);
+        }
+    }
+}
+
+int fdirStageDone(fdirStage_t* st)
+{
+    return (atomic_load(&st->threadsDone) == numGncSensorIf);
+}
+
+void printFdirStage(fdirStage_t* st)
+{
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        printFdirStats(st->arg[i]);
+    }
+    printLatencyTable("FDIR", &st->latency);
+}
+
+void releaseFdirStage(fdirStage_t* st)
+{
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        for (unsigned int u = 0; (st->arg[i] != NULL) && (u < st->arg[i]->numSensors); u++)
+        {
+            unlinkIPC(&st->arg[i]->unit[u].inputCfg);
+        }
+    }
+    if (st->latest != NULL)
+    {
+        unlinkLatestTable(latestTableName);
+    }
+}
+
+void closeFdirStage(fdirStage_t* st)
+{
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        for (unsigned int u = 0; (st->arg[i] != NULL) && (u < st->arg[i]->numSensors); u++)
+        {
+            closeIPC(&st->arg[i]->unit[u].inputCfg);
+        }
+        if (st->arg[i] != NULL)
+        {
+            closeIPC(st->arg[i]->outputCfg);
+        }
+    }
+    if (st->latest != NULL)
+    {
+        unlinkLatestTable(latestTableName);
+        closeLatestTable(st->latest, latestTableName);
+        st->latest = NULL;
+    }
+    closeArena(&st->arena);
+}
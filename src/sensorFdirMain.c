@@ -0,0 +1,90 @@
+// FdirHandler: the FDIR stage as a process of its own.
+
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sensorFdir.h"
+#include "captureLib.h"
+
+int main(int argc, char* argv[])
+{
+    fdirCfg_t   cfg;
+    fdirStage_t st;
+    int         opt;
+
+    initFdirCfg(&cfg);
+    while ((opt = getopt(argc, argv, "d:ls")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd':
+                /* Frame deadline after the first sample, in microseconds. */
+                cfg.deadline_us = atof(optarg);
+                break;
+
+            case 'l':
+                /* GNC reads the latest table, nothing to stream. */
+                cfg.streamOut = 0;
+                break;
+
+            case 's':
+                /* Lockstep, frames close on what the tick delivered. */
+                cfg.lockstep = 1;
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-d frameDeadline_us] [-l] [-s] \n", argv[0]);
+                return -1;
+        }
+    }
+    if (cfg.deadline_us < 0.0)
+    {
+        fprintf(stderr, "Usage: %s [-d frameDeadline_us] [-l] [-s] \n", argv[0]);
+        return -1;
+    }
+
+    if ((openTelem("FdirHandler") == -1) || (openCapture("FdirHandler") == -1) || (initFdirStage(&st, &cfg) == -1))
+    {
+        return -1;
+    }
+
+    /*
+     * FDIR threads leave signals to the main thread. SIGUSR1 prints statistics, SIGINT or SIGTERM print and
+     * exit. SIGUSR2 tells a lockstep thread finished, once all did the run is over.
+     */
+    sigset_t sigSet;
+    sigemptyset(&sigSet);
+    sigaddset(&sigSet, SIGUSR1);
+    sigaddset(&sigSet, SIGUSR2);
+    sigaddset(&sigSet, SIGINT);
+    sigaddset(&sigSet, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+
+    if (startFdirStage(&st) == -1)
+    {
+        return -1;
+    }
+
+    while (1)
+    {
+        int sig;
+
+        if ((sigwait(&sigSet, &sig) != 0) || ((sig == SIGUSR2) && (fdirStageDone(&st) == 0)))
+        {
+            continue;
+        }
+        printFdirStage(&st);
+        if (sig != SIGUSR1)
+        {
+            break;
+        }
+    }
+    releaseFdirStage(&st);
+    closeTelem();
+    closeCapture();
+    printTelemStats();
+    printCaptureStats();
+    /* The threads block on their inputs, so exit without joining. */
+    return 0;
+}
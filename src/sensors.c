@@ -1,284 +1,583 @@
 // Implements reading Sensor data and sending message on the network.
 
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "sensors.h"
 #include "threadLib.h"
-#include "interfaceLib.h"
-#include "config.h"
+#include "npyStreamLib.h"
 
-uint8_t imuMsgBuf[sizeof(imuData_t)];
-uint8_t gnssMsgBuf[sizeof(gnssData_t)];
-uint8_t strMsgBuf[sizeof(strTrkData_t)];
-
-task_t  imuTask;
-task_t  gnssTask;
-task_t  strTask;
+/* Sensor side latency, read to hand off and the hand off itself. */
+typedef enum
+{
+    latRead    = 0,
+    latSend    = 1,
+    numLatSpan = 2
+} sensorLatSpan_e;
 
-uint8_t fdir = 0;
+const char* const latSpanNames[numLatSpan] = {"read", "send"};
 
-/* Iterations after which a sensor Fault occurs. */
+/* Iterations after which the default IMU fault occurs, when FDIR is enabled without a fault script. */
 const uint8_t fdirEnableIter = 10;
 
-typedef struct
+/* Files from this size on are streamed through a bounded prefetch buffer instead of mapped. */
+const size_t npyStreamMinBytes = 64UL << 20;
+
+struct sensStream
 {
+    const char*     name;
+    sensorIn_e      sensor;
     ipcConfig_t*    cfg;
     unsigned int    numSensors;
     uint8_t*        dataBuf;
-    task_t*         tCfg;
-    npy_array_t*    np;
-} taskArg_t;
+    npyMap_t*       np;
+    npyStream_t*    st;                 //< Set when the file is streamed rather than mapped.
+    size_t          numRows;
+    size_t          row;                //< Next row to send.
+    double          rate_Hz;            //< Scenario sample rate. Row i is released at i / rate_Hz + latency.
+    uint64_t        latency_ns;         //< Delivery behind the sample time.
+    faultSensor_t*  faults;             //< NULL unless the fault script names this sensor.
+    uint8_t*        unitBuf;            //< Per unit copy of the sample while injecting.
+    size_t          chOffset;           //< Channels faults act on, doubles from this message offset.
+    unsigned int    numCh;
+    latencyTable_t* latency;            //< Table of the stage.
+    int             sentEvent;          //< Telemetry of each send.
+};
 
-/* Function to read IMU data from numpy binary file. */
-void* getImuDataNpy(void* argP)
+/* Next replay row. Only valid until the following call. */
+static const char* nextRow(sensStream_t* arg, size_t row)
 {
-    taskArg_t* arg = (taskArg_t* ) argP;
-    double temp;
-    char * ptr;
-    size_t iter = arg->np->shape[0];
-    size_t idx = 0;
-    ssize_t retval;
-    imuData_t rawData;
-    rawData.tInc = 0.01;
-    for (size_t i = 0; i < iter; i++)
+    if (arg->st != NULL)
     {
-        ptr = arg->np->data;
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.velInc[0] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.velInc[1] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.velInc[2] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.angInc[0] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.angInc[1] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.angInc[2] = temp;
-        idx += sizeof(double);             
-
-        memcpy(arg->dataBuf, (void*) &rawData, sizeof(rawData));
-        if ((fdir == 1) && (i > fdirEnableIter))
+        return npyStreamNextRow(arg->st);
+    }
+    return npyMapRow(arg->np, row);
+}
+
+/* Header for the current row, released at simTime_ns. Stamps of later hops start cleared. */
+static void setMsgHeader(msgHeader_t* hdr, sensStream_t* arg, uint64_t simTime_ns, uint64_t read_ns)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->simTime_ns          = simTime_ns - arg->latency_ns;
+    hdr->seq                 = (uint32_t) arg->row;
+    hdr->stamp_ns[stampRead] = read_ns;
+}
+
+/* Send to every unit through the fault injector. Returns the number of messages sent. */
+static ssize_t sendFaulted(sensStream_t* arg, uint64_t simTime_ns, size_t size)
+{
+    const faultHeld_t* held;
+    ssize_t            numSent = 0;
+
+    for (unsigned int u = 0; u < arg->numSensors; u++)
+    {
+        uint64_t     release_ns = 0;
+        unsigned int act;
+
+        memcpy(arg->unitBuf, arg->dataBuf, size);
+        act = applyFaults(arg->faults, u, simTime_ns, (double *) (arg->unitBuf + arg->chOffset), arg->numCh,
+                          &release_ns);
+        if ((act & faultActDrop) != 0)
+        {
+            /* Lost, whatever else is active. */
+        }
+        else if (((act & faultActHold) == 0) ||
+                 (holdFaultSample(arg->faults, u, release_ns, arg->unitBuf, size) == -1))
         {
-            /* Reduce number of working sensors to 2. */
-            arg->numSensors = 2;
-            printf("Fault Injected for IMU. \n");
-            /* Just so we do not enter this peice of code again. */
-            fdir = 0;
+            numSent += (sendMsgIPC(&arg->cfg[u], arg->unitBuf, size) >= 0);
+            if ((act & faultActDuplicate) != 0)
+            {
+                numSent += (sendMsgIPC(&arg->cfg[u], arg->unitBuf, size) >= 0);
+            }
         }
 
-        /* Sleep. */
-        for (size_t i = 0; i < arg->numSensors; i++)
+        /* Held samples now due go out after the current one. */
+        while ((held = releaseFaultSample(arg->faults, u, simTime_ns)) != NULL)
         {
-            retval = sendMsgIPC(&arg->cfg[i], arg->dataBuf, sizeof(rawData));
+            numSent += (sendMsgIPC(&arg->cfg[u], (uint8_t *) held->data, held->size) >= 0);
         }
-        printf("Sent %d IMU Msg.  %ld \n", arg->numSensors, retval);
-        retval = threadSleep(arg->tCfg);
     }
-    return NULL;
+    return numSent;
 }
-/* Function to read GNSS data from numpy binary file. */
-void* getGnssDataNpy(void* argP)
+
+/* End of the data. Samples still held go out now, late, rather than be lost. Returns -1 to retire the stream. */
+static int endStream(sensStream_t* arg)
 {
-    taskArg_t* arg = (taskArg_t* ) argP;
-    double temp;
-    char * ptr;
-    size_t nRows = arg->np->shape[0];
-    size_t idx = 0;
-    ssize_t retval;
-    gnssData_t rawData;
-    rawData.DOP = 0.8;
-    rawData.validity = 1;
-    for (size_t i = 0; i < nRows; i++)
+    const faultHeld_t* held;
+
+    for (unsigned int u = 0; (arg->faults != NULL) && (u < arg->numSensors); u++)
     {
-        ptr = arg->np->data;
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.positionGd_m[0] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.positionGd_m[1] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.positionGd_m[2] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.velocityEnu_m_s[0] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.velocityEnu_m_s[1] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.velocityEnu_m_s[2] = temp;
-        idx += sizeof(double);             
-
-        memcpy(arg->dataBuf, (void*) &rawData, sizeof(rawData));
-        /* Sleep. */
-        for (size_t i = 0; i < arg->numSensors; i++)
+        while ((held = releaseFaultSample(arg->faults, u, UINT64_MAX)) != NULL)
         {
-            retval = sendMsgIPC(&arg->cfg[i], arg->dataBuf, sizeof(rawData));
+            sendMsgIPC(&arg->cfg[u], (uint8_t *) held->data, held->size);
         }
-        printf("Sent %d GNSS Msg. %ld \n", arg->numSensors, retval);
-        retval = threadSleep(arg->tCfg);
     }
-    return NULL;
+    return -1;
+}
+
+/* Stamp the hand off, send to every unit and record the sensor side latency. */
+static ssize_t sendSample(sensStream_t* arg, msgHeader_t* hdr, const void* msg, size_t size)
+{
+    ssize_t retval;
+
+    hdr->stamp_ns[stampSent] = getTimeNs();
+    memcpy(arg->dataBuf, msg, size);
+    if (arg->faults == NULL)
+    {
+        /* One syscall for the whole redundant set. */
+        retval = sendMsgBatchIPC(arg->cfg, arg->numSensors, arg->dataBuf, size);
+    }
+    else
+    {
+        retval = sendFaulted(arg, hdr->simTime_ns, size);
+    }
+    addLatency(arg->latency, arg->sensor, latRead, hdr->stamp_ns[stampRead], hdr->stamp_ns[stampSent]);
+    addLatency(arg->latency, arg->sensor, latSend, hdr->stamp_ns[stampSent], getTimeNs());
+    return retval;
+}
+
+/* Read one IMU row from the numpy binary file and send it. Returns -1 at end of data. */
+int getImuDataNpy(void* argP, uint64_t simTime_ns)
+{
+    sensStream_t* arg = (sensStream_t* ) argP;
+    const char* ptr;
+    ssize_t retval;
+    imuData_t rawData;
+
+    /* Row read in place from the mapped file or the stream buffer. */
+    uint64_t read_ns = getTimeNs();
+
+    if (arg->row >= arg->numRows)
+    {
+        return endStream(arg);
+    }
+    ptr = nextRow(arg, arg->row);
+    if (ptr == NULL)
+    {
+        return endStream(arg);
+    }
+    setMsgHeader(&rawData.hdr, arg, simTime_ns, read_ns);
+    rawData.tInc     = 1 / arg->rate_Hz;
+    rawData.validity = 1;
+    memcpy(rawData.velInc, ptr, sizeof(rawData.velInc));
+    memcpy(rawData.angInc, ptr + sizeof(rawData.velInc), sizeof(rawData.angInc));
+
+    retval = sendSample(arg, &rawData.hdr, &rawData, sizeof(rawData));
+    telemLog(arg->sentEvent, (uint64_t) retval, arg->numSensors);
+    arg->row++;
+    return 0;
 }
-/* Function to read Star Tracker data from numpy binary file. */
-void* getStrDataNpy(void* argP)
+
+/* Read one GNSS row from the numpy binary file and send it. Returns -1 at end of data. */
+int getGnssDataNpy(void* argP, uint64_t simTime_ns)
 {
-    taskArg_t* arg = (taskArg_t* ) argP;
-    double temp;
-    char * ptr;
-    size_t nRows = arg->np->shape[0];
-    size_t idx = 0;
+    sensStream_t* arg = (sensStream_t* ) argP;
+    const char* ptr;
+    ssize_t retval;
+    gnssData_t rawData;
+
+    uint64_t read_ns = getTimeNs();
+
+    if (arg->row >= arg->numRows)
+    {
+        return endStream(arg);
+    }
+    ptr = nextRow(arg, arg->row);
+    if (ptr == NULL)
+    {
+        return endStream(arg);
+    }
+    setMsgHeader(&rawData.hdr, arg, simTime_ns, read_ns);
+    rawData.DOP      = 0.8;
+    rawData.validity = 1;
+    memcpy(rawData.positionGd_m, ptr, sizeof(rawData.positionGd_m));
+    memcpy(rawData.velocityEnu_m_s, ptr + sizeof(rawData.positionGd_m), sizeof(rawData.velocityEnu_m_s));
+
+    retval = sendSample(arg, &rawData.hdr, &rawData, sizeof(rawData));
+    telemLog(arg->sentEvent, (uint64_t) retval, arg->numSensors);
+    arg->row++;
+    return 0;
+}
+
+/* Read one Star Tracker row from the numpy binary file and send it. Returns -1 at end of data. */
+int getStrDataNpy(void* argP, uint64_t simTime_ns)
+{
+    sensStream_t* arg = (sensStream_t* ) argP;
+    const char* ptr;
     ssize_t retval;
     strTrkData_t rawData;
 
-    for (size_t i = 0; i < nRows; i++)
+    uint64_t read_ns = getTimeNs();
+
+    if (arg->row >= arg->numRows)
     {
-        ptr = arg->np->data;
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.timeTag = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.quaternion[0] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.quaternion[1] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.quaternion[2] = temp;
-        idx += sizeof(double);
-        memcpy(&temp, ptr + idx, sizeof(double));
-        rawData.quaternion[3] = temp;
-
-        memcpy(arg->dataBuf, (void* ) &rawData, sizeof(rawData));
-
-        for (size_t i = 0; i < arg->numSensors; i++)
+        return endStream(arg);
+    }
+    ptr = nextRow(arg, arg->row);
+    if (ptr == NULL)
+    {
+        return endStream(arg);
+    }
+    setMsgHeader(&rawData.hdr, arg, simTime_ns, read_ns);
+    memcpy(&rawData.timeTag, ptr, sizeof(rawData.timeTag));
+    memcpy(rawData.quaternion, ptr + sizeof(rawData.timeTag), sizeof(rawData.quaternion));
+
+    retval = sendSample(arg, &rawData.hdr, &rawData, sizeof(rawData));
+    telemLog(arg->sentEvent, (uint64_t) retval, arg->numSensors);
+    arg->row++;
+    return 0;
+}
+
+/* Lockstep gate. A release waits for the tick that contains its time. */
+static int lockstepGate(void* ctx, uint64_t release_ns)
+{
+    lockstepMember_t* m = (lockstepMember_t *) ctx;
+
+    while ((m->active == 0) || (release_ns >= m->tickEnd_ns))
+    {
+        if (awaitLockstep(m) == -1)
         {
-            retval = sendMsgIPC(&arg->cfg[i], strMsgBuf, sizeof(rawData));
+            return -1;
         }
-        printf("Sent %d Star Tracker Msg %ld \n", arg->numSensors, retval);
-        retval = threadSleep(arg->tCfg);
     }
+    return 0;
+}
+
+/* Runs the scheduler off the main thread, which stays free for SIGUSR1. */
+static void* replayThread(void* argP)
+{
+    sensStage_t* st = (sensStage_t* ) argP;
+
+    st->numSent = runSched(&st->sch);
+    if (st->cfg.lockstep == 1)
+    {
+        /* Out of data. The coordinator finishes this tick downstream and ends the run. */
+        leaveLockstep(&st->step);
+    }
+    st->end_ns = getTimeNs();
+    atomic_store(&st->done, 1);
+    /* Wake the main thread now rather than at its next poll. */
+    kill(getpid(), SIGUSR2);
     return NULL;
 }
 
-int main(int argc, char* argv[])
+void initSensCfg(sensCfg_t* cfg)
+{
+    cfg->replayScale = 1.0;
+    cfg->numWorkers  = 1;
+    cfg->faultPath   = NULL;
+    cfg->fdir        = 0;
+    cfg->lockstep    = 0;
+    cfg->transport   = IPC_DEFAULT;
+    cfg->rig         = NULL;
+    cfg->script      = NULL;
+    cfg->seed        = 0;
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        cfg->noise[i] = NULL;
+    }
+}
+
+int initSensStage(sensStage_t* st, const sensCfg_t* cfg)
 {
-    /* Unused parameter. */
-    (void) argv;
+    rigConfig_t*   rig       = &st->rig;
+    faultScript_t* script    = &st->script;
+    size_t         arenaSize = 0;
+
+    st->cfg     = *cfg;
+    st->numSent = 0;
+    atomic_init(&st->done, 0);
 
-    /* FDIR Enable */
-    if (argc > 1)
+    /* Rig description, defaults from config.h unless TEC_RIG_CONFIG names a file. */
+    if (cfg->rig != NULL)
+    {
+        *rig = *cfg->rig;
+    }
+    else if (initRigConfig(rig) == -1)
     {
-        fdir = 1;
+        return -1;
+    }
+    else
+    {
+        printRigConfig(rig);
     }
 
-    /* IPC Config. */
-    ipcConfig_t imuMsgConf[maxNumImu];
-    ipcConfig_t gnssMsgConf[maxNumGnss];
-    ipcConfig_t strMsgConf[maxNumStrTrk];
+    /* 
+     * Faults per sensor type. Without a script, FDIR runs lose the last IMU unit after fdirEnableIter
+     * samples, as a basic check that the vote carries on.
+     */
+    initFaultScript(script, sensorSections, numGncSensorIf);
+    if (cfg->script != NULL)
+    {
+        *script = *cfg->script;
+    }
+    else if (cfg->faultPath != NULL)
+    {
+        if (loadFaultScript(script, cfg->faultPath) == -1)
+        {
+            return -1;
+        }
+    }
+    else if ((cfg->fdir == 1) && (rig->sensor[IMU].numUnits > 1))
+    {
+        fault_t drop = {faultDropout, rig->sensor[IMU].numUnits - 1, -1,
+                        (uint64_t) ((fdirEnableIter + 1) * 1e9 / rig->sensor[IMU].rate_Hz), UINT64_MAX, 0.0};
+
+        addFault(script, IMU, &drop);
+    }
 
-    /* Task Arguments Config. */
-    taskArg_t args[numGncSensorIf];
+    /* Bytes per row each reader expects. */
+    const size_t rowSize[numGncSensorIf] = {6 * sizeof(double), 6 * sizeof(double), 5 * sizeof(double)};
 
-    /* DataBuffer. */
-    imuData_u    imuBuf;
-    gnssData_u   gnssBuf;
-    strTrkData_u stkBuf;
+    /* Each sensor is a stream on the scheduler. */
+    const schedCallback_t emit[numGncSensorIf] = {getImuDataNpy, getGnssDataNpy, getStrDataNpy};
 
-    args[0].dataBuf = imuBuf.dataBuf;
-    args[1].dataBuf = gnssBuf.dataBuf;
-    args[2].dataBuf = stkBuf.dataBuf;
+    /* Channels faults act on: increments, position and velocity, quaternion. */
+    const size_t       chOffset[numGncSensorIf] = {offsetof(imuData_t, velInc), offsetof(gnssData_t, positionGd_m),
+                                                   offsetof(strTrkData_t, quaternion)};
+    const unsigned int numCh[numGncSensorIf]    = {6, 6, 4};
 
-    /* File Interface Configs. */
-    interfaceCfg_t inputIf[numGncSensorIf];
+    /* Telemetry of each send, formatted by the drain thread or the decoder. */
+    const char* const sentName[numGncSensorIf] = {"imuSent", "gnssSent", "strSent"};
+    const char* const sentFmt[numGncSensorIf]  = {"Sent %ld of %u IMU Msg. ", "Sent %ld of %u GNSS Msg. ",
+                                                  "Sent %ld of %u Star Tracker Msg. "};
 
-    /* Sensor Config. */
-    sensorConfig_t sensConf;
+    /* 
+     * Streams, then per sensor its unit channels, message buffer, file readers and injection state, from one
+     * arena.
+     */
+    sensStream_t* args;
 
-    /* Task Property */
-    task_t task[numGncSensorIf];
- 
+    arenaSize = arenaSizeOf(numGncSensorIf * sizeof(sensStream_t));
     for (size_t i = 0; i < numGncSensorIf; i++)
     {
-        args[i].tCfg = &task[i];
+        arenaSize += arenaSizeOf(rig->sensor[i].numUnits * sizeof(ipcConfig_t)) + arenaSizeOf(sizeof(sensorMsg_u)) +
+                     arenaSizeOf(sizeof(interfaceCfg_t)) + arenaSizeOf(sizeof(npyMap_t)) +
+                     arenaSizeOf(sizeof(npyStream_t));
+        if ((script->type[i].numFaults > 0) || (cfg->noise[i] != NULL))
+        {
+            arenaSize += arenaSizeOf(sizeof(faultSensor_t)) + arenaSizeOf(sizeof(sensorMsg_u)) +
+                         arenaSizeOf(rig->sensor[i].numUnits * sizeof(faultUnit_t));
+        }
     }
-
-    if (fdir == 1)
+    if (initArena(&st->arena, arenaSize) == -1)
     {
-        setNumSensors(&sensConf, 3, 3, 3);        
+        return -1;
     }
-    else
+    args       = arenaAlloc(&st->arena, numGncSensorIf * sizeof(sensStream_t));
+    st->stream = args;
+
+    initLatencyTable(&st->latency, sensorNames, numGncSensorIf, latSpanNames, numLatSpan);
+
+    for (size_t i = 0; i < numGncSensorIf; i++)
     {
-        setNumSensors(&sensConf, 1, 1, 1);
-    }
+        const rigSensor_t* rs = &rig->sensor[i];
+        interfaceCfg_t*    inputIf;
+        npyMap_t*          inputNpy;
+        npyHeader_t*       hdr;
+
+        args[i].sensor     = (sensorIn_e) i;
+        args[i].name       = sensorNames[i];
+        args[i].rate_Hz    = rs->rate_Hz;
+        args[i].latency_ns = (uint64_t) (rs->latency_ms * 1e6);
+        args[i].latency    = &st->latency;
+        args[i].sentEvent  = telemEvent(sentName[i], sentFmt[i]);
+        /* With FDIR every redundant unit sends, without it one unit feeds GNC directly. */
+        args[i].numSensors = (cfg->fdir == 1) ? rs->numUnits : 1;
+        args[i].cfg        = arenaAlloc(&st->arena, args[i].numSensors * sizeof(ipcConfig_t));
+        args[i].dataBuf    = ((sensorMsg_u *) arenaAlloc(&st->arena, sizeof(sensorMsg_u)))->imu.dataBuf;
+        inputIf            = arenaAlloc(&st->arena, sizeof(interfaceCfg_t));
+        inputNpy           = arenaAlloc(&st->arena, sizeof(npyMap_t));
+
+        if ((script->type[i].numFaults > 0) || (cfg->noise[i] != NULL))
+        {
+            faultUnit_t* units = arenaAlloc(&st->arena, args[i].numSensors * sizeof(faultUnit_t));
+
+            args[i].faults   = arenaAlloc(&st->arena, sizeof(faultSensor_t));
+            args[i].unitBuf  = arenaAlloc(&st->arena, sizeof(sensorMsg_u));
+            args[i].chOffset = chOffset[i];
+            args[i].numCh    = numCh[i];
+            if (initFaultSensor(args[i].faults, &script->type[i], units, args[i].numSensors,
+                                cfg->seed + i + 1U) == -1)
+            {
+                return -1;
+            }
+            setFaultNoise(args[i].faults, cfg->noise[i]);
+        }
+
+        /* Init File interface. */
+        setInterface(inputIf, INPUT, (char *) rs->file);
+        if (npyMapData(inputIf, inputNpy) == -1)
+        {
+            fprintf(stderr, "Could not map sensor data %s \n", rs->file);
+            return -1;
+        }
+        args[i].np = inputNpy;
+        args[i].st = NULL;
+        hdr        = &inputNpy->hdr;
+
+        if (inputNpy->mapSize >= npyStreamMinBytes)
+        {
+            /* Long replay. Keep resident memory at two chunks whatever the file length. */
+            npyStream_t* inputStream = arenaAlloc(&st->arena, sizeof(npyStream_t));
+
+            npyUnmapData(inputNpy);
+            if (npyStreamOpen(inputIf, inputStream, 0) == -1)
+            {
+                fprintf(stderr, "Could not stream sensor data %s \n", rs->file);
+                return -1;
+            }
+            args[i].st = inputStream;
+            hdr        = &inputStream->hdr;
+        }
 
-    args[0].numSensors = sensConf.imuConf.numImuSensors;
-    args[1].numSensors = sensConf.gnssConf.numGnssSensors;
-    args[2].numSensors = sensConf.strConf.numStrTrk;
+        if ((hdr->rowSize != rowSize[i]) || (hdr->typeChar != 'f'))
+        {
+            fprintf(stderr, "Unexpected row layout in %s \n", rs->file);
+            return -1;
+        }
+        args[i].numRows = hdr->numRows;
+        args[i].row     = 0;
+
+        /* Set up Sockets. Unit u of the redundant set goes to the fdir port + u, or straight to GNC. */
+        for (size_t u = 0; u < args[i].numSensors; u++)
+        {
+            uint16_t port = (cfg->fdir == 1) ? (uint16_t) (rs->fdirPort + u) : rs->gncPort;
+            setIpcAddrPortTransport(&args[i].cfg[u], rig->ipcAddr, port, OUTPUT, cfg->transport);
+        }
+    }
 
-    /* Init File interfaces. */
+    if (initSched(&st->sch, cfg->numWorkers, (cfg->numWorkers > 1), cfg->replayScale) == -1)
+    {
+        return -1;
+    }
     for (size_t i = 0; i < numGncSensorIf; i++)
     {
-        setInterface(&inputIf[i], INPUT, (char *) inFp[i]);
-        args[i].np = npyLoadData(&inputIf[i]);
+        if (addSchedStream(&st->sch, args[i].name, args[i].rate_Hz, (double) args[i].latency_ns * 1e-9, emit[i],
+                           &args[i]) == NULL)
+        {
+            return -1;
+        }
     }
 
-    /* Set up Sockets. */
-    for (size_t i = 0; i < args[0].numSensors; i++)
+    if ((cfg->replayScale == 0.0) || (cfg->replayScale > 1.0))
     {
-        if (fdir == 1)
+        /* Ahead of real time the consumers set the pace, so wait for ring space rather than drop. */
+        for (size_t s = 0; s < numGncSensorIf; s++)
         {
-            /* Set the fdir port. */
-            setIpcAddrPort(&imuMsgConf[i], (char* ) IPCAddr, imuFdirPort + i, OUTPUT);
+            for (size_t i = 0; i < args[s].numSensors; i++)
+            {
+                args[s].cfg[i].blockOnFull = 1;
+            }
         }
-        else
+    }
+    if (cfg->lockstep == 1)
+    {
+        /* 
+         * Downstream stages only drain after this one acknowledged its tick, waiting for space would never
+         * end. A tick must not produce more than a channel holds.
+         */
+        for (size_t s = 0; s < numGncSensorIf; s++)
         {
-            /* Set the gnc port. */
-            setIpcAddrPort(&imuMsgConf[i], (char* ) IPCAddr, ImuIpcPort + i, OUTPUT);
+            for (size_t i = 0; i < args[s].numSensors; i++)
+            {
+                args[s].cfg[i].blockOnFull = 0;
+            }
         }
+        if (joinLockstep(&st->step, lockstepName, stepSensors, lockstepJoinTimeout_ms) == -1)
+        {
+            return -1;
+        }
+        setSchedGate(&st->sch, lockstepGate, &st->step);
     }
-    args[0].cfg = imuMsgConf;
+    return 0;
+}
 
-    for (size_t i = 0; i < args[1].numSensors; i++)
+int startSensStage(sensStage_t* st)
+{
+    st->start_ns = getTimeNs();
+    if (pthread_create(&st->replay, NULL, &replayThread, (void* ) st) != 0)
+    {
+        fprintf(stderr, "Could not start the replay thread \n");
+        return -1;
+    }
+    return 0;
+}
+
+uint64_t runSensStage(sensStage_t* st, schedGate_t gate, void* ctx)
+{
+    for (size_t s = 0; s < numGncSensorIf; s++)
     {
-        if (fdir == 1)
+        for (size_t i = 0; i < st->stream[s].numSensors; i++)
         {
-            setIpcAddrPort(&gnssMsgConf[i], (char* ) IPCAddr, gnssFdirPort + i, OUTPUT);    
+            st->stream[s].cfg[i].blockOnFull = 0;
         }
-        else
+    }
+    setSchedGate(&st->sch, gate, ctx);
+    st->start_ns = getTimeNs();
+    st->numSent  = runSched(&st->sch);
+    st->end_ns   = getTimeNs();
+    atomic_store(&st->done, 1);
+    return st->numSent;
+}
+
+void stopSensStage(sensStage_t* st)
+{
+    stopSched(&st->sch);
+}
+
+int sensStageDone(sensStage_t* st)
+{
+    return atomic_load(&st->done);
+}
+
+uint64_t joinSensStage(sensStage_t* st)
+{
+    pthread_join(st->replay, NULL);
+    return st->numSent;
+}
+
+void printSensStats(sensStage_t* st)
+{
+    printSchedStats(&st->sch);
+    printLatencyTable("Sensor", &st->latency);
+}
+
+void printSensReport(sensStage_t* st)
+{
+    printf("Replayed %lu samples, %.1f s of scenario in %.3f s \n", (unsigned long) st->numSent,
+           (double) st->stream[0].numRows / st->stream[0].rate_Hz, (double) (st->end_ns - st->start_ns) * 1e-9);
+    printSensStats(st);
+    for (size_t i = 0; i < numGncSensorIf; i++)
+    {
+        if (st->stream[i].faults != NULL)
         {
-            setIpcAddrPort(&gnssMsgConf[i], (char* ) IPCAddr, GnssIpcPort + i, OUTPUT);
+            printFaultStats(st->stream[i].name, st->stream[i].faults);
         }
     }
-    args[1].cfg = gnssMsgConf;
+}
 
-    for (size_t i = 0; i < args[2].numSensors; i++)
+void closeSensStage(sensStage_t* st)
+{
+    closeSched(&st->sch);
+    for (size_t i = 0; i < numGncSensorIf; i++)
     {
-        if (fdir == 1)
+        for (unsigned int u = 0; u < st->stream[i].numSensors; u++)
+        {
+            closeIPC(&st->stream[i].cfg[u]);
+        }
+        if (st->stream[i].st != NULL)
         {
-            setIpcAddrPort(&strMsgConf[i], (char* ) IPCAddr, strFdirPort + i, OUTPUT);
+            npyStreamClose(st->stream[i].st);
         }
         else
         {
-            setIpcAddrPort(&strMsgConf[i], (char* ) IPCAddr, StrIpcPort + i, OUTPUT);
+            npyUnmapData(st->stream[i].np);
         }
     }
-    args[2].cfg = strMsgConf;
-
-    setTaskPeriod(args[0].tCfg, 1.0);
-    setTaskPeriod(args[1].tCfg, 0.5);
-    setTaskPeriod(args[2].tCfg, 0.1);
-
-    pthread_create(&imuTask.taskThread, NULL,  &getImuDataNpy, (void* ) &args[0]);
-    pthread_create(&gnssTask.taskThread, NULL, &getGnssDataNpy, (void* ) &args[1]);
-    pthread_create(&strTask.taskThread, NULL,  &getStrDataNpy, (void* ) &args[2]);
-    pthread_join(imuTask.taskThread, NULL);
-    pthread_join(gnssTask.taskThread, NULL);
-    pthread_join(strTask.taskThread, NULL);
+    closeArena(&st->arena);
 }
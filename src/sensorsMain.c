@@ -0,0 +1,99 @@
+// SensorsOut: the sensor replay stage as a process of its own.
+
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sensors.h"
+#include "captureLib.h"
+
+int main(int argc, char* argv[])
+{
+    sensCfg_t   cfg;
+    sensStage_t st;
+    int         opt;
+
+    initSensCfg(&cfg);
+    while ((opt = getopt(argc, argv, "x:j:f:s")) != -1)
+    {
+        switch (opt)
+        {
+            case 'x':
+                cfg.replayScale = atof(optarg);
+                break;
+
+            case 'j':
+                cfg.numWorkers = (unsigned int) atoi(optarg);
+                break;
+
+            case 'f':
+                cfg.faultPath = optarg;
+                break;
+
+            case 's':
+                cfg.lockstep = 1;
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-x speedFactor] [-j numWorkers] [-f faultScript] [-s] [fdir] \n", argv[0]);
+                return -1;
+        }
+    }
+    if ((cfg.replayScale < 0.0) || (cfg.numWorkers == 0) || ((cfg.lockstep == 1) && (cfg.numWorkers > 1)))
+    {
+        fprintf(stderr, "Usage: %s [-x speedFactor] [-j numWorkers] [-f faultScript] [-s] [fdir] \n", argv[0]);
+        return -1;
+    }
+
+    /* FDIR Enable, by any remaining argument. */
+    if (optind < argc)
+    {
+        cfg.fdir = 1;
+    }
+
+    if ((openTelem("SensorsOut") == -1) || (openCapture("SensorsOut") == -1) || (initSensStage(&st, &cfg) == -1))
+    {
+        return -1;
+    }
+
+    /*
+     * Scheduler threads leave signals to the main thread. SIGUSR1 prints statistics, SIGUSR2 marks the end
+     * of the replay and SIGINT or SIGTERM stop it early, still printing the statistics.
+     */
+    sigset_t sigSet;
+
+    sigemptyset(&sigSet);
+    sigaddset(&sigSet, SIGUSR1);
+    sigaddset(&sigSet, SIGUSR2);
+    sigaddset(&sigSet, SIGINT);
+    sigaddset(&sigSet, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+
+    if (startSensStage(&st) == -1)
+    {
+        return -1;
+    }
+    while (sensStageDone(&st) == 0)
+    {
+        struct timespec pollPeriod = {1, 0};
+        int             sig        = sigtimedwait(&sigSet, NULL, &pollPeriod);
+
+        if (sig == SIGUSR1)
+        {
+            printSensStats(&st);
+        }
+        else if ((sig == SIGINT) || (sig == SIGTERM))
+        {
+            stopSensStage(&st);
+        }
+    }
+    joinSensStage(&st);
+    closeTelem();
+    closeCapture();
+
+    printSensReport(&st);
+    printTelemStats();
+    printCaptureStats();
+    closeSensStage(&st);
+    return 0;
+}
@@ -0,0 +1,162 @@
+// TelemDecode: prints a telemetry file written by openTelem, as text or CSV.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "telemLib.h"
+
+/* Records read per fread. */
+#define decodeBatch 256U
+
+/* Per ring: records seen and the next sequence number expected. A gap is records dropped on a full ring. */
+typedef struct
+{
+    uint64_t numRecs;
+    uint64_t numLost;
+    uint32_t nextSeq;
+} decodeRing_t;
+
+telemEventDef_t decodeEvents[telemMaxEvents];
+uint8_t         decodeKnown[telemMaxEvents];
+decodeRing_t    decodeRings[telemMaxRings];
+
+static void printDecodeRec(const telemRec_t* rec, uint64_t start_ns, int csv)
+{
+    double time_s = (double) (int64_t) (rec->time_ns - start_ns) * 1e-9;
+    char   line[256];
+
+    if ((rec->event >= telemMaxEvents) || (decodeKnown[rec->event] == 0))
+    {
+        printf(csv ? "%.9f,%u,%u,%u,,%lu,%lu\n" : "%12.6f [%2u] event %u seq %u args %lu %lu \n", time_s,
+               rec->ring, rec->seq, rec->event, (unsigned long) rec->arg[0], (unsigned long) rec->arg[1]);
+        return;
+    }
+    formatTelemRec(&decodeEvents[rec->event], rec, line, sizeof(line));
+    if (csv)
+    {
+        /* The message is quoted, it may hold commas. */
+        printf("%.9f,%u,%u,%s,\"%s\"\n", time_s, rec->ring, rec->seq, decodeEvents[rec->event].name, line);
+    }
+    else
+    {
+        printf("%12.6f [%2u] %s\n", time_s, rec->ring, line);
+    }
+}
+
+static void countDecodeRec(const telemRec_t* rec)
+{
+    decodeRing_t* r;
+
+    if (rec->ring >= telemMaxRings)
+    {
+        return;
+    }
+    r = &decodeRings[rec->ring];
+    if (rec->seq > r->nextSeq)
+    {
+        r->numLost += rec->seq - r->nextSeq;
+    }
+    r->numRecs++;
+    r->nextSeq = rec->seq + 1;
+}
+
+int main(int argc, char* argv[])
+{
+    telemFileHdr_t hdr;
+    telemChunk_t   chunk;
+    telemRec_t     rec[decodeBatch];
+    FILE*          fp;
+    int            csv = 0;
+    int            opt;
+
+    while ((opt = getopt(argc, argv, "c")) != -1)
+    {
+        if (opt != 'c')
+        {
+            fprintf(stderr, "Usage: %s [-c] file.tlm \n", argv[0]);
+            return -1;
+        }
+        csv = 1;
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "Usage: %s [-c] file.tlm \n", argv[0]);
+        return -1;
+    }
+
+    fp = fopen(argv[optind], "rb");
+    if (fp == NULL)
+    {
+        perror("Telemetry File Open Failed.");
+        return -1;
+    }
+    if ((fread(&hdr, sizeof(hdr), 1, fp) != 1) || (memcmp(hdr.magic, telemMagic, sizeof(hdr.magic)) != 0) ||
+        (hdr.version != telemVersion) || (hdr.recSize != sizeof(telemRec_t)))
+    {
+        fprintf(stderr, "%s is not a version %u telemetry file \n", argv[optind], telemVersion);
+        fclose(fp);
+        return -1;
+    }
+    if (csv)
+    {
+        printf("time_s,ring,seq,event,message\n");
+    }
+
+    while (fread(&chunk, sizeof(chunk), 1, fp) == 1)
+    {
+        if ((chunk.kind == telemChunkEvent) && (chunk.size == sizeof(telemEventDef_t)))
+        {
+            telemEventDef_t def;
+
+            if (fread(&def, sizeof(def), 1, fp) != 1)
+            {
+                break;
+            }
+            def.name[telemNameLen - 1] = '\0';
+            def.fmt[telemFmtLen - 1]   = '\0';
+            if ((def.id < telemMaxEvents) && (checkTelemFmt(def.fmt) != -1))
+            {
+                decodeEvents[def.id] = def;
+                decodeKnown[def.id]  = 1;
+            }
+        }
+        else if ((chunk.kind == telemChunkRecords) && ((chunk.size % sizeof(telemRec_t)) == 0))
+        {
+            size_t left = chunk.size / sizeof(telemRec_t);
+
+            while (left > 0)
+            {
+                size_t num = (left < decodeBatch) ? left : decodeBatch;
+
+                if (fread(rec, sizeof(telemRec_t), num, fp) != num)
+                {
+                    left = 0;
+                    break;
+                }
+                for (size_t i = 0; i < num; i++)
+                {
+                    countDecodeRec(&rec[i]);
+                    printDecodeRec(&rec[i], hdr.start_ns, csv);
+                }
+                left -= num;
+            }
+        }
+        else if (fseek(fp, chunk.size, SEEK_CUR) != 0)
+        {
+            /* Unknown chunk, from a later writer. */
+            break;
+        }
+    }
+    fclose(fp);
+
+    /* Summary on stderr, stdout stays the decoded log. */
+    for (unsigned int i = 0; i < telemMaxRings; i++)
+    {
+        if (decodeRings[i].numRecs > 0)
+        {
+            fprintf(stderr, "Ring %u: %lu records, %lu lost \n", i, (unsigned long) decodeRings[i].numRecs,
+                    (unsigned long) decodeRings[i].numLost);
+        }
+    }
+    return 0;
+}
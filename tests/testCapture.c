@@ -0,0 +1,268 @@
+// Behaviour of the capture file: concurrent writers, overflow, close under writers and a capture never closed.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "captureLib.h"
+#include "testCheck.h"
+
+#define numWriters 4U
+
+/* Payload: the writer and its message number, then bytes derived from both. Lengths vary, so does padding. */
+typedef struct
+{
+    uint32_t writer;
+    uint32_t index;
+} payloadHdr_t;
+
+#define maxPayload (sizeof(payloadHdr_t) + 96U)
+
+typedef struct
+{
+    uint32_t     writer;
+    uint32_t     limit;                             //< Messages to write.
+    uint32_t     numWritten;                        //< Calls made, granted or not.
+    atomic_uint* progress;                          //< Calls made so far, for the closing thread.
+} writerCtx_t;
+
+static char dir[] = "/tmp/testCaptureXXXXXX";
+
+static size_t payloadLen(uint32_t writer, uint32_t index)
+{
+    return sizeof(payloadHdr_t) + ((writer * 31U + index) % 97U);
+}
+
+static void makePayload(uint32_t writer, uint32_t index, uint8_t* buf)
+{
+    payloadHdr_t h = {writer, index};
+
+    memcpy(buf, &h, sizeof(h));
+    for (size_t k = sizeof(h); k < payloadLen(writer, index); k++)
+    {
+        buf[k] = (uint8_t) (writer + index + k);
+    }
+}
+
+/* Writes until its limit, or until the capture closes under it. */
+static void* writerThread(void* arg)
+{
+    writerCtx_t* c = (writerCtx_t *) arg;
+    uint8_t      buf[maxPayload];
+
+    for (uint32_t i = 0; (i < c->limit) && (atomic_load(&captureActive) != 0); i++)
+    {
+        makePayload(c->writer, i, buf);
+        captureWrite((uint16_t) (1000U + c->writer), captureSend, 0, buf, payloadLen(c->writer, i));
+        c->numWritten++;
+        atomic_fetch_add(c->progress, 1);
+    }
+    return NULL;
+}
+
+static void openAt(const char* app, const char* mb, char* path, size_t size)
+{
+    setenv("TEC_CAPTURE_DIR", dir, 1);
+    setenv("TEC_CAPTURE_MB", mb, 1);
+    testCheck(openCapture(app) == 0);
+    testCheck(atomic_load(&captureActive) == 1);
+    snprintf(path, size, "%s/%s.cap", dir, app);
+}
+
+/*
+ * Every record is one granted message, whole and in its writer's order. The granted messages of a writer are
+ * its first ones, got[w] of them. Returns the records, and their bytes in bytes.
+ */
+static unsigned int readBack(const captureMap_t* map, uint32_t* got, size_t* bytes)
+{
+    const captureRec_t* rec      = NULL;
+    unsigned int        numRecs  = 0;
+    unsigned int        numWrong = 0;
+
+    memset(got, 0, numWriters * sizeof(got[0]));
+    *bytes = 0;
+    while ((rec = nextCaptureRec(map, rec)) != NULL)
+    {
+        payloadHdr_t h;
+        uint8_t      want[maxPayload];
+
+        memcpy(&h, captureRecData(rec), sizeof(h));
+        if ((rec->len < sizeof(h)) || (h.writer >= numWriters) || (rec->port != 1000U + h.writer))
+        {
+            numWrong++;
+            break;
+        }
+        makePayload(h.writer, h.index, want);
+        numWrong += (h.index != got[h.writer]);
+        numWrong += (rec->len != payloadLen(h.writer, h.index));
+        numWrong += (memcmp(captureRecData(rec), want, rec->len) != 0);
+        numWrong += (rec->dir != captureSend) || ((rec->size & 7U) != 0);
+        got[h.writer] = h.index + 1;
+        *bytes       += rec->size;
+        numRecs++;
+    }
+    testCheck(numWrong == 0);
+    return numRecs;
+}
+
+static void runWriters(writerCtx_t* ctx, pthread_t* thr, atomic_uint* progress, uint32_t limit)
+{
+    for (uint32_t w = 0; w < numWriters; w++)
+    {
+        ctx[w] = (writerCtx_t) {.writer = w, .limit = limit, .progress = progress};
+        testCheck(pthread_create(&thr[w], NULL, writerThread, &ctx[w]) == 0);
+    }
+}
+
+/* Far more messages than the file holds. The granted ones are all read back, the rest counted as dropped. */
+static void testOverflow(void)
+{
+    char         path[sizeof(dir) + 32];
+    writerCtx_t  ctx[numWriters];
+    pthread_t    thr[numWriters];
+    atomic_uint  progress = 0;
+    captureMap_t map;
+    uint32_t     got[numWriters];
+    size_t       bytes;
+    unsigned int numAttempts = 0;
+    unsigned int numGot      = 0;
+    unsigned int numRecs;
+
+    openAt("overflow", "1", path, sizeof(path));
+    runWriters(ctx, thr, &progress, 20000);
+    for (uint32_t w = 0; w < numWriters; w++)
+    {
+        pthread_join(thr[w], NULL);
+        numAttempts += ctx[w].numWritten;
+    }
+    closeCapture();
+    testCheck(atomic_load(&captureActive) == 0);
+
+    testCheck(mapCapture(path, &map) == 0);
+    if (map.base == NULL)
+    {
+        return;
+    }
+    testCheck(map.hdr->dataBytes == (1U << 20));
+    testCheck(map.size == captureDataOffset + map.hdr->dataBytes);
+    numRecs = readBack(&map, got, &bytes);
+    for (uint32_t w = 0; w < numWriters; w++)
+    {
+        numGot += got[w];
+    }
+    testCheck(numAttempts == numWriters * 20000U);
+    testCheck(map.hdr->numDropped > 0);
+    testCheck(numRecs + map.hdr->numDropped == numAttempts);
+    testCheck(numGot == numRecs);
+    testCheck(bytes + sizeof(captureRec_t) + maxPayload > map.dataBytes);
+
+    /* Where the next record would be, the overflowing writer left an end mark if its header fitted. */
+    if (bytes + sizeof(captureRec_t) <= map.dataBytes)
+    {
+        const captureRec_t* end = (const captureRec_t *) ((const uint8_t *) map.base + captureDataOffset + bytes);
+
+        testCheck(atomic_load(&end->size) == UINT32_MAX);
+    }
+    unmapCapture(&map);
+    unlink(path);
+
+    /* Closed, writes go nowhere and the file is not touched. */
+    captureWrite(1, captureRecv, 0, "x", 1);
+    captureMsg(1, captureRecv, 0, "x", 1);
+}
+
+/* Closed while the writers run. Close waits for the ones copying, every reserved byte is a whole record. */
+static void testCloseUnderWriters(void)
+{
+    char         path[sizeof(dir) + 32];
+    writerCtx_t  ctx[numWriters];
+    pthread_t    thr[numWriters];
+    atomic_uint  progress = 0;
+    captureMap_t map;
+    uint32_t     got[numWriters];
+    size_t       bytes;
+    unsigned int numRecs;
+
+    openAt("closing", "16", path, sizeof(path));
+    runWriters(ctx, thr, &progress, 40000);
+    while (atomic_load(&progress) < numWriters * 2000U)
+    {
+        sched_yield();
+    }
+    closeCapture();
+    for (uint32_t w = 0; w < numWriters; w++)
+    {
+        pthread_join(thr[w], NULL);
+    }
+
+    testCheck(mapCapture(path, &map) == 0);
+    if (map.base == NULL)
+    {
+        return;
+    }
+    testCheck(map.hdr->numDropped == 0);
+    testCheck(map.dataBytes == map.hdr->dataBytes);
+    numRecs = readBack(&map, got, &bytes);
+    testCheck(bytes == map.dataBytes);
+    for (uint32_t w = 0; w < numWriters; w++)
+    {
+        /* A writer that saw the capture open may have been refused on its last call. */
+        testCheck((got[w] == ctx[w].numWritten) || (got[w] + 1U == ctx[w].numWritten));
+    }
+    printf("%u of %u messages captured when closed \n", numRecs, numWriters * 40000U);
+    unmapCapture(&map);
+    unlink(path);
+}
+
+/* A capture read while still open, as after a crash: the records up to the first unwritten one. */
+static void testNeverClosed(void)
+{
+    char         path[sizeof(dir) + 32];
+    uint8_t      buf[maxPayload];
+    captureMap_t map;
+    uint32_t     got[numWriters];
+    size_t       bytes;
+
+    openAt("open", "1", path, sizeof(path));
+    for (uint32_t i = 0; i < 50; i++)
+    {
+        makePayload(2, i, buf);
+        captureWrite(1002, captureSend, 0, buf, payloadLen(2, i));
+    }
+    testCheck(mapCapture(path, &map) == 0);
+    if (map.base != NULL)
+    {
+        testCheck(map.hdr->dataBytes == 0);
+        testCheck(map.dataBytes == (1U << 20));
+        testCheck(readBack(&map, got, &bytes) == 50);
+        testCheck(got[2] == 50);
+        testCheck(bytes < map.dataBytes);
+        unmapCapture(&map);
+    }
+    closeCapture();
+    unlink(path);
+
+    /* Not a capture. */
+    snprintf(path, sizeof(path), "%s/short.cap", dir);
+    {
+        FILE* fp = fopen(path, "w");
+
+        fprintf(fp, "short");
+        fclose(fp);
+    }
+    testCheck(mapCapture(path, &map) == -1);
+    unlink(path);
+}
+
+int main(void)
+{
+    testCheck(mkdtemp(dir) != NULL);
+    testOverflow();
+    testCloseUnderWriters();
+    testNeverClosed();
+    rmdir(dir);
+    return testDone("captureLib");
+}
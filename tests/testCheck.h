@@ -0,0 +1,44 @@
+// Checks for the library tests. A failed check prints where it is and the test exits non-zero from testDone.
+#ifndef __TESTS_TESTCHECK_H_
+#define __TESTS_TESTCHECK_H_
+
+#include <math.h>
+#include <stdio.h>
+
+static unsigned int testNumChecks   = 0;
+static unsigned int testNumFailures = 0;
+
+#define testCheck(cond)                                                                      \
+    do                                                                                       \
+    {                                                                                        \
+        testNumChecks++;                                                                     \
+        if (!(cond))                                                                         \
+        {                                                                                    \
+            fprintf(stderr, "%s:%d: check failed: %s \n", __FILE__, __LINE__, #cond);        \
+            testNumFailures++;                                                               \
+        }                                                                                    \
+    } while (0)
+
+/* |a - b| within tol, values printed on failure. */
+#define testNear(a, b, tol)                                                                  \
+    do                                                                                       \
+    {                                                                                        \
+        double testA = (a);                                                                  \
+        double testB = (b);                                                                  \
+        testNumChecks++;                                                                     \
+        if (!(fabs(testA - testB) <= (tol)))                                                 \
+        {                                                                                    \
+            fprintf(stderr, "%s:%d: %s = %.9g, expected %s = %.9g \n", __FILE__, __LINE__,   \
+                    #a, testA, #b, testB);                                                   \
+            testNumFailures++;                                                               \
+        }                                                                                    \
+    } while (0)
+
+/* Summary line, and the exit code of the test. */
+static inline int testDone(const char* name)
+{
+    printf("%s: %u checks, %u failed \n", name, testNumChecks, testNumFailures);
+    return (testNumFailures == 0) ? 0 : 1;
+}
+
+#endif  // __TESTS_TESTCHECK_H_
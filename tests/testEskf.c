@@ -0,0 +1,147 @@
+// Behaviour of the error state Kalman filter: a block update against the scalar filter worked by hand, the gate.
+
+#include <math.h>
+
+#include "eskfLib.h"
+#include "testCheck.h"
+
+/* Position 2 m, velocity 1 m/s, the rest small. Gate at 3 sigma. */
+static const eskfCfg_t cfg = {
+    .accNoise     = 1e-3,
+    .gyroNoise    = 1e-4,
+    .accBiasWalk  = 1e-5,
+    .gyroBiasWalk = 1e-6,
+    .initSigma    = {2.0, 1.0, 1e-3, 1e-3, 1e-4},
+    .gateSigma    = 3.0,
+};
+
+static eskf_t     kf;
+static navState_t nav;
+
+static void reset(void)
+{
+    initEskf(&kf, &cfg);
+    initNavState(&nav, (vec3_t) {{7.0e6, 0.0, 0.0}}, (vec3_t) {{0.0, 7.5e3, 0.0}}, (quat_t) {{1.0, 0.0, 0.0, 0.0}}, 0);
+}
+
+/*
+ * One position axis, P = 4, R = 1, innovation 5, with a pos vel covariance of 1 on that axis:
+ *   S = 5, K = [4 1]' / 5, dx = K 5 = [4 1]', P' = P - K H P.
+ */
+static void testScalarUpdate(void)
+{
+    const double y = 5.0;
+    const double r = 1.0;
+
+    reset();
+    kf.P[eskfPos][eskfVel] = 1.0;
+    kf.P[eskfVel][eskfPos] = 1.0;
+    testCheck(eskfUpdateBlock(&kf, &nav, eskfPos, 1, &y, &r) == 0);
+
+    testNear(nav.pos_m.v[0], 7.0e6 + 4.0, 1e-9);
+    testNear(nav.vel_m_s.v[0], 1.0, 1e-12);
+    testNear(kf.P[eskfPos][eskfPos], 4.0 - 4.0 * 4.0 / 5.0, 1e-12);
+    testNear(kf.P[eskfPos][eskfVel], 1.0 - 4.0 * 1.0 / 5.0, 1e-12);
+    testNear(kf.P[eskfVel][eskfPos], kf.P[eskfPos][eskfVel], 0.0);
+    testNear(kf.P[eskfVel][eskfVel], 1.0 - 1.0 * 1.0 / 5.0, 1e-12);
+
+    /* Other axes and blocks uncorrelated, untouched. */
+    testNear(nav.pos_m.v[1], 0.0, 0.0);
+    testNear(nav.vel_m_s.v[1], 7.5e3, 0.0);
+    testNear(kf.P[eskfPos + 1][eskfPos + 1], 4.0, 0.0);
+    testNear(kf.accBias.v[0], 0.0, 0.0);
+    testCheck(kf.numUpdates == 1);
+}
+
+/* Three axes at once equal three scalar updates when the axes are uncorrelated. */
+static void testBlockUpdate(void)
+{
+    const double y[3] = {1.0, -2.0, 0.5};
+    const double r[3] = {1.0, 4.0, 0.25};
+
+    reset();
+    testCheck(eskfUpdateBlock(&kf, &nav, eskfPos, 3, y, r) == 0);
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        double k = 4.0 / (4.0 + r[i]);
+
+        testNear(nav.pos_m.v[i] - ((i == 0) ? 7.0e6 : 0.0), k * y[i], 1e-9);
+        testNear(kf.P[eskfPos + i][eskfPos + i], (1.0 - k) * 4.0, 1e-12);
+    }
+}
+
+/* An innovation past the gate, on NIS y^2 / S, is rejected and changes nothing. */
+static void testGate(void)
+{
+    const double y    = 3.0 * sqrt(5.0) + 0.01;
+    const double r    = 1.0;
+    const double bad  = -1.0;
+    double       pPos;
+
+    reset();
+    pPos = kf.P[eskfPos][eskfPos];
+    testCheck(eskfUpdateBlock(&kf, &nav, eskfPos, 1, &y, &r) == -1);
+    testNear(nav.pos_m.v[0], 7.0e6, 0.0);
+    testNear(kf.P[eskfPos][eskfPos], pPos, 0.0);
+    testCheck(kf.numRejected == 1);
+    testCheck(kf.numUpdates == 0);
+
+    /* Just inside passes. */
+    {
+        const double yIn = 3.0 * sqrt(5.0) - 0.01;
+
+        testCheck(eskfUpdateBlock(&kf, &nav, eskfPos, 1, &yIn, &r) == 0);
+    }
+
+    /* A covariance that is not positive definite, and blocks outside the state. */
+    reset();
+    kf.P[eskfPos][eskfPos] = 0.0;
+    testCheck(eskfUpdateBlock(&kf, &nav, eskfPos, 1, &y, &bad) == -1);
+    testCheck(eskfUpdateBlock(&kf, &nav, eskfGyroB + 1, 3, &y, &r) == -1);
+    testCheck(eskfUpdateBlock(&kf, &nav, eskfPos, eskfMaxMeas + 1, &y, &r) == -1);
+}
+
+/* Bias estimates come off the increments, scaled by the step. */
+static void testCorrectImu(void)
+{
+    vec3_t dTheta = {{1e-3, 0.0, 0.0}};
+    vec3_t dVel   = {{0.0, 1e-2, 0.0}};
+
+    reset();
+    kf.gyroBias = (vec3_t) {{1e-2, 0.0, 0.0}};
+    kf.accBias  = (vec3_t) {{0.0, 0.5, 0.0}};
+    eskfCorrectImu(&kf, &dTheta, &dVel, 0.01);
+    testNear(dTheta.v[0], 1e-3 - 1e-4, 1e-15);
+    testNear(dVel.v[1], 1e-2 - 5e-3, 1e-15);
+}
+
+/* Propagation grows the position uncertainty by the velocity one over the step and stays symmetric. */
+static void testPropagate(void)
+{
+    const double dt = 0.01;
+
+    reset();
+    eskfPropagate(&kf, &nav, (vec3_t) {{0.0, 0.0, 0.0}}, dt);
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        testNear(kf.P[eskfPos + i][eskfVel + i], dt * 1.0, 1e-6);
+        testCheck(kf.P[eskfPos + i][eskfPos + i] > 4.0);
+    }
+    for (unsigned int i = 0; i < eskfNumStates; i++)
+    {
+        for (unsigned int j = 0; j < eskfNumStates; j++)
+        {
+            testNear(kf.P[i][j], kf.P[j][i], 0.0);
+        }
+    }
+}
+
+int main(void)
+{
+    testScalarUpdate();
+    testBlockUpdate();
+    testGate();
+    testCorrectImu();
+    testPropagate();
+    return testDone("eskfLib");
+}
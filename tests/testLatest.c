@@ -0,0 +1,188 @@
+// Behaviour of the latest sample table: generations, sizes, whole samples under a concurrent writer, reset and unlink.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "latestLib.h"
+#include "testCheck.h"
+
+/* Publications by the writer thread of the concurrent test. */
+#define numPublish 200000U
+
+/* Every word of a sample carries its publication number, so a torn copy mixes two numbers. */
+typedef struct
+{
+    uint64_t word[latestSlotWords];
+} sample_t;
+
+static latestTable_t* tab;
+static atomic_int     writerDone = 0;
+
+static void fillSample(sample_t* s, uint64_t k)
+{
+    for (unsigned int i = 0; i < latestSlotWords; i++)
+    {
+        s->word[i] = k;
+    }
+}
+
+static void testSingle(void)
+{
+    uint8_t  big[latestSlotBytes + 1U] = {0};
+    sample_t in;
+    sample_t out;
+
+    /* Nothing published, data untouched. */
+    fillSample(&out, 7);
+    testCheck(readLatest(tab, 0, &out, sizeof(out)) == 0);
+    testCheck(out.word[0] == 7);
+
+    fillSample(&in, 1);
+    testCheck(publishLatest(tab, 0, &in, sizeof(in)) == 0);
+    testCheck(readLatest(tab, 0, &out, sizeof(out)) == 1);
+    testCheck(memcmp(&in, &out, sizeof(in)) == 0);
+
+    /* Each publication counts, a read only sees the newest. */
+    fillSample(&in, 2);
+    publishLatest(tab, 0, &in, sizeof(in));
+    fillSample(&in, 3);
+    publishLatest(tab, 0, &in, sizeof(in));
+    testCheck(readLatest(tab, 0, &out, sizeof(out)) == 3);
+    testCheck(out.word[latestSlotWords - 1U] == 3);
+
+    /* A shorter sample, not a multiple of a word, and a shorter read. */
+    {
+        const char msg[]  = "abcdefghijk";
+        char       buf[4] = {0};
+        char       all[sizeof(msg)];
+
+        testCheck(publishLatest(tab, 1, msg, sizeof(msg)) == 0);
+        testCheck(readLatest(tab, 1, buf, 3) == 1);
+        testCheck(memcmp(buf, "abc", 3) == 0);
+        testCheck(buf[3] == 0);
+        testCheck(readLatest(tab, 1, all, sizeof(all)) == 1);
+        testCheck(strcmp(all, msg) == 0);
+    }
+
+    /* Slots are independent, out of range slots and oversized samples are refused. */
+    testCheck(readLatest(tab, 2, &out, sizeof(out)) == 0);
+    testCheck(publishLatest(tab, latestMaxSlots, &in, sizeof(in)) == -1);
+    testCheck(readLatest(tab, latestMaxSlots, &out, sizeof(out)) == 0);
+    testCheck(publishLatest(tab, 2, big, sizeof(big)) == -1);
+}
+
+static void* writerThread(void* arg)
+{
+    sample_t s;
+
+    (void) arg;
+    for (uint64_t k = 1; k <= numPublish; k++)
+    {
+        fillSample(&s, k);
+        publishLatest(tab, 3, &s, sizeof(s));
+    }
+    atomic_store(&writerDone, 1);
+    return NULL;
+}
+
+/* Whatever the interleaving, a read is one whole publication, and generations never go back. */
+static void testConcurrent(void)
+{
+    pthread_t    writer;
+    sample_t     s;
+    uint32_t     lastGen  = 0;
+    unsigned int numTorn  = 0;
+    unsigned int numBack  = 0;
+    unsigned int numReads = 0;
+
+    testCheck(pthread_create(&writer, NULL, writerThread, NULL) == 0);
+    while (atomic_load(&writerDone) == 0)
+    {
+        uint32_t gen = readLatest(tab, 3, &s, sizeof(s));
+
+        if (gen == 0)
+        {
+            continue;
+        }
+        numReads++;
+        for (unsigned int i = 1; i < latestSlotWords; i++)
+        {
+            numTorn += (s.word[i] != s.word[0]);
+        }
+        /* The writer publishes number k as generation k. */
+        numTorn += (s.word[0] != gen);
+        numBack += (gen < lastGen);
+        lastGen  = gen;
+    }
+    pthread_join(writer, NULL);
+    testCheck(numTorn == 0);
+    testCheck(numBack == 0);
+    testCheck(readLatest(tab, 3, &s, sizeof(s)) == numPublish);
+    testCheck(s.word[0] == numPublish);
+    printf("%u reads during %u publications \n", numReads, numPublish);
+}
+
+/* A named table is shared by every mapping and outlives them, until the writer resets or unlinks it. */
+static void testNamed(void)
+{
+    char           name[32];
+    latestTable_t* writer;
+    latestTable_t* reader;
+    sample_t       s;
+
+    snprintf(name, sizeof(name), "/tecLatestTest%d", (int) getpid());
+    writer = openLatestTable(name);
+    reader = openLatestTable(name);
+    testCheck((writer != NULL) && (reader != NULL));
+    if ((writer == NULL) || (reader == NULL))
+    {
+        return;
+    }
+    fillSample(&s, 5);
+    publishLatest(writer, 0, &s, sizeof(s));
+    publishLatest(writer, 0, &s, sizeof(s));
+    testCheck(readLatest(reader, 0, &s, sizeof(s)) == 2);
+
+    /* Closed without an unlink, as a crashed run leaves it. The next run opens the old samples. */
+    closeLatestTable(writer, name);
+    closeLatestTable(reader, name);
+    writer = openLatestTable(name);
+    reader = openLatestTable(name);
+    testCheck(readLatest(reader, 0, &s, sizeof(s)) == 2);
+
+    /* The writer's reset clears them for a reader that opened first, generations start again. */
+    resetLatestTable(writer);
+    fillSample(&s, 9);
+    testCheck(readLatest(reader, 0, &s, sizeof(s)) == 0);
+    testCheck(s.word[0] == 9);
+    publishLatest(writer, 0, &s, sizeof(s));
+    testCheck(readLatest(reader, 0, &s, sizeof(s)) == 1);
+
+    /* Unlinked, the next open is a new zeroed segment. The old mappings keep working. */
+    unlinkLatestTable(name);
+    closeLatestTable(writer, name);
+    writer = openLatestTable(name);
+    testCheck(readLatest(writer, 0, &s, sizeof(s)) == 0);
+    testCheck(readLatest(reader, 0, &s, sizeof(s)) == 1);
+    unlinkLatestTable(name);
+    closeLatestTable(writer, name);
+    closeLatestTable(reader, name);
+}
+
+int main(void)
+{
+    tab = openLatestTable(NULL);
+    testCheck(tab != NULL);
+    if (tab == NULL)
+    {
+        return testDone("latestLib");
+    }
+    testSingle();
+    testConcurrent();
+    closeLatestTable(tab, NULL);
+    testNamed();
+    return testDone("latestLib");
+}
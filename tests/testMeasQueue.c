@@ -0,0 +1,154 @@
+// Behaviour of the measurement queue: time order whatever the arrival order, eviction, refusal and trimming.
+
+#include <stdint.h>
+
+#include "measQueueLib.h"
+#include "testCheck.h"
+
+#define capacity 16U
+
+typedef struct
+{
+    uint64_t time_ns;
+    uint32_t arrival;                               //< Order of the push, ties keep it.
+} item_t;
+
+static uint64_t    mem[capacity * (1U + sizeof(item_t) / sizeof(uint64_t))];
+static measQueue_t q;
+
+static uint64_t testRng = 1;
+
+/* splitmix64. */
+static uint64_t testNext(void)
+{
+    uint64_t z = (testRng += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void push(uint64_t time_ns, uint32_t arrival, uint64_t evict_ns, int expect)
+{
+    item_t it = {time_ns, arrival};
+
+    testCheck(pushMeas(&q, time_ns, &it, evict_ns) == expect);
+}
+
+/* Entries are sorted by time, ties in arrival order, and each item sits with its own timestamp. */
+static int inOrder(void)
+{
+    for (unsigned int i = 0; i < q.count; i++)
+    {
+        const item_t* it = measItem(&q, i);
+
+        if (it->time_ns != measTime(&q, i))
+        {
+            return 0;
+        }
+        if ((i > 0) && ((measTime(&q, i - 1) > it->time_ns) ||
+                        ((measTime(&q, i - 1) == it->time_ns) &&
+                         (((const item_t *) measItem(&q, i - 1))->arrival > it->arrival))))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Jittered arrivals through many ring wraps, trimmed behind a moving state time as the filter does. */
+static void testOrder(void)
+{
+    uint64_t state_ns = 0;
+    uint64_t trim_ns;
+    uint32_t arrival  = 0;
+
+    testCheck(initMeasQueue(&q, mem, capacity, sizeof(item_t)) == 0);
+    for (unsigned int step = 0; step < 2000; step++)
+    {
+        /* Times around the state, some late, few enough to stay in the queue. */
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            uint64_t t = state_ns + (testNext() % 40U);
+
+            push((t > 20) ? t - 20 : t, arrival++, 0, 0);
+        }
+        testCheck(inOrder());
+        state_ns += 10;
+        trim_ns   = (state_ns > 30) ? state_ns - 30 : 0;
+        trimMeas(&q, trim_ns);
+        testCheck((q.count == 0) || (measTime(&q, 0) > trim_ns));
+    }
+    testCheck(q.numEvicted == 0);
+    testCheck(q.numRefused == 0);
+
+    /* Equal times keep their arrival order. */
+    testCheck(initMeasQueue(&q, mem, capacity, sizeof(item_t)) == 0);
+    push(5, 0, 0, 0);
+    push(3, 1, 0, 0);
+    push(5, 2, 0, 0);
+    push(3, 3, 0, 0);
+    testCheck(inOrder());
+    testCheck(((const item_t *) measItem(&q, 1))->arrival == 3);
+    testCheck(((const item_t *) measItem(&q, 3))->arrival == 2);
+}
+
+/* A full queue gives up its oldest only if that is at or before evict_ns. */
+static void testEvict(void)
+{
+    testCheck(initMeasQueue(&q, mem, capacity, sizeof(item_t)) == 0);
+    for (unsigned int i = 0; i < capacity; i++)
+    {
+        push(100 + 10 * i, i, 0, 0);
+    }
+    /* Oldest at 100 is still ahead of the state at 99, kept, the new one refused. */
+    push(1000, capacity, 99, -1);
+    testCheck(q.numRefused == 1);
+    testCheck(q.count == capacity);
+    testCheck(measTime(&q, 0) == 100);
+
+    /* The state passed it, it makes room. */
+    push(1000, capacity, 100, 0);
+    testCheck(q.numEvicted == 1);
+    testCheck(q.count == capacity);
+    testCheck(measTime(&q, 0) == 110);
+    testCheck(measTime(&q, capacity - 1U) == 1000);
+
+    /* A late one in the middle of a full, wrapped ring. */
+    push(155, capacity + 1U, 110, 0);
+    testCheck(inOrder());
+    testCheck(measTime(&q, 0) == 120);
+    testCheck(measTime(&q, 4) == 155);
+}
+
+/* What a rewind to t replays: the entries after t, in order. Trimming drops up to and including t. */
+static void testFindTrim(void)
+{
+    testCheck(initMeasQueue(&q, mem, capacity, sizeof(item_t)) == 0);
+    testCheck(findMeasAfter(&q, 0) == 0);
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        push(10 * (i + 1), i, 0, 0);
+    }
+    testCheck(findMeasAfter(&q, 0) == 0);
+    testCheck(findMeasAfter(&q, 30) == 3);
+    testCheck(findMeasAfter(&q, 35) == 3);
+    testCheck(findMeasAfter(&q, 80) == 8);
+
+    trimMeas(&q, 30);
+    testCheck(q.count == 5);
+    testCheck(measTime(&q, 0) == 40);
+    trimMeas(&q, 1000);
+    testCheck(q.count == 0);
+    testCheck(initMeasQueue(&q, mem, 0, sizeof(item_t)) == -1);
+    testCheck(initMeasQueue(&q, NULL, capacity, sizeof(item_t)) == -1);
+}
+
+int main(void)
+{
+    testCheck(measQueueBytes(capacity, sizeof(item_t)) <= sizeof(mem));
+    testOrder();
+    testEvict();
+    testFindTrim();
+    return testDone("measQueueLib");
+}
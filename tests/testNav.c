@@ -0,0 +1,151 @@
+// Behaviour of the strapdown step: coning, rotation and sculling corrections against closed form motions.
+
+#include <math.h>
+#include <stdio.h>
+
+#include "navLib.h"
+#include "testCheck.h"
+
+/* IMU at 100 Hz, no gravity so the specific force is the whole acceleration. */
+#define dt         0.01
+#define numPeriods 20U
+
+/* Angle of the rotation between two attitudes. */
+static double attErr(quat_t a, quat_t b)
+{
+    double d = fabs(a.q[0] * b.q[0] + a.q[1] * b.q[1] + a.q[2] * b.q[2] + a.q[3] * b.q[3]);
+
+    return 2.0 * acos((d > 1.0) ? 1.0 : d);
+}
+
+/* The previous increments cleared before each step, which leaves out the coning and sculling corrections. */
+static void step(navState_t* nav, vec3_t dTheta, vec3_t dVel, int plain)
+{
+    if (plain)
+    {
+        nav->prevDTheta = (vec3_t) {{0.0, 0.0, 0.0}};
+        nav->prevDVel   = nav->prevDTheta;
+    }
+    navPropagate(nav, dTheta, dVel, dt);
+}
+
+/* Away from the centre, where the point mass gravity is 0 / 0 even with mu 0. */
+static const vec3_t pos0 = {{7.0e6, 0.0, 0.0}};
+
+static void startAt(navState_t* nav, quat_t q)
+{
+    initNavState(nav, pos0, (vec3_t) {{0.0, 0.0, 0.0}}, q, 0);
+    nav->mu_m3_s2 = 0.0;
+}
+
+/*
+ * Coning: a rotation by beta about an axis turning at w in the xy plane, q(t) = [cos b/2, sin b/2 (cos wt,
+ * sin wt, 0)]. The body rate (-w sin b sin wt, w sin b cos wt, w (cos b - 1)) integrates in closed form. Summed
+ * rates alone drift about z, the coning correction removes most of it.
+ */
+static double runConing(int plain)
+{
+    const double beta = 0.05;
+    const double w    = 2.0 * M_PI * 2.0;
+    unsigned int n    = (unsigned int) lround(numPeriods / 2.0 / dt);
+    navState_t   nav;
+    double       t1   = n * dt;
+
+    startAt(&nav, (quat_t) {{cos(0.5 * beta), sin(0.5 * beta), 0.0, 0.0}});
+    for (unsigned int k = 0; k < n; k++)
+    {
+        double a = w * k * dt;
+        double b = w * (k + 1) * dt;
+        vec3_t dTheta = {{sin(beta) * (cos(b) - cos(a)), sin(beta) * (sin(b) - sin(a)),
+                           (cos(beta) - 1.0) * (b - a)}};
+
+        step(&nav, dTheta, (vec3_t) {{0.0, 0.0, 0.0}}, plain);
+    }
+    return attErr(nav.q_ib,
+                  (quat_t) {{cos(0.5 * beta), sin(0.5 * beta) * cos(w * t1), sin(0.5 * beta) * sin(w * t1), 0.0}});
+}
+
+/*
+ * Constant rate w about z and constant body specific force f = (fx, 0, fz). The inertial force turns with the
+ * body, v(T) = (fx sin wT / w, fx (1 - cos wT) / w, fz T). The increments are constant, so the sculling terms
+ * cancel and the rotation of the velocity increment does the work.
+ */
+static void testRotation(void)
+{
+    const double w  = 0.5;
+    const double fx = 2.0;
+    const double fz = -1.0;
+    unsigned int n  = 1000;
+    double       t  = n * dt;
+    navState_t   nav;
+
+    startAt(&nav, (quat_t) {{1.0, 0.0, 0.0, 0.0}});
+    for (unsigned int k = 0; k < n; k++)
+    {
+        step(&nav, (vec3_t) {{0.0, 0.0, w * dt}}, (vec3_t) {{fx * dt, 0.0, fz * dt}}, 0);
+    }
+    /* Second order in w dt per step, some 1e-5 m/s after 10 s. */
+    testNear(nav.vel_m_s.v[0], fx * sin(w * t) / w, 1e-4);
+    testNear(nav.vel_m_s.v[1], fx * (1.0 - cos(w * t)) / w, 1e-4);
+    testNear(nav.vel_m_s.v[2], fz * t, 1e-12);
+    testNear(nav.pos_m.v[0] - pos0.v[0], fx * (1.0 - cos(w * t)) / (w * w), 1e-3);
+    testNear(nav.pos_m.v[1], fx * (t / w - sin(w * t) / (w * w)), 1e-3);
+    testNear(attErr(nav.q_ib, (quat_t) {{cos(0.5 * w * t), 0.0, 0.0, sin(0.5 * w * t)}}), 0.0, 1e-12);
+}
+
+/*
+ * Sculling: roll angle p sin wt with specific force along body y of A sin wt, in phase. Over whole periods the
+ * force rectifies along z, vz = A J1(p) T, while vx and vy come back to 0. The rotation term alone misses part
+ * of it, the sculling correction recovers it.
+ */
+static double runSculling(int plain, vec3_t* vel)
+{
+    const double p = 0.05;
+    const double A = 5.0;
+    const double w = 2.0 * M_PI * 2.0;
+    unsigned int n = (unsigned int) lround(numPeriods / 2.0 / dt);
+    double       t = n * dt;
+    navState_t   nav;
+
+    startAt(&nav, (quat_t) {{1.0, 0.0, 0.0, 0.0}});
+    for (unsigned int k = 0; k < n; k++)
+    {
+        double a = w * k * dt;
+        double b = w * (k + 1) * dt;
+
+        step(&nav, (vec3_t) {{p * (sin(b) - sin(a)), 0.0, 0.0}}, (vec3_t) {{0.0, A * (cos(a) - cos(b)) / w, 0.0}},
+             plain);
+    }
+    *vel = nav.vel_m_s;
+    return fabs(nav.vel_m_s.v[2] - A * j1(p) * t);
+}
+
+/* Both corrections take the error of the plain step down by two orders of magnitude. */
+static void testConingSculling(void)
+{
+    double coning        = runConing(0);
+    double coningPlain   = runConing(1);
+    vec3_t vel;
+    vec3_t velPlain;
+    double sculling      = runSculling(0, &vel);
+    double scullingPlain = runSculling(1, &velPlain);
+
+    printf("coning: %.3g rad, %.3g without the correction. sculling: %.3g m/s, %.3g without \n", coning,
+           coningPlain, sculling, scullingPlain);
+    testCheck(coning < 1e-5);
+    testCheck(coningPlain > 100.0 * coning);
+    testCheck(sculling < 1e-4);
+    testCheck(scullingPlain > 100.0 * sculling);
+    testNear(vel.v[0], 0.0, 1e-9);
+    testNear(vel.v[1], 0.0, 1e-9);
+
+    /* What is rectified is not small next to the errors. */
+    testCheck(vel.v[2] > 1.0);
+}
+
+int main(void)
+{
+    testRotation();
+    testConingSculling();
+    return testDone("navLib");
+}
@@ -0,0 +1,126 @@
+// Behaviour of the navigation filter: a late measurement replays to the state it would have given on time.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "navFilterLib.h"
+#include "testCheck.h"
+
+#define histDepth 32U
+#define measLen   8U
+
+/* IMU at 100 Hz. */
+#define imuPeriod_ns 10000000ULL
+
+static const eskfCfg_t kfCfg = {
+    .accNoise     = 1e-3,
+    .gyroNoise    = 1e-4,
+    .accBiasWalk  = 1e-5,
+    .gyroBiasWalk = 1e-6,
+    .initSigma    = {10.0, 0.1, 1e-3, 1e-3, 1e-4},
+    .gateSigma    = 5.0,
+};
+
+static const navFilterCfg_t cfg = {
+    .kf               = &kfCfg,
+    .gnssPosVar_m2    = 4.0,
+    .gnssVelVar_m2_s2 = 0.01,
+    .attVar_rad2      = 1e-8,
+};
+
+static const vec3_t rate  = {{1e-3, -2e-3, 5e-4}};
+static const vec3_t accel = {{0.1, 0.0, -0.05}};
+
+static void start(navFilter_t* f, void* mem)
+{
+    testCheck(initNavFilter(f, mem, histDepth, measLen, &cfg) == 0);
+    startNavFilter(f, (vec3_t) {{7.0e6, 0.0, 0.0}}, (vec3_t) {{0.0, 7.5e3, 0.0}}, (quat_t) {{1.0, 0.0, 0.0, 0.0}},
+                   0);
+}
+
+/* IMU steps up to and including step n. */
+static void runImu(navFilter_t* f, unsigned int from, unsigned int n)
+{
+    for (unsigned int k = from; k <= n; k++)
+    {
+        navFilterImu(f, rate, accel, k * imuPeriod_ns);
+    }
+}
+
+/* Same fix, once queued ahead of the state and once after the state passed it by 15 steps. */
+static void testRewind(void)
+{
+    void*       memA = malloc(navFilterBytes(histDepth, measLen));
+    void*       memB = malloc(navFilterBytes(histDepth, measLen));
+    navFilter_t onTime;
+    navFilter_t late;
+    navMeas_t   fix  = {.kind = navMeasGnss};
+    navMeas_t   att  = {.kind = navMeasAttitude};
+
+    start(&onTime, memA);
+    start(&late, memB);
+
+    /* Between the IMU steps at 10 and 11, so the update splits a step. A few metres and microradians off. */
+    runImu(&onTime, 1, 10);
+    fix.gnss.pos_m   = vec3Add(vec3Add(onTime.nav.pos_m, vec3Scale(onTime.nav.vel_m_s, 0.005)),
+                               (vec3_t) {{3.0, -2.0, 1.0}});
+    fix.gnss.vel_m_s = vec3Add(onTime.nav.vel_m_s, (vec3_t) {{0.01, 0.0, -0.01}});
+    att.q_ib         = quatMul(quatFromRotVec((vec3_t) {{2e-5, 0.0, -1e-5}}), onTime.nav.q_ib);
+    testCheck(navFilterMeasure(&onTime, 10 * imuPeriod_ns + 5000000ULL, &fix) == 0);
+    testCheck(navFilterMeasure(&onTime, 12 * imuPeriod_ns, &att) == 0);
+    runImu(&onTime, 11, 40);
+
+    runImu(&late, 1, 25);
+    testCheck(navFilterMeasure(&late, 10 * imuPeriod_ns + 5000000ULL, &fix) == 0);
+    testCheck(navFilterMeasure(&late, 12 * imuPeriod_ns, &att) == 0);
+    runImu(&late, 26, 40);
+
+    testCheck(onTime.numRewinds == 0);
+    testCheck(late.numRewinds == 2);
+    testCheck(late.numReplayed == 15 + 14);
+    testCheck(late.kf.numUpdates == 2);
+    testCheck(late.kf.numRejected == 0);
+    testCheck(memcmp(&onTime.nav, &late.nav, sizeof(navState_t)) == 0);
+    testCheck(memcmp(onTime.kf.P, late.kf.P, sizeof(onTime.kf.P)) == 0);
+    testNear(onTime.errLast_m, late.errLast_m, 0.0);
+
+    /* The fix moved the state, this is not a comparison of two unchanged filters. */
+    testCheck(onTime.errLast_m > 1.0);
+
+    /* Older than the history, refused and counted. */
+    testCheck(navFilterMeasure(&late, 40 * imuPeriod_ns - histDepth * imuPeriod_ns, &fix) == -1);
+    testCheck(late.numLate == 1);
+    free(memA);
+    free(memB);
+}
+
+/* Nothing before the start, non finite samples are rejected, and samples at or before the state ignored. */
+static void testInputs(void)
+{
+    void*       mem = malloc(navFilterBytes(histDepth, measLen));
+    navFilter_t f;
+    navMeas_t   fix = {.kind = navMeasGnss};
+    vec3_t      nan = {{0.0, NAN, 0.0}};
+
+    testCheck(initNavFilter(&f, mem, 0, measLen, &cfg) == -1);
+    testCheck(initNavFilter(&f, mem, histDepth, measLen, &cfg) == 0);
+    testCheck(navFilterMeasure(&f, imuPeriod_ns, &fix) == -1);
+
+    start(&f, mem);
+    navFilterImu(&f, nan, accel, imuPeriod_ns);
+    testCheck(f.numRejected == 1);
+    testCheck(f.nav.time_ns == 0);
+    runImu(&f, 1, 2);
+    navFilterImu(&f, rate, accel, imuPeriod_ns);
+    testCheck(f.nav.time_ns == 2 * imuPeriod_ns);
+    testCheck(f.nav.numSteps == 2);
+    free(mem);
+}
+
+int main(void)
+{
+    testRewind();
+    testInputs();
+    return testDone("navFilterLib");
+}
@@ -0,0 +1,137 @@
+// Behaviour of the work stealing pool: every task exactly once for any split, stealing from slow ranges, stop.
+
+#include <stdlib.h>
+
+#include "poolLib.h"
+#include "testCheck.h"
+#include "threadLib.h"
+
+#define maxTasks 5000U
+
+typedef struct
+{
+    _Atomic uint32_t runs[maxTasks];                //< Times each index ran.
+    uint64_t         slowBelow;                     //< Indices below this take slow_ns.
+    uint64_t         slow_ns;
+    uint64_t         stopAfter;                     //< Stop the pool once this many tasks started, 0 never.
+    atomic_ulong     numStarted;
+    pool_t*          pool;
+} taskCtx_t;
+
+static taskCtx_t ctx;
+
+static void task(void* arg, unsigned int worker, uint64_t index)
+{
+    taskCtx_t* c = (taskCtx_t *) arg;
+
+    (void) worker;
+    atomic_fetch_add(&c->runs[index], 1);
+    if ((c->stopAfter > 0) && (atomic_fetch_add(&c->numStarted, 1) + 1 == c->stopAfter))
+    {
+        stopPool(c->pool);
+    }
+    if (index < c->slowBelow)
+    {
+        uint64_t t0 = getTimeNs();
+
+        while (getTimeNs() - t0 < c->slow_ns)
+        {
+        }
+    }
+}
+
+static void resetCtx(pool_t* pool)
+{
+    for (unsigned int i = 0; i < maxTasks; i++)
+    {
+        atomic_store(&ctx.runs[i], 0);
+    }
+    ctx.slowBelow = 0;
+    ctx.slow_ns   = 0;
+    ctx.stopAfter = 0;
+    atomic_store(&ctx.numStarted, 0);
+    ctx.pool = pool;
+}
+
+/* Counts of indices run other than exactly once, below numTasks, and any run at all above. */
+static unsigned int numWrong(uint64_t numTasks)
+{
+    unsigned int wrong = 0;
+
+    for (unsigned int i = 0; i < maxTasks; i++)
+    {
+        wrong += (atomic_load(&ctx.runs[i]) != ((i < numTasks) ? 1U : 0U));
+    }
+    return wrong;
+}
+
+/* Whether the tasks split evenly over the workers or not, or are fewer than the workers, each runs once. */
+static void testOnce(void)
+{
+    const uint64_t     counts[] = {0, 1, 3, 7, 64, 1000, maxTasks};
+    const unsigned int sizes[]  = {1, 2, 3, 8};
+
+    for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        pool_t pool;
+
+        testCheck(initPool(&pool, sizes[s], 0) == 0);
+        for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+        {
+            resetCtx(&pool);
+            testCheck(runPool(&pool, counts[c], task, &ctx) == counts[c]);
+            testCheck(numWrong(counts[c]) == 0);
+        }
+        closePool(&pool);
+    }
+}
+
+/* The first worker's range is slow, the others finish theirs and take most of it. */
+static void testSteal(void)
+{
+    pool_t   pool;
+    uint64_t steals = 0;
+
+    testCheck(initPool(&pool, 4, 0) == 0);
+    resetCtx(&pool);
+    ctx.slowBelow = 100;
+    ctx.slow_ns   = 50000;
+    testCheck(runPool(&pool, 400, task, &ctx) == 400);
+    testCheck(numWrong(400) == 0);
+    for (unsigned int i = 0; i < pool.numWorkers; i++)
+    {
+        steals += pool.workers[i].numSteals;
+    }
+    testCheck(steals > 0);
+    testCheck(pool.workers[0].numRun < 100);
+    closePool(&pool);
+}
+
+/* Tasks started before the stop finish, none start after, none run twice. */
+static void testStop(void)
+{
+    pool_t   pool;
+    uint64_t total;
+
+    testCheck(initPool(&pool, 4, 0) == 0);
+    resetCtx(&pool);
+    ctx.slowBelow = maxTasks;
+    ctx.slow_ns   = 10000;
+    ctx.stopAfter = 50;
+    total = runPool(&pool, maxTasks, task, &ctx);
+    testCheck(total >= 50);
+    testCheck(total < 50 + pool.numWorkers);
+    for (unsigned int i = 0; i < maxTasks; i++)
+    {
+        testCheck(atomic_load(&ctx.runs[i]) <= 1);
+    }
+    closePool(&pool);
+}
+
+int main(void)
+{
+    testOnce();
+    testSteal();
+    testStop();
+    return testDone("poolLib");
+}
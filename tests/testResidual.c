@@ -0,0 +1,156 @@
+// Behaviour of the residual detectors: when bias, drift and stuck at trip, and that faults stay latched.
+
+#include <math.h>
+#include <string.h>
+
+#include "residualLib.h"
+#include "testCheck.h"
+
+/* 1 sigma, CUSUM k 0.5 h 5, a 10 sample window with a drift limit of 2 sigma, stuck after 10 samples. */
+static const residualCfg_t cfg = {
+    .sigma        = {1.0, 1.0},
+    .cusumSlack   = 0.5,
+    .cusumLimit   = 5.0,
+    .alpha        = 0.1,
+    .driftLimit   = 2.0,
+    .stuckSamples = 10,
+};
+
+/* Same, with the CUSUM out of the way of the drift and stuck checks. */
+static const residualCfg_t noBias = {
+    .sigma        = {1.0, 1.0},
+    .cusumSlack   = 0.5,
+    .cusumLimit   = 1e9,
+    .alpha        = 0.1,
+    .driftLimit   = 2.0,
+    .stuckSamples = 10,
+};
+
+static residualUnit_t unit;
+
+/* Feed value and ref on channel 1, channel 0 on the reference. Returns the bits raised. */
+static uint32_t feed(double value, double ref)
+{
+    const double v[2] = {ref, value};
+    const double r[2] = {ref, ref};
+
+    return updateResidualUnit(&unit, v, r);
+}
+
+/* A 2 sigma bias grows the CUSUM by 1.5 per sample, past 5 on the fourth. */
+static void testBias(void)
+{
+    uint32_t raised;
+
+    testCheck(initResidualUnit(&unit, &cfg, 2) == 0);
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        testCheck(feed(2.0, 0.0) == 0);
+    }
+    raised = feed(2.0, 0.0);
+    testCheck(raised == residualBias);
+    testCheck(unit.faults == residualBias);
+    testCheck(unit.faultChannel == 1);
+
+    /* Latched. Healthy samples raise nothing new and the fault stays. */
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        testCheck(feed(0.0, 0.0) == 0);
+    }
+    testCheck(unit.faults == residualBias);
+
+    /* Negative side. */
+    testCheck(initResidualUnit(&unit, &cfg, 2) == 0);
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        testCheck(feed(-2.0, 0.0) == 0);
+    }
+    testCheck(feed(-2.0, 0.0) == residualBias);
+}
+
+/* Noise within the slack never trips, however long it runs. */
+static void testQuiet(void)
+{
+    testCheck(initResidualUnit(&unit, &cfg, 2) == 0);
+    for (unsigned int i = 0; i < 10000; i++)
+    {
+        feed(0.001 * i + ((i & 1U) ? 0.4 : -0.4), 0.001 * i);
+    }
+    testCheck(unit.faults == 0);
+}
+
+/* A ramp of 0.5 sigma per sample holds the slope at 5 sigma per window, drift after one full window. */
+static void testDrift(void)
+{
+    unsigned int i;
+
+    testCheck(initResidualUnit(&unit, &noBias, 2) == 0);
+    for (i = 0; (i < 100) && (unit.faults == 0); i++)
+    {
+        feed(0.5 * i, 0.001 * i);
+    }
+    testCheck(unit.faults == residualDrift);
+    testCheck(i >= 10);
+    testCheck(i < 20);
+
+    /* A 3 sigma step lifts the slope for a few samples only, shorter than the window. */
+    testCheck(initResidualUnit(&unit, &noBias, 2) == 0);
+    for (i = 0; i < 100; i++)
+    {
+        feed(0.001 * i + ((i < 20) ? 0.0 : 3.0), 0.001 * i);
+    }
+    testCheck(unit.faults == 0);
+}
+
+/* An output that stops moving while the reference does is stuck after stuckSamples unchanged samples. */
+static void testStuck(void)
+{
+    testCheck(initResidualUnit(&unit, &noBias, 2) == 0);
+    /* The first sample has nothing to compare with. */
+    testCheck(feed(0.0, 0.0) == 0);
+    for (unsigned int i = 1; i < noBias.stuckSamples; i++)
+    {
+        testCheck(feed(0.0, 1e-6 * i) == 0);
+    }
+    testCheck(feed(0.0, 1e-6 * noBias.stuckSamples) == residualStuck);
+
+    /* A reference that does not move either is not evidence. */
+    testCheck(initResidualUnit(&unit, &noBias, 2) == 0);
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        feed(1.0, 1.0);
+    }
+    testCheck(unit.faults == 0);
+}
+
+/* Welford statistics of the residual, non finite samples skipped. */
+static void testStats(void)
+{
+    char buf[4];
+
+    testCheck(initResidualUnit(&unit, &noBias, 2) == 0);
+    for (unsigned int i = 1; i <= 4; i++)
+    {
+        feed((double) i, 0.0);
+    }
+    feed(NAN, 0.0);
+    feed(1.0, INFINITY);
+    testCheck(unit.ch[1].n == 4);
+    testNear(unit.ch[1].mean, 2.5, 1e-12);
+    testNear(getResidualStd(&unit.ch[1]), sqrt(5.0 / 3.0), 1e-12);
+
+    testCheck(initResidualUnit(&unit, &noBias, 0) == -1);
+    testCheck(initResidualUnit(&unit, &noBias, residualMaxChannels + 1U) == -1);
+    testCheck(strcmp(residualFaultStr(0, buf), "-") == 0);
+    testCheck(strcmp(residualFaultStr(residualBias | residualStuck, buf), "BS") == 0);
+}
+
+int main(void)
+{
+    testBias();
+    testQuiet();
+    testDrift();
+    testStuck();
+    testStats();
+    return testDone("residualLib");
+}
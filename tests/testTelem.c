@@ -0,0 +1,252 @@
+// Behaviour of the telemetry formats and rings: accepted specs, expansion and truncation, a file read back.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "telemLib.h"
+#include "testCheck.h"
+
+/* Records per logging thread, well inside a ring so none are dropped. */
+#define numLogThreads 3U
+#define numPerThread  1000U
+#define numMainRecs   10U
+
+static int countEvent;
+
+/* Formatted record of one event, through a buffer of the given size. */
+static int format(const char* fmt, uint64_t a0, uint64_t a1, char* buf, size_t size)
+{
+    telemEventDef_t def = {0};
+    telemRec_t      rec = {.arg = {a0, a1}};
+
+    snprintf(def.fmt, sizeof(def.fmt), "%s", fmt);
+    return formatTelemRec(&def, &rec, buf, size);
+}
+
+/* Expanded in a large buffer, equal to want and with its length returned. */
+static int formatsAs(const char* fmt, uint64_t a0, uint64_t a1, const char* want)
+{
+    char buf[128];
+    int  len = format(fmt, a0, a1, buf, sizeof(buf));
+
+    if ((len != (int) strlen(want)) || (strcmp(buf, want) != 0))
+    {
+        fprintf(stderr, "\"%s\" gave \"%s\" (%d), expected \"%s\" \n", fmt, buf, len, want);
+        return 0;
+    }
+    return 1;
+}
+
+/* Conversions counted, %% not one of them, and what the header allows and no more. */
+static void testCheckFmt(void)
+{
+    testCheck(checkTelemFmt("") == 0);
+    testCheck(checkTelemFmt("no conversions") == 0);
+    testCheck(checkTelemFmt("100%% done") == 0);
+    testCheck(checkTelemFmt("%%%d%%") == 1);
+    testCheck(checkTelemFmt("%d of %u") == 2);
+    testCheck(checkTelemFmt("%-+08.3f %#x") == 2);
+    testCheck(checkTelemFmt("%lu %lld") == 2);
+    testCheck(checkTelemFmt("%hhd %zu") == 2);
+    testCheck(checkTelemFmt("%jX") == 1);
+
+    /* More than telemMaxArgs, strings, pointers, a bare or trailing '%'. */
+    testCheck(checkTelemFmt("%d %d %d") == -1);
+    testCheck(checkTelemFmt("%s") == -1);
+    testCheck(checkTelemFmt("%p") == -1);
+    testCheck(checkTelemFmt("%") == -1);
+    testCheck(checkTelemFmt("left %5") == -1);
+
+    /* Flags, width and precision fit in telemSpecLen with the length modifier, longer specs are refused. */
+    testCheck(checkTelemFmt("%12345678901d") == 1);
+    testCheck(checkTelemFmt("%123456789012d") == -1);
+    testCheck(checkTelemFmt("%-+ #0-+ #0-+ #0d") == -1);
+    testCheck(checkTelemFmt("%.00000000000000001f") == -1);
+}
+
+static void testFormat(void)
+{
+    char buf[16];
+
+    testCheck(formatsAs("plain", 1, 2, "plain"));
+    testCheck(formatsAs("%d and %u", (uint64_t) -5, 7, "-5 and 7"));
+    testCheck(formatsAs("%u", (uint64_t) -1, 0, "18446744073709551615"));
+    testCheck(formatsAs("%x %o", 255, 8, "ff 10"));
+    testCheck(formatsAs("%#X|%5d|%-4i|", 255, 42, "0XFF|   42|"));
+    testCheck(formatsAs("%05d", (uint64_t) -42, 0, "-0042"));
+
+    /* Doubles, their flags, width and precision. */
+    testCheck(formatsAs("%.3f", telemF64(1.5), 0, "1.500"));
+    testCheck(formatsAs("%+9.2e|%g", telemF64(-1234.5), telemF64(0.25), "-1.23e+03|0.25"));
+    testCheck(formatsAs("%08.2f", telemF64(3.14159), 0, "00003.14"));
+
+    /* %% is a literal anywhere, length modifiers change nothing. */
+    testCheck(formatsAs("%%%d%%", 9, 0, "%9%"));
+    testCheck(formatsAs("100%%", 0, 0, "100%"));
+    testCheck(formatsAs("%lu %hhd", 300, (uint64_t) -1, "300 -1"));
+
+    /* Expansion stops at a conversion that is not allowed, or one past the arguments. */
+    testCheck(formatsAs("a %s b", 0, 0, "a "));
+    testCheck(formatsAs("%d %d %d", 1, 2, "1 2 "));
+
+    /* Truncated as snprintf: the full length returned, what fits terminated. */
+    testCheck(format("value %d!", 12345, 0, buf, 8) == 12);
+    testCheck(strcmp(buf, "value 1") == 0);
+    testCheck(format("%.3f end", telemF64(2.0), 0, buf, 6) == 9);
+    testCheck(strcmp(buf, "2.000") == 0);
+    testCheck(format("abc%%", 0, 0, buf, 4) == 4);
+    testCheck(strcmp(buf, "abc") == 0);
+    testCheck(format("%u", 123, 0, buf, 1) == 3);
+    testCheck(buf[0] == '\0');
+    buf[0] = 'x';
+    testCheck(format("%u", 123, 0, buf, 0) == 3);
+    testCheck(buf[0] == 'x');
+}
+
+static void* logThread(void* arg)
+{
+    uint64_t k = (uint64_t) (uintptr_t) arg;
+
+    for (uint64_t i = 0; i < numPerThread; i++)
+    {
+        telemLog(countEvent, i, k);
+    }
+    return NULL;
+}
+
+/* Records from several threads to a file. Every record read back, in ring order, after its event. */
+static void testRing(const char* decoder)
+{
+    char           dir[]  = "/tmp/testTelemXXXXXX";
+    char           path[sizeof(dir) + 16];
+    pthread_t      thr[numLogThreads];
+    telemFileHdr_t hdr;
+    telemChunk_t   chunk;
+    uint32_t       nextSeq[telemMaxRings] = {0};
+    uint8_t        known[telemMaxEvents]  = {0};
+    unsigned int   numRecs  = 0;
+    unsigned int   numWrong = 0;
+    uint64_t       prev_ns;
+    int            valueEvent;
+    FILE*          fp;
+
+    testCheck(mkdtemp(dir) != NULL);
+    setenv("TEC_TELEM_DIR", dir, 1);
+    testCheck(openTelem("testTelem") == 0);
+    countEvent = telemEvent("count", "step %u of thread %u");
+    valueEvent = telemEvent("value", "x=%.3f 100%%");
+    testCheck((countEvent >= 0) && (valueEvent >= 0) && (countEvent != valueEvent));
+    testCheck(telemEvent("count", "step %u of thread %u") == countEvent);
+    testCheck(telemEvent("bad", "%s") == -1);
+
+    for (unsigned int k = 0; k < numLogThreads; k++)
+    {
+        testCheck(pthread_create(&thr[k], NULL, logThread, (void *) (uintptr_t) k) == 0);
+    }
+    for (unsigned int i = 0; i < numMainRecs; i++)
+    {
+        telemLog(valueEvent, telemF64(0.5 * i), 0);
+    }
+    for (unsigned int k = 0; k < numLogThreads; k++)
+    {
+        pthread_join(thr[k], NULL);
+    }
+    closeTelem();
+    /* Closed, logging does nothing. */
+    telemLog(valueEvent, 0, 0);
+
+    snprintf(path, sizeof(path), "%s/testTelem.tlm", dir);
+    fp = fopen(path, "rb");
+    testCheck(fp != NULL);
+    if (fp == NULL)
+    {
+        return;
+    }
+    testCheck(fread(&hdr, sizeof(hdr), 1, fp) == 1);
+    testCheck(memcmp(hdr.magic, telemMagic, sizeof(hdr.magic)) == 0);
+    testCheck(hdr.version == telemVersion);
+    testCheck(hdr.recSize == sizeof(telemRec_t));
+    while (fread(&chunk, sizeof(chunk), 1, fp) == 1)
+    {
+        if (chunk.kind == telemChunkEvent)
+        {
+            telemEventDef_t def;
+
+            testCheck(chunk.size == sizeof(def));
+            testCheck(fread(&def, sizeof(def), 1, fp) == 1);
+            testCheck(def.id < telemMaxEvents);
+            known[def.id % telemMaxEvents] = 1;
+            continue;
+        }
+        testCheck(chunk.kind == telemChunkRecords);
+        testCheck((chunk.size > 0) && ((chunk.size % sizeof(telemRec_t)) == 0));
+        prev_ns = 0;
+        for (size_t left = chunk.size / sizeof(telemRec_t); left > 0; left--)
+        {
+            telemRec_t rec;
+
+            if (fread(&rec, sizeof(rec), 1, fp) != 1)
+            {
+                numWrong++;
+                break;
+            }
+            /* Merged by time within a chunk, consecutive within a ring, and no event before its definition. */
+            numWrong += (rec.time_ns < prev_ns);
+            numWrong += (rec.ring >= telemMaxRings) || (rec.seq != nextSeq[rec.ring % telemMaxRings]);
+            numWrong += (rec.event >= telemMaxEvents) || (known[rec.event % telemMaxEvents] == 0);
+            numWrong += (rec.event == countEvent) && ((rec.arg[0] != rec.seq) || (rec.arg[1] >= numLogThreads));
+            nextSeq[rec.ring % telemMaxRings] = rec.seq + 1;
+            prev_ns = rec.time_ns;
+            numRecs++;
+        }
+    }
+    fclose(fp);
+    testCheck(numWrong == 0);
+    testCheck(numRecs == numLogThreads * numPerThread + numMainRecs);
+
+    /* The decoder expands the same file. */
+    if (decoder != NULL)
+    {
+        char         cmd[512];
+        char         line[256];
+        unsigned int numCount = 0;
+        unsigned int numValue = 0;
+        unsigned int numLines = 0;
+
+        snprintf(cmd, sizeof(cmd), "%s -c %s 2>/dev/null", decoder, path);
+        fp = popen(cmd, "r");
+        testCheck(fp != NULL);
+        while ((fp != NULL) && (fgets(line, sizeof(line), fp) != NULL))
+        {
+            numLines++;
+            numCount += (strstr(line, ",count,\"step ") != NULL);
+            numValue += (strstr(line, ",value,\"x=") != NULL) && (strstr(line, " 100%\"") != NULL);
+        }
+        testCheck((fp != NULL) && (pclose(fp) == 0));
+        testCheck(numLines == 1 + numRecs);
+        testCheck(numCount == numLogThreads * numPerThread);
+        testCheck(numValue == numMainRecs);
+
+        snprintf(cmd, sizeof(cmd), "%s %s 2>/dev/null | grep -c 'x=4.500 100%%$'", decoder, path);
+        fp = popen(cmd, "r");
+        testCheck((fp != NULL) && (fgets(line, sizeof(line), fp) != NULL) && (strcmp(line, "1\n") == 0));
+        if (fp != NULL)
+        {
+            pclose(fp);
+        }
+    }
+    unlink(path);
+    rmdir(dir);
+}
+
+int main(int argc, char* argv[])
+{
+    testCheckFmt();
+    testFormat();
+    /* Given the TelemDecode binary, the file also goes through it. */
+    testRing((argc > 1) ? argv[1] : NULL);
+    return testDone("telemLib");
+}
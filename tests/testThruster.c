@@ -0,0 +1,178 @@
+// Behaviour of the thruster allocation: NNLS columns that reproduce each unit axis, allocation into the limits.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "thrusterLib.h"
+#include "testCheck.h"
+
+static thrAlloc_t alloc;
+
+/*
+ * Four thrusters per axis a, 1 m out along the next axis b, firing along +a or -a. Their torques are about
+ * the third axis, so every force and torque axis is reachable both ways. Without the last -x thruster the
+ * -x force and -z torque are not.
+ */
+static void addCube(thrAlloc_t* a, int withoutLast)
+{
+    memset(a, 0, sizeof(*a));
+    for (unsigned int ax = 0; ax < 3; ax++)
+    {
+        for (unsigned int k = 0; k < 4; k++)
+        {
+            thruster_t* t = &a->thr[a->numThr];
+
+            if ((withoutLast == 1) && (ax == 0) && (k == 3))
+            {
+                continue;
+            }
+            memset(t, 0, sizeof(*t));
+            t->pos_m.v[(ax + 1) % 3] = (k & 1U) ? -1.0 : 1.0;
+            t->dir.v[ax]             = (k & 2U) ? -1.0 : 1.0;
+            t->maxForce_N            = 10.0;
+            a->numThr++;
+        }
+    }
+}
+
+/* Wrench of the thruster forces. */
+static void wrenchOf(const thrAlloc_t* a, const double* force, double* wrench)
+{
+    memset(wrench, 0, sizeof(double) * thrWrenchDim);
+    for (unsigned int i = 0; i < a->numThr; i++)
+    {
+        vec3_t tq = vec3Cross(a->thr[i].pos_m, a->thr[i].dir);
+
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            wrench[k]     += force[i] * a->thr[i].dir.v[k];
+            wrench[3 + k] += force[i] * tq.v[k];
+        }
+    }
+}
+
+/* Every table column is non negative and its forces give exactly its signed unit axis. */
+static void testColumns(void)
+{
+    addCube(&alloc, 0);
+    testCheck(initThrusterAlloc(&alloc) == 0);
+    testCheck(alloc.complete == 1);
+    for (unsigned int c = 0; c < 2 * thrWrenchDim; c++)
+    {
+        double wrench[thrWrenchDim];
+
+        for (unsigned int i = 0; i < alloc.numThr; i++)
+        {
+            testCheck(alloc.unit[c][i] >= 0.0);
+        }
+        wrenchOf(&alloc, alloc.unit[c], wrench);
+        for (unsigned int w = 0; w < thrWrenchDim; w++)
+        {
+            double want = (w == c % thrWrenchDim) ? ((c < thrWrenchDim) ? 1.0 : -1.0) : 0.0;
+
+            testNear(wrench[w], want, 1e-9);
+        }
+    }
+}
+
+/* Within the limits the duties give the command back, beyond them the same direction at full duty. */
+static void testAllocate(void)
+{
+    const double small[thrWrenchDim] = {1.0, -2.0, 0.5, 0.3, -0.1, 2.0};
+    double       big[thrWrenchDim];
+    double       duty[thrMaxThrusters];
+    double       force[thrMaxThrusters];
+    double       wrench[thrWrenchDim];
+    double       peak = 0.0;
+
+    addCube(&alloc, 0);
+    testCheck(initThrusterAlloc(&alloc) == 0);
+    allocateThrusters(&alloc, small, duty);
+    for (unsigned int i = 0; i < alloc.numThr; i++)
+    {
+        testCheck((duty[i] >= 0.0) && (duty[i] <= 1.0));
+        force[i] = duty[i] * alloc.thr[i].maxForce_N;
+    }
+    wrenchOf(&alloc, force, wrench);
+    for (unsigned int w = 0; w < thrWrenchDim; w++)
+    {
+        testNear(wrench[w], small[w], 1e-9);
+        big[w] = 100.0 * small[w];
+    }
+
+    allocateThrusters(&alloc, big, duty);
+    for (unsigned int i = 0; i < alloc.numThr; i++)
+    {
+        peak     = (duty[i] > peak) ? duty[i] : peak;
+        force[i] = duty[i] * alloc.thr[i].maxForce_N;
+    }
+    testNear(peak, 1.0, 1e-12);
+    wrenchOf(&alloc, force, wrench);
+    for (unsigned int w = 0; w < thrWrenchDim; w++)
+    {
+        testNear(wrench[w] * big[1], wrench[1] * big[w], 1e-9);
+    }
+
+    /* Pulses shorter than the minimum are not fired. */
+    alloc.minDuty = 0.5;
+    allocateThrusters(&alloc, small, duty);
+    for (unsigned int i = 0; i < alloc.numThr; i++)
+    {
+        testCheck(duty[i] == 0.0);
+    }
+}
+
+/* Axes reachable one way only leave the table incomplete, thrusters that miss an axis entirely are refused. */
+static void testIncomplete(void)
+{
+    addCube(&alloc, 1);
+    testCheck(initThrusterAlloc(&alloc) == 0);
+    testCheck(alloc.complete == 0);
+
+    memset(&alloc, 0, sizeof(alloc));
+    alloc.thr[0] = (thruster_t) {.pos_m = {{0.0, 1.0, 0.0}}, .dir = {{1.0, 0.0, 0.0}}, .maxForce_N = 1.0};
+    alloc.thr[1] = (thruster_t) {.pos_m = {{0.0, -1.0, 0.0}}, .dir = {{-1.0, 0.0, 0.0}}, .maxForce_N = 1.0};
+    alloc.numThr = 2;
+    testCheck(initThrusterAlloc(&alloc) == -1);
+}
+
+/* Comments, blank lines and normalised directions, then a bad line named and refused. */
+static void testLoad(void)
+{
+    char  path[] = "/tmp/testThrusterXXXXXX";
+    int   fd     = mkstemp(path);
+    FILE* fp;
+
+    testCheck(fd != -1);
+    if (fd == -1)
+    {
+        return;
+    }
+    fp = fdopen(fd, "w");
+    fprintf(fp, "# x y z dirX dirY dirZ maxForce\n\n0 1 0  2 0 0  10 # scaled\n0 -1 0  -1 0 0  5\n");
+    fclose(fp);
+
+    memset(&alloc, 0, sizeof(alloc));
+    testCheck(loadThrusterGeometry(&alloc, path) == 0);
+    testCheck(alloc.numThr == 2);
+    testNear(alloc.thr[0].dir.v[0], 1.0, 0.0);
+    testNear(alloc.thr[1].maxForce_N, 5.0, 0.0);
+
+    fp = fopen(path, "w");
+    fprintf(fp, "0 1 0  0 0 0  10\n");
+    fclose(fp);
+    memset(&alloc, 0, sizeof(alloc));
+    testCheck(loadThrusterGeometry(&alloc, path) == -1);
+    unlink(path);
+}
+
+int main(void)
+{
+    testColumns();
+    testAllocate();
+    testIncomplete();
+    testLoad();
+    return testDone("thrusterLib");
+}
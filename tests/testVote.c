@@ -0,0 +1,123 @@
+// Behaviour of the mid value vote: median per channel for any unit count, miscompares and the best unit.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "voteLib.h"
+#include "testCheck.h"
+
+static voteFrame_t frame;
+
+static uint64_t testRng = 1;
+
+/* Uniform in [-1, 1), splitmix64. */
+static double testUniform(void)
+{
+    uint64_t z = (testRng += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (double) (z >> 11) * 0x1.0p-52 - 1.0;
+}
+
+static int cmpDouble(const void* a, const void* b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+/* Median of n values, the mean of the middle two for even n. */
+static double refMedian(double* v, unsigned int n)
+{
+    qsort(v, n, sizeof(double), cmpDouble);
+    return 0.5 * (v[(n - 1) / 2] + v[n / 2]);
+}
+
+/* Every unit count, the compare networks up to 4 units and the sort above, against a sorted reference. */
+static void testMedian(void)
+{
+    const double tol[6] = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+
+    testCheck(initVoteFrame(&frame, 6, tol) == 0);
+    for (unsigned int n = 1; n <= voteMaxUnits; n++)
+    {
+        for (unsigned int trial = 0; trial < 20; trial++)
+        {
+            double col[6][voteMaxUnits];
+
+            for (unsigned int u = 0; u < n; u++)
+            {
+                double val[6];
+
+                for (unsigned int k = 0; k < 6; k++)
+                {
+                    val[k]    = testUniform();
+                    col[k][u] = val[k];
+                }
+                setVoteInput(&frame, u, 0, val, 6);
+            }
+            voteMidValue(&frame, n);
+            testCheck(frame.numUnits == n);
+            for (unsigned int k = 0; k < 6; k++)
+            {
+                testNear(frame.mid[k], refMedian(col[k], n), 1e-15);
+            }
+        }
+    }
+}
+
+/* One unit off by more than its tolerance in one channel is the only one flagged, and never the best. */
+static void testMiscompare(void)
+{
+    const double tol[2] = {0.1, 1.0};
+    const double good[3][2] = {{1.00, 5.0}, {1.02, 5.3}, {0.99, 4.8}};
+    const double bad[2]     = {1.00, 7.5};
+    uint32_t     mask;
+
+    testCheck(initVoteFrame(&frame, 2, tol) == 0);
+    for (unsigned int u = 0; u < 3; u++)
+    {
+        setVoteInput(&frame, u, 0, good[u], 2);
+    }
+    setVoteInput(&frame, 3, 0, bad, 2);
+    mask = voteMidValue(&frame, 4);
+    testCheck(mask == (1U << 3));
+    testNear(frame.maxDev[3], bad[1] - 0.5 * (5.0 + 5.3), 1e-12);
+    testCheck(voteBestUnit(&frame) != 3);
+
+    /* Within tolerance everywhere, nothing flagged and the unit on the vote is the best. */
+    mask = voteMidValue(&frame, 3);
+    testCheck(mask == 0);
+    testCheck(voteBestUnit(&frame) == 0);
+    testNear(frame.maxDev[0], 0.0, 1e-12);
+
+    /* Two units cannot tell which one is wrong, both are flagged. */
+    setVoteInput(&frame, 1, 0, bad, 2);
+    mask = voteMidValue(&frame, 2);
+    testCheck(mask == 0x3U);
+    testNear(frame.mid[1], 0.5 * (5.0 + bad[1]), 1e-12);
+}
+
+/* Bad tolerances and channel counts are refused. */
+static void testInit(void)
+{
+    const double tol[voteLanes + 1] = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+    const double zero[1]            = {0.0};
+
+    testCheck(initVoteFrame(&frame, 0, tol) == -1);
+    testCheck(initVoteFrame(&frame, voteLanes + 1, tol) == -1);
+    testCheck(initVoteFrame(&frame, 1, zero) == -1);
+    testCheck(initVoteFrame(&frame, voteLanes, tol) == 0);
+    testCheck(voteMidValue(&frame, 0) == 0);
+}
+
+int main(void)
+{
+    testMedian();
+    testMiscompare();
+    testInit();
+    return testDone("voteLib");
+}